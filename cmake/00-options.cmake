@@ -6,3 +6,5 @@ option(ENABLE_UBSAN "Enable UBSAN" OFF)
 option(ENABLE_TSAN  "Enable TSAN" OFF)
 option(EXPORT_COMPILE "Export compile database" OFF)
 option(BUILD_TESTING "Build tests" ON)
+set(THPOOL_LOCK "pthread" CACHE STRING "thpool queue lock (pthread, lmutex, ticket, mcs)")
+set_property(CACHE THPOOL_LOCK PROPERTY STRINGS pthread lmutex ticket mcs)
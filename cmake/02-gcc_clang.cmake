@@ -16,7 +16,6 @@ if(CMAKE_COMPILER_IS_GNU OR CMAKE_COMPILER_IS_CLANG)
 			-W
 			-Wpedantic
 			-Wconversion
-			-Wdeclaration-after-statement
 			-Wwrite-strings
 		)
 
@@ -0,0 +1,119 @@
+#ifndef _THREADS_ARENA_H_
+#define _THREADS_ARENA_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Bump-pointer arena (single thread) for short-lived temporaries.
+ * Allocation is a pointer increment, objects are not freed separately: arena_reset rewind
+ * arena to first chunk (chunks are kept for reuse), arena_shrink free all chunks except first.
+ * Pool workers have own arena (pool_current_arena), which is reset after each task.
+ */
+
+#define ARENA_INLINE static inline
+
+/* allocation alignment */
+#define ARENA_ALIGN 16
+
+/* default chunk size */
+#define ARENA_CHUNK_SIZE 65536
+
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	char *end;
+} arena_chunk_t;
+
+/* chunk header size (data is aligned) */
+#define ARENA_CHUNK_HDR ((sizeof(arena_chunk_t) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+/**
+ * @brief   Arena
+ * @typedef arena_t
+ */
+typedef struct arena {
+	char *pos; /* free space in current chunk */
+	char *end;
+	arena_chunk_t *chunk; /* current chunk */
+	arena_chunk_t *first;
+	size_t chunk_size;
+} arena_t;
+
+/**
+ * @brief             Init arena (chunks are allocated on demand)
+ * @param  a          Arena
+ * @param  chunk_size Chunk size (if 0, ARENA_CHUNK_SIZE is used)
+ */
+void arena_init(arena_t *a, size_t chunk_size);
+
+/**
+ * @brief       Destroy arena (free all chunks)
+ * @param  a    Arena
+ */
+void arena_destroy(arena_t *a);
+
+void *arena_alloc_slow(arena_t *a, size_t size);
+
+/**
+ * @brief       Allocate memory (aligned to ARENA_ALIGN)
+ * @param  a    Arena
+ * @param  size Size
+ * @retval      Pointer or NULL, if memory allocation failed (errno is ENOMEM)
+ */
+ARENA_INLINE void *arena_alloc(arena_t *a, size_t size) {
+	char *p = a->pos;
+	if (size > SIZE_MAX - (ARENA_ALIGN - 1)) {
+		/* aligned size overflow */
+		errno = ENOMEM;
+		return NULL;
+	}
+	size = size ? (size + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1) : ARENA_ALIGN;
+	if ((size_t) (a->end - p) >= size) {
+		a->pos = p + size;
+		return p;
+	}
+	return arena_alloc_slow(a, size);
+}
+
+/**
+ * @brief       Free all allocations, chunks are kept for reuse
+ * @param  a    Arena
+ */
+ARENA_INLINE void arena_reset(arena_t *a) {
+	if (a->first) {
+		a->chunk = a->first;
+		a->pos = (char *) a->first + ARENA_CHUNK_HDR;
+		a->end = a->first->end;
+	}
+}
+
+/**
+ * @brief       Check if memory beyond first chunk (with default size) is used (since last reset)
+ * @param  a    Arena
+ */
+ARENA_INLINE int arena_grown(const arena_t *a) {
+	return a->chunk != a->first || (a->first && (size_t) (a->first->end - (char *) a->first) > ARENA_CHUNK_HDR + a->chunk_size);
+}
+
+/**
+ * @brief       Free all allocations and all chunks except first (with default size)
+ * @param  a    Arena
+ */
+void arena_shrink(arena_t *a);
+
+/**
+ * @brief       Total size of chunks
+ * @param  a    Arena
+ */
+size_t arena_size(const arena_t *a);
+
+#undef ARENA_INLINE
+
+#endif /* _THREADS_ARENA_H_ */
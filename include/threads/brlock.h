@@ -0,0 +1,85 @@
+#ifndef _THREADS_BRLOCK_H_
+#define _THREADS_BRLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Sharded "big reader" lock: readers touch only own (cache line padded) slot,
+ * writer set writer flag and wait for all slots drain. Use it for read-mostly data.
+ */
+
+#define BRLOCK_INLINE static inline
+
+#define BRLOCK_CACHE_LINE 64
+
+/**
+ * @brief   Reader slot (one per cache line)
+ * @typedef brlock_slot_t
+ */
+typedef struct brlock_slot {
+	uint32_t readers;
+	char pad[BRLOCK_CACHE_LINE - sizeof(uint32_t)];
+} brlock_slot_t;
+
+/**
+ * @brief   Big reader lock
+ * @typedef brlock_t
+ */
+typedef struct brlock {
+	uint32_t writer; /* 0 - unlocked, 1 - writer holds lock, 2 - writer holds lock and others wait */
+	size_t nslots;
+	brlock_slot_t *slots;
+} brlock_t;
+
+/**
+ * @brief         Init big reader lock
+ * @param  l      Lock
+ * @param  nslots Reader slots count (if < 1, hostcpu count is used)
+ * @retval        0 - on success, -1 - on error (error code stored in errno)
+ */
+int brlock_init(brlock_t *l, size_t nslots);
+
+/**
+ * @brief       Destroy big reader lock
+ * @param  l    Lock
+ */
+void brlock_destroy(brlock_t *l);
+
+/**
+ * @brief       Lock for read
+ * @param  l    Lock
+ * @retval      Reader slot index (pass to brlock_rdunlock)
+ */
+size_t brlock_rdlock(brlock_t *l);
+
+/**
+ * @brief       Unlock after read
+ * @param  l    Lock
+ * @param  slot Reader slot index, returned by brlock_rdlock
+ */
+BRLOCK_INLINE void brlock_rdunlock(brlock_t *l, size_t slot) {
+	__atomic_sub_fetch(&l->slots[slot].readers, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief       Lock for write (wait for all readers)
+ * @param  l    Lock
+ */
+void brlock_wrlock(brlock_t *l);
+
+/**
+ * @brief       Unlock after write
+ * @param  l    Lock
+ */
+void brlock_wrunlock(brlock_t *l);
+
+#undef BRLOCK_INLINE
+
+#endif /* _THREADS_BRLOCK_H_ */
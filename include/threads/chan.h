@@ -0,0 +1,172 @@
+#ifndef _THREADS_CHAN_H_
+#define _THREADS_CHAN_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Bounded Go-style channel for fixed size messages.
+ *
+ * Buffered channel is a lock-free ring (per-slot sequence numbers), so send/recv don't lock,
+ * when buffer is neither full nor empty. Blocked senders/receivers sleep on futex (eventcount).
+ *
+ * Unbuffered channel (capacity is 0) is a rendezvous: send return 0, when receiver got message.
+ * If timeout is expired or channel is closed before, message is withdrawn (no receiver get it) and send fail.
+ * Nonblocking send (chan_try_send or chan_select) to unbuffered channel succeeded only if receiver waits,
+ * message is delivered to the next receiver.
+ */
+
+/**
+ * @typedef chan_t
+ * @brief   Channel
+ */
+typedef struct chan* chan_t;
+
+/**
+ * @brief  Select case operation
+ */
+typedef enum {
+	CHAN_SEND = 0,
+	CHAN_RECV = 1
+} chan_op_t;
+
+/**
+ * @brief   Select case
+ * @typedef chan_case_t
+ */
+typedef struct chan_case {
+	chan_t ch;
+	chan_op_t op;
+	void *data; /* message for send or buffer for receive */
+	int err; /* 0 - on success, EPIPE - channel is closed (set for completed case) */
+} chan_case_t;
+
+/**
+ * @brief  Create channel
+ * @param  elem_size  Message size
+ * @param  capacity   Buffer capacity (0 - unbuffered channel)
+ * @retval            Returns a pointer to channel on success or NULL on error (error code stored in errno).
+ */
+chan_t chan_create(size_t elem_size, size_t capacity);
+
+/**
+ * @brief  Destroy channel (no one must use channel)
+ * @param  ch    Channel
+ */
+void chan_destroy(chan_t ch);
+
+/**
+ * @brief  Close channel (wake all waiters, send to closed channel fail, receive drain buffered messages)
+ * @param  ch    Channel
+ */
+void chan_close(chan_t ch);
+
+/**
+ * @brief  Check if channel is closed
+ * @param  ch    Channel
+ */
+int chan_is_closed(chan_t ch);
+
+/**
+ * @brief  Buffer capacity
+ * @param  ch    Channel
+ */
+size_t chan_cap(chan_t ch);
+
+/**
+ * @brief  Count of buffered messages (approximate under concurrent access)
+ * @param  ch    Channel
+ */
+size_t chan_len(chan_t ch);
+
+/**
+ * @brief  Send message (wait while buffer is full)
+ *
+ * For unbuffered channel wait for receiver, if channel is closed before receiver got message, message is withdrawn.
+ * @param  ch    Channel
+ * @param  data  Message (elem_size bytes)
+ * @retval       0 - on success, -1 - on error (errno is EPIPE, if channel is closed)
+ */
+int chan_send(chan_t ch, const void *data);
+
+/**
+ * @brief  Send message without wait
+ * @param  ch    Channel
+ * @param  data  Message (elem_size bytes)
+ * @retval       0 - on success, -1 - on error (errno is EAGAIN, if buffer is full, EPIPE, if channel is closed)
+ */
+int chan_try_send(chan_t ch, const void *data);
+
+/**
+ * @brief  Send message with timeout
+ *
+ * For unbuffered channel timeout also limit wait for receiver after message is queued.
+ * On timeout message is withdrawn, so 0 is returned only if receiver got message.
+ * @param  ch    Channel
+ * @param  data  Message (elem_size bytes)
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval       0 - on success (message is delivered), -1 - on error (errno is ETIMEDOUT, if buffer is full
+ *               or no receiver got message, EPIPE, if channel is closed)
+ */
+int chan_timed_send(chan_t ch, const void *data, uint64_t timeout_usecs);
+
+/**
+ * @brief  Receive message (wait while buffer is empty)
+ * @param  ch    Channel
+ * @param  data  Buffer for message (elem_size bytes)
+ * @retval       0 - on success, -1 - on error (errno is EPIPE, if channel is closed and drained)
+ */
+int chan_recv(chan_t ch, void *data);
+
+/**
+ * @brief  Receive message without wait
+ * @param  ch    Channel
+ * @param  data  Buffer for message (elem_size bytes)
+ * @retval       0 - on success, -1 - on error (errno is EAGAIN, if buffer is empty, EPIPE, if channel is closed and drained)
+ */
+int chan_try_recv(chan_t ch, void *data);
+
+/**
+ * @brief  Receive message with timeout
+ * @param  ch    Channel
+ * @param  data  Buffer for message (elem_size bytes)
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval       0 - on success, -1 - on error (errno is ETIMEDOUT, if buffer is empty, EPIPE, if channel is closed and drained)
+ */
+int chan_timed_recv(chan_t ch, void *data, uint64_t timeout_usecs);
+
+/**
+ * @brief  Wait until one of cases can be completed and complete it (ready cases are checked from random start)
+ * 
+ * Operation on closed channel is completed with case err EPIPE.
+ * @param  cases Cases
+ * @param  n     Cases count
+ * @param  block Wait, if no case is ready
+ * @retval       Index of completed case, -1 - on error (errno is EAGAIN, if no case is ready and block is 0)
+ */
+int chan_select(chan_case_t *cases, size_t n, int block);
+
+/**
+ * @brief  Wait until one of cases can be completed with timeout
+ * @param  cases Cases
+ * @param  n     Cases count
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval       Index of completed case, -1 - on error (errno is ETIMEDOUT)
+ */
+int chan_timed_select(chan_case_t *cases, size_t n, uint64_t timeout_usecs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_CHAN_H_ */
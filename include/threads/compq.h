@@ -0,0 +1,91 @@
+#ifndef _THREADS_COMPQ_H_
+#define _THREADS_COMPQ_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <threads/executor.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Completion queue for event loops (epoll, io_uring): task is run by executor, completion (tag and result)
+ * is pushed to lock-free MPSC queue and pollable fd (eventfd on Linux, pipe on others) is signaled.
+ * Signals are coalesced: fd is written once until compq_poll, so loop never block in pool wait and
+ * collect results in batches.
+ */
+
+/**
+ * @typedef compq_t
+ * @brief   Completion queue
+ */
+typedef struct compq* compq_t;
+
+/**
+ * @brief   Completion
+ * @typedef compq_entry_t
+ */
+typedef struct compq_entry {
+	uint64_t tag; /* submit tag */
+	intptr_t result; /* task result */
+} compq_entry_t;
+
+/**
+ * @brief  Create completion queue
+ * @param  capacity  Preallocated completion records (> 0, if exhausted, records are allocated with malloc)
+ * @retval           Returns a pointer to completion queue on success or NULL on error (error code stored in errno).
+ */
+compq_t compq_create(size_t capacity);
+
+/**
+ * @brief  Pollable fd (readable, when completions are queued), don't read it directly
+ * @param  cq        Completion queue
+ */
+int compq_fd(compq_t cq);
+
+/**
+ * @brief  Submit task, completion is queued, when task is done (executor can be thpool, lfthpool, inline or caller-runs)
+ * @param  cq        Completion queue
+ * @param  ex        Executor
+ * @param  function  Function/task, returns result
+ * @param  arg       Argument
+ * @param  tag       Tag (returned in completion)
+ * @retval           Returns 0 on success or -1 on error (errno is EAGAIN, if executor queue is full).
+ */
+int compq_submit(compq_t cq, executor_t ex, intptr_t (*function)(void *), void *arg, uint64_t tag);
+
+/**
+ * @brief  Dequeue completions without blocking (single consumer, usually event loop thread, when fd is readable).
+ *         If more completions are queued, fd is left readable.
+ * @param  cq        Completion queue
+ * @param  entries   Completions (output)
+ * @param  max       Entries size
+ * @retval           Returns count of completions.
+ */
+size_t compq_poll(compq_t cq, compq_entry_t *entries, size_t max);
+
+/**
+ * @brief  Count of submitted tasks, which completions are not polled
+ * @param  cq        Completion queue
+ */
+size_t compq_pending(compq_t cq);
+
+/**
+ * @brief  Destroy completion queue (wait executor before, queued completions are dropped)
+ * @param  cq        Completion queue
+ */
+void compq_destroy(compq_t cq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_COMPQ_H_ */
@@ -0,0 +1,153 @@
+#ifndef _THREADS_DISRUPTOR_H_
+#define _THREADS_DISRUPTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Disruptor-style broadcast ring: entries are written once and read in place by all consumers.
+ * Every consumer tracks own sequence and can gate on other consumers (dependency chains).
+ * Producer is gated by the slowest consumer. Waiters spin a little and then sleep on futex (eventcount).
+ *
+ * Producer:
+ *   seq = disruptor_claim(d, 1);
+ *   fill(disruptor_entry(d, seq));
+ *   disruptor_publish(d, seq, 1);
+ *
+ * Consumer:
+ *   while ((n = disruptor_consume_wait(d, c, &seq)) > 0) {
+ *       for (i = 0; i < n; i++)
+ *           process(disruptor_entry(d, seq + i));
+ *       disruptor_release(d, c, n);
+ *   }
+ */
+
+/* several producers claim entries concurrently */
+#define DISRUPTOR_MULTI_WRITER 1
+
+/**
+ * @typedef disruptor_t
+ * @brief   Broadcast ring
+ */
+typedef struct disruptor* disruptor_t;
+
+/**
+ * @brief  Create ring
+ * @param  entry_size    Entry size
+ * @param  size          Entries count (rounded up to power of 2)
+ * @param  max_consumers Maximum consumers count
+ * @param  flags         Flags (DISRUPTOR_MULTI_WRITER)
+ * @retval               Returns a pointer to ring on success or NULL on error (error code stored in errno).
+ */
+disruptor_t disruptor_create(size_t entry_size, size_t size, size_t max_consumers, int flags);
+
+/**
+ * @brief  Destroy ring
+ * @param  d     Ring
+ */
+void disruptor_destroy(disruptor_t d);
+
+/**
+ * @brief  Add consumer (before first claim)
+ * @param  d     Ring
+ * @param  deps  Consumers, which must process entry before this consumer (can be NULL)
+ * @param  ndeps Dependencies count
+ * @retval       Consumer id on success, -1 on error (errno is EINVAL for invalid dependency, ENOSPC if max_consumers is reached)
+ */
+int disruptor_consumer_add(disruptor_t d, const int *deps, size_t ndeps);
+
+/**
+ * @brief  Ring size
+ * @param  d     Ring
+ */
+size_t disruptor_size(disruptor_t d);
+
+/**
+ * @brief  Entry for sequence
+ * @param  d     Ring
+ * @param  seq   Sequence
+ */
+void *disruptor_entry(disruptor_t d, uint64_t seq);
+
+/**
+ * @brief  Claim entries for write (wait while slowest consumer don't release them)
+ * @param  d     Ring
+ * @param  n     Entries count (must not be greater than ring size)
+ * @retval       First claimed sequence
+ */
+uint64_t disruptor_claim(disruptor_t d, size_t n);
+
+/**
+ * @brief  Claim entries for write without wait (for single writer only)
+ * @param  d     Ring
+ * @param  n     Entries count (must not be greater than ring size)
+ * @param  seq   First claimed sequence
+ * @retval       0 - on success, -1 - on error (errno is EAGAIN, if ring is full)
+ */
+int disruptor_try_claim(disruptor_t d, size_t n, uint64_t *seq);
+
+/**
+ * @brief  Publish written entries to consumers
+ * @param  d     Ring
+ * @param  seq   First sequence, returned by claim
+ * @param  n     Entries count
+ */
+void disruptor_publish(disruptor_t d, uint64_t seq, size_t n);
+
+/**
+ * @brief  Close ring (after all entries are published), consumers drain ring
+ * @param  d     Ring
+ */
+void disruptor_close(disruptor_t d);
+
+/**
+ * @brief  Wait available entries for consumer (batch)
+ * @param  d     Ring
+ * @param  c     Consumer id
+ * @param  seq   First available sequence
+ * @retval       Available entries count, 0 - ring is closed and drained for this consumer
+ */
+size_t disruptor_consume_wait(disruptor_t d, int c, uint64_t *seq);
+
+/**
+ * @brief  Wait available entries for consumer with timeout
+ * @param  d     Ring
+ * @param  c     Consumer id
+ * @param  seq   First available sequence
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval       Available entries count, 0 - on timeout (errno is ETIMEDOUT) or ring is closed and drained (errno is EPIPE)
+ */
+size_t disruptor_consume_timed_wait(disruptor_t d, int c, uint64_t *seq, uint64_t timeout_usecs);
+
+/**
+ * @brief  Get available entries for consumer without wait
+ * @param  d     Ring
+ * @param  c     Consumer id
+ * @param  seq   First available sequence
+ * @retval       Available entries count
+ */
+size_t disruptor_consume_try(disruptor_t d, int c, uint64_t *seq);
+
+/**
+ * @brief  Release processed entries (for producer and dependent consumers)
+ * @param  d     Ring
+ * @param  c     Consumer id
+ * @param  n     Processed entries count
+ */
+void disruptor_release(disruptor_t d, int c, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_DISRUPTOR_H_ */
@@ -0,0 +1,109 @@
+#ifndef _THREADS_EBR_H_
+#define _THREADS_EBR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Epoch-based memory reclamation.
+ *
+ * Readers don't take locks and don't touch shared refcounts: a reader only publishes
+ * observed global epoch in own (per-thread) record. Writers unlink object from shared
+ * structure and retire it into per-thread retire list, tagged with current epoch.
+ * Global epoch is advanced, when all active threads observe it, object, retired in epoch E,
+ * is freed after global epoch reach E + 2 (no reader can hold reference to it).
+ *
+ * Thread can be in one of modes:
+ *   - critical sections (ebr_enter/ebr_exit), thread is inactive outside of sections
+ *   - online (ebr_online/ebr_quiescent/ebr_offline), thread periodically announces quiescent
+ *     state (no references to shared objects are hold), thpool and lfthpool workers are
+ *     online in ebr_default() domain and announce quiescent state between tasks,
+ *     so tasks can read protected structures without ebr_enter/ebr_exit
+ *
+ * Thread record is allocated on first use of domain in thread (process is aborted, if allocation failed).
+ */
+
+/* retired objects count in thread, after that epoch advance and reclaim is tried */
+#define EBR_BATCH 64
+
+/**
+ * @typedef ebr_t
+ * @brief   Reclamation domain
+ */
+typedef struct ebr* ebr_t;
+
+/**
+ * @brief  Create reclamation domain
+ * @retval Returns a pointer to domain on success or NULL on error (error code stored in errno).
+ */
+ebr_t ebr_create(void);
+
+/**
+ * @brief  Destroy reclamation domain, all retired objects are freed (domain must not be used by other threads)
+ * @param  d  Reclamation domain
+ */
+void ebr_destroy(ebr_t d);
+
+/**
+ * @brief  Process-wide domain (pool workers announce quiescent state in it)
+ */
+ebr_t ebr_default(void);
+
+/**
+ * @brief  Enter read-side critical section (can be nested)
+ * @param  d  Reclamation domain
+ */
+void ebr_enter(ebr_t d);
+
+/**
+ * @brief  Exit read-side critical section
+ * @param  d  Reclamation domain
+ */
+void ebr_exit(ebr_t d);
+
+/**
+ * @brief  Set thread online (thread is active until ebr_offline, must announce quiescent states)
+ * @param  d  Reclamation domain
+ */
+void ebr_online(ebr_t d);
+
+/**
+ * @brief  Set thread offline (for example, before blocking wait)
+ * @param  d  Reclamation domain
+ */
+void ebr_offline(ebr_t d);
+
+/**
+ * @brief  Announce quiescent state (online thread don't hold references to protected objects)
+ * @param  d  Reclamation domain
+ */
+void ebr_quiescent(ebr_t d);
+
+/**
+ * @brief  Retire object (already unlinked from shared structure), free_fn called, when no readers can access it
+ * @param  d        Reclamation domain
+ * @param  ptr      Object
+ * @param  free_fn  Free function
+ * @retval          Returns 0 on success or -1 on error (error code stored in errno, object is not retired).
+ */
+int ebr_retire(ebr_t d, void *ptr, void (*free_fn)(void *));
+
+/**
+ * @brief  Try to advance epoch and free objects, retired by current thread
+ * @param  d  Reclamation domain
+ * @retval    Retired objects count (in current thread), not freed yet
+ */
+size_t ebr_reclaim(ebr_t d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_EBR_H_ */
@@ -0,0 +1,101 @@
+#ifndef _THREADS_EVENT_H_
+#define _THREADS_EVENT_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Auto-reset and manual-reset event (one 32-bit futex word, no mutex) */
+
+#define EVENT_INLINE static inline
+
+#define EVENT_SET     0x1u /* event is set */
+#define EVENT_WAITERS 0x2u /* may be waiters */
+#define EVENT_MANUAL  0x80000000u /* manual-reset event */
+
+/**
+ * @brief   Event
+ * @typedef event_t
+ */
+typedef struct event {
+	uint32_t state;
+} event_t;
+
+/**
+ * @brief         Init event
+ * @param  e      Event
+ * @param  manual Manual-reset event (stay set until event_reset), else auto-reset (wait consume set)
+ * @param  set    Initial state
+ */
+EVENT_INLINE void event_init(event_t *e, int manual, int set) {
+	e->state = (manual ? EVENT_MANUAL : 0) | (set ? EVENT_SET : 0);
+}
+
+/**
+ * @brief       Destroy event
+ * @param  e    Event
+ */
+EVENT_INLINE void event_destroy(event_t *e) {
+	(void) e;
+}
+
+/**
+ * @brief       Set event (wake all waiters for manual-reset event, one waiter for auto-reset)
+ * @param  e    Event
+ */
+void event_set(event_t *e);
+
+/**
+ * @brief       Reset event
+ * @param  e    Event
+ */
+EVENT_INLINE void event_reset(event_t *e) {
+	__atomic_and_fetch(&e->state, ~EVENT_SET, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief       Check event without wait (consume set for auto-reset event)
+ * @param  e    Event
+ * @retval      0 - event is set, -1 - event is not set
+ */
+EVENT_INLINE int event_try_wait(event_t *e) {
+	uint32_t s = __atomic_load_n(&e->state, __ATOMIC_ACQUIRE);
+	while (s & EVENT_SET) {
+		if (s & EVENT_MANUAL)
+			return 0;
+		if (__atomic_compare_exchange_n(&e->state, &s, s & ~EVENT_SET, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 0;
+	}
+	return -1;
+}
+
+int event_wait_slow(event_t *e, uint64_t timeout_usecs);
+
+/**
+ * @brief       Wait for event
+ * @param  e    Event
+ */
+EVENT_INLINE void event_wait(event_t *e) {
+	if (event_try_wait(e) != 0)
+		event_wait_slow(e, 0);
+}
+
+/**
+ * @brief       Wait for event with timeout
+ * @param  e    Event
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval      0 - on success, -1 - on timeout (errno is ETIMEDOUT)
+ */
+EVENT_INLINE int event_timed_wait(event_t *e, uint64_t timeout_usecs) {
+	if (event_try_wait(e) == 0)
+		return 0;
+	return event_wait_slow(e, timeout_usecs);
+}
+
+#undef EVENT_INLINE
+
+#endif /* _THREADS_EVENT_H_ */
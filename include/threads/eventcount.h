@@ -0,0 +1,119 @@
+#ifndef _THREADS_EVENTCOUNT_H_
+#define _THREADS_EVENTCOUNT_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Eventcount: add blocking wait to lock-free structures without missed wake-ups.
+ *
+ * Consumer:
+ *   while ((item = try_pop(q)) == NULL) {
+ *       key = eventcount_prepare_wait(&ec);
+ *       if ((item = try_pop(q)) != NULL) {
+ *           eventcount_cancel_wait(&ec);
+ *           break;
+ *       }
+ *       eventcount_commit_wait(&ec, key);
+ *   }
+ *
+ * Producer:
+ *   push(q, item);
+ *   eventcount_notify(&ec);
+ *
+ * Notify cost is a fence and one relaxed load, when nobody waits.
+ */
+
+#define EVENTCOUNT_INLINE static inline
+
+/**
+ * @brief   Eventcount
+ * @typedef eventcount_t
+ */
+typedef struct eventcount {
+	uint32_t epoch; /* futex word, incremented on notify with waiters */
+	uint32_t waiters; /* prepared or sleeped waiters */
+} eventcount_t;
+
+/**
+ * @brief       Init eventcount
+ * @param  ec   Eventcount
+ */
+EVENTCOUNT_INLINE void eventcount_init(eventcount_t *ec) {
+	ec->epoch = 0;
+	ec->waiters = 0;
+}
+
+/**
+ * @brief       Destroy eventcount
+ * @param  ec   Eventcount
+ */
+EVENTCOUNT_INLINE void eventcount_destroy(eventcount_t *ec) {
+	(void) ec;
+}
+
+/**
+ * @brief       Announce wait (condition must be rechecked after this)
+ * @param  ec   Eventcount
+ * @retval      Key for eventcount_commit_wait
+ */
+EVENTCOUNT_INLINE uint32_t eventcount_prepare_wait(eventcount_t *ec) {
+	__atomic_add_fetch(&ec->waiters, 1, __ATOMIC_SEQ_CST);
+	return __atomic_load_n(&ec->epoch, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief       Cancel prepared wait (condition is satisfied)
+ * @param  ec   Eventcount
+ */
+EVENTCOUNT_INLINE void eventcount_cancel_wait(eventcount_t *ec) {
+	__atomic_sub_fetch(&ec->waiters, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief       Sleep until notify after eventcount_prepare_wait (or return immediately, if notify already called)
+ * @param  ec   Eventcount
+ * @param  key  Key, returned by eventcount_prepare_wait
+ */
+void eventcount_commit_wait(eventcount_t *ec, uint32_t key);
+
+/**
+ * @brief       Sleep until notify after eventcount_prepare_wait with timeout
+ * @param  ec   Eventcount
+ * @param  key  Key, returned by eventcount_prepare_wait
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval      0 - on notify, -1 - on timeout (errno is ETIMEDOUT)
+ */
+int eventcount_commit_timed_wait(eventcount_t *ec, uint32_t key, uint64_t timeout_usecs);
+
+void eventcount_wake(eventcount_t *ec, int count);
+
+/**
+ * @brief       Wake one waiter (call it after condition change)
+ * @param  ec   Eventcount
+ */
+EVENTCOUNT_INLINE void eventcount_notify(eventcount_t *ec) {
+	/* order condition change before waiters check (pair for eventcount_prepare_wait) */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ec->waiters, __ATOMIC_RELAXED))
+		eventcount_wake(ec, 1);
+}
+
+/**
+ * @brief       Wake all waiters (call it after condition change)
+ * @param  ec   Eventcount
+ */
+EVENTCOUNT_INLINE void eventcount_notify_all(eventcount_t *ec) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&ec->waiters, __ATOMIC_RELAXED))
+		eventcount_wake(ec, -1);
+}
+
+#undef EVENTCOUNT_INLINE
+
+#endif /* _THREADS_EVENTCOUNT_H_ */
@@ -0,0 +1,168 @@
+#ifndef _THREADS_EXECUTOR_H_
+#define _THREADS_EXECUTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include <threads/lfthpool.h>
+#include <threads/thpool.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Executor: common interface (vtable) for task pools, so call sites don't depend on pool implementation.
+ * Adapters are provided for thpool_t, lfthpool_t, inline (run in caller) and caller-runs (run in caller,
+ * when wrapped executor queue is full). Other pools can be plugged with executor_create.
+ */
+
+/**
+ * @typedef executor_t
+ * @brief   Executor
+ */
+typedef struct executor* executor_t;
+
+/**
+ * @brief   Task for batch submit
+ * @typedef executor_task_t
+ */
+typedef struct executor_task {
+	void (*function)(void *);
+	void *arg;
+} executor_task_t;
+
+/**
+ * @brief   Executor stats
+ * @typedef executor_stats_t
+ */
+typedef struct executor_stats {
+	size_t workers; /* workers count (0 - tasks are run in caller) */
+	size_t active; /* running tasks */
+	size_t total; /* running and queued tasks */
+	size_t submitted; /* accepted tasks (since create) */
+	size_t rejected; /* failed submits (queue is full) */
+	size_t caller_runs; /* tasks, run in caller (inline and caller-runs executors) */
+} executor_stats_t;
+
+/**
+ * @brief   Executor implementation
+ * @typedef executor_ops_t
+ */
+typedef struct executor_ops {
+	const char *name;
+	/* returns 0 (queued), 1 (task is run in caller) or -1 on error (errno is EAGAIN, if queue is full) */
+	int (*submit)(void *impl, void (*function)(void *), void *arg);
+	/* returns count of submitted tasks (from first), can be NULL (submit is called for each task) */
+	size_t (*submit_batch)(void *impl, const executor_task_t *tasks, size_t count);
+	void (*wait)(void *impl);
+	void (*pause)(void *impl); /* can be NULL */
+	void (*resume)(void *impl); /* can be NULL */
+	/* fill workers, active and total fields, can be NULL */
+	void (*stats)(void *impl, executor_stats_t *stats);
+	/* destroy implementation on executor_destroy, can be NULL */
+	void (*destroy)(void *impl);
+} executor_ops_t;
+
+/**
+ * @brief  Create executor for implementation
+ * @param  ops       Implementation (must be valid until executor_destroy)
+ * @param  impl      Implementation instance
+ * @retval           Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+executor_t executor_create(const executor_ops_t *ops, void *impl);
+
+/**
+ * @brief  Create executor for thpool
+ * @param  pool      Threadpool
+ * @param  own       Destroy pool on executor_destroy
+ * @retval           Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+executor_t executor_thpool(thpool_t pool, int own);
+
+/**
+ * @brief  Create executor for lfthpool
+ * @param  pool      Threadpool
+ * @param  own       Destroy pool on executor_destroy
+ * @retval           Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+executor_t executor_lfthpool(lfthpool_t pool, int own);
+
+/**
+ * @brief  Create inline executor (task is run in caller on submit)
+ * @retval           Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+executor_t executor_inline(void);
+
+/**
+ * @brief  Create caller-runs executor: task is run in caller, when wrapped executor queue is full (submit never fail)
+ * @param  ex        Wrapped executor (destroyed on executor_destroy)
+ * @retval           Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+executor_t executor_caller_runs(executor_t ex);
+
+/**
+ * @brief  Executor name ("thpool", "lfthpool", "inline", "caller_runs" or custom)
+ * @param  ex        Executor
+ */
+const char *executor_name(executor_t ex);
+
+/**
+ * @brief  Submit task
+ * @param  ex        Executor
+ * @param  function  Function/task
+ * @param  arg       Argument
+ * @retval           Returns 0 on success or -1 on error (errno is EAGAIN, if queue is full).
+ */
+int executor_submit(executor_t ex, void (*function)(void *), void *arg);
+
+/**
+ * @brief  Submit tasks (in order, stopped on first failed)
+ * @param  ex        Executor
+ * @param  tasks     Tasks
+ * @param  count     Tasks count
+ * @retval           Returns count of submitted tasks.
+ */
+size_t executor_submit_batch(executor_t ex, const executor_task_t *tasks, size_t count);
+
+/**
+ * @brief  Wait for all submitted tasks done
+ * @param  ex        Executor
+ */
+void executor_wait(executor_t ex);
+
+/**
+ * @brief  Pause tasks processing (if supported)
+ * @param  ex        Executor
+ */
+void executor_pause(executor_t ex);
+
+/**
+ * @brief  Resume tasks processing
+ * @param  ex        Executor
+ */
+void executor_resume(executor_t ex);
+
+/**
+ * @brief  Get executor stats
+ * @param  ex        Executor
+ * @param  stats     Stats (output)
+ */
+void executor_stats(executor_t ex, executor_stats_t *stats);
+
+/**
+ * @brief  Wait for all submitted tasks done and destroy executor
+ * @param  ex        Executor
+ */
+void executor_destroy(executor_t ex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_EXECUTOR_H_ */
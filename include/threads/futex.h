@@ -0,0 +1,50 @@
+#ifndef _THREADS_FUTEX_H_
+#define _THREADS_FUTEX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Wait/wake on 32-bit word (Linux futex or hashed mutex/condition variable emulation on other platforms).
+ * Spurious wakeups are possible, so recheck condition after wait.
+ */
+
+/**
+ * @brief       Wait on address, if *addr is equal to val
+ * @param  addr Address
+ * @param  val  Expected value
+ * @retval      0 - on wakeup, -1 - on error (errno is EAGAIN if *addr != val, EINTR on interrupt)
+ */
+int futex_wait(uint32_t *addr, uint32_t val);
+
+/**
+ * @brief       Wait on address with timeout, if *addr is equal to val
+ * @param  addr Address
+ * @param  val  Expected value
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval      0 - on wakeup, -1 - on error (errno is ETIMEDOUT on timeout)
+ */
+int futex_timed_wait(uint32_t *addr, uint32_t val, uint64_t timeout_usecs);
+
+/**
+ * @brief       Wake waiters on address
+ * @param  addr Address
+ * @param  count Maximum count of waiters to wake (INT_MAX for wake all)
+ * @retval      Count of woken waiters (emulation always return 0), -1 - on error
+ */
+int futex_wake(uint32_t *addr, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_FUTEX_H_ */
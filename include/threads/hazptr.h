@@ -0,0 +1,94 @@
+#ifndef _THREADS_HAZPTR_H_
+#define _THREADS_HAZPTR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Hazard pointers memory reclamation.
+ *
+ * Reader publishes pointer to object in own hazard slot before access, retired object is freed
+ * only when it's not published in any slot. Unlike ebr_t, stalled or long-lived reader
+ * delays reclamation only of objects, protected by it.
+ * Retired objects are hold in per-thread lists and scanned in batches.
+ *
+ * Thread record is allocated on first use of domain in thread (process is aborted, if allocation failed).
+ */
+
+/* hazard slots per thread */
+#define HAZPTR_SLOTS 4
+/* retired objects count in thread, after that scan is done */
+#define HAZPTR_BATCH 64
+
+/**
+ * @typedef hazptr_t
+ * @brief   Hazard pointers domain
+ */
+typedef struct hazptr* hazptr_t;
+
+/**
+ * @brief  Create hazard pointers domain
+ * @retval Returns a pointer to domain on success or NULL on error (error code stored in errno).
+ */
+hazptr_t hazptr_create(void);
+
+/**
+ * @brief  Destroy hazard pointers domain, all retired objects are freed (domain must not be used by other threads)
+ * @param  h  Hazard pointers domain
+ */
+void hazptr_destroy(hazptr_t h);
+
+/**
+ * @brief  Load pointer and protect it in hazard slot (until hazptr_clear or next protect in slot)
+ * @param  h     Hazard pointers domain
+ * @param  slot  Slot (0 .. HAZPTR_SLOTS - 1)
+ * @param  src   Shared pointer location
+ * @retval       Protected pointer (can be NULL)
+ */
+void *hazptr_protect(hazptr_t h, int slot, void *const *src);
+
+/**
+ * @brief  Protect already loaded pointer (caller must validate, that it's still reachable)
+ * @param  h     Hazard pointers domain
+ * @param  slot  Slot (0 .. HAZPTR_SLOTS - 1)
+ * @param  ptr   Pointer
+ */
+void hazptr_set(hazptr_t h, int slot, void *ptr);
+
+/**
+ * @brief  Clear hazard slot
+ * @param  h     Hazard pointers domain
+ * @param  slot  Slot (0 .. HAZPTR_SLOTS - 1)
+ */
+void hazptr_clear(hazptr_t h, int slot);
+
+/**
+ * @brief  Retire object (already unlinked from shared structure), free_fn called, when it's not protected
+ * @param  h        Hazard pointers domain
+ * @param  ptr      Object
+ * @param  free_fn  Free function
+ * @retval          Returns 0 on success or -1 on error (error code stored in errno, object is not retired).
+ */
+int hazptr_retire(hazptr_t h, void *ptr, void (*free_fn)(void *));
+
+/**
+ * @brief  Scan hazard slots and free not protected objects, retired by current thread
+ * @param  h  Hazard pointers domain
+ * @retval    Retired objects count (in current thread), not freed yet
+ */
+size_t hazptr_reclaim(hazptr_t h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_HAZPTR_H_ */
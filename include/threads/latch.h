@@ -0,0 +1,100 @@
+#ifndef _THREADS_LATCH_H_
+#define _THREADS_LATCH_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Countdown latch (one 32-bit futex word, no mutex): count down to zero, wake everyone once */
+
+#define LATCH_INLINE static inline
+
+#define LATCH_COUNT_MASK 0x7FFFFFFFu
+#define LATCH_WAITERS    0x80000000u /* may be waiters */
+
+/**
+ * @brief   Countdown latch
+ * @typedef latch_t
+ */
+typedef struct latch {
+	uint32_t state;
+} latch_t;
+
+/**
+ * @brief        Init latch
+ * @param  l     Latch
+ * @param  count Initial count (must be less than 2^31)
+ */
+LATCH_INLINE void latch_init(latch_t *l, uint32_t count) {
+	l->state = count & LATCH_COUNT_MASK;
+}
+
+/**
+ * @brief       Destroy latch
+ * @param  l    Latch
+ */
+LATCH_INLINE void latch_destroy(latch_t *l) {
+	(void) l;
+}
+
+void latch_wake(latch_t *l);
+
+/**
+ * @brief       Decrement count (wake all waiters, when count reach zero)
+ * @param  l    Latch
+ * @param  n    Decrement (must not be greater than current count)
+ */
+LATCH_INLINE void latch_count_down(latch_t *l, uint32_t n) {
+	uint32_t s = __atomic_sub_fetch(&l->state, n, __ATOMIC_RELEASE);
+	if (s == LATCH_WAITERS)
+		latch_wake(l);
+}
+
+/**
+ * @brief       Check latch count without wait
+ * @param  l    Latch
+ * @retval      0 - count is zero, -1 - count is not zero
+ */
+LATCH_INLINE int latch_try_wait(latch_t *l) {
+	return (__atomic_load_n(&l->state, __ATOMIC_ACQUIRE) & LATCH_COUNT_MASK) == 0 ? 0 : -1;
+}
+
+int latch_wait_slow(latch_t *l, uint64_t timeout_usecs);
+
+/**
+ * @brief       Wait until count reach zero
+ * @param  l    Latch
+ */
+LATCH_INLINE void latch_wait(latch_t *l) {
+	if (latch_try_wait(l) != 0)
+		latch_wait_slow(l, 0);
+}
+
+/**
+ * @brief       Wait until count reach zero with timeout
+ * @param  l    Latch
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval      0 - on success, -1 - on timeout (errno is ETIMEDOUT)
+ */
+LATCH_INLINE int latch_timed_wait(latch_t *l, uint64_t timeout_usecs) {
+	if (latch_try_wait(l) == 0)
+		return 0;
+	return latch_wait_slow(l, timeout_usecs);
+}
+
+/**
+ * @brief       Decrement count by one and wait until count reach zero
+ * @param  l    Latch
+ */
+LATCH_INLINE void latch_arrive_and_wait(latch_t *l) {
+	latch_count_down(l, 1);
+	latch_wait(l);
+}
+
+#undef LATCH_INLINE
+
+#endif /* _THREADS_LATCH_H_ */
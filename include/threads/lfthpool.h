@@ -5,8 +5,11 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <unistd.h>
 
+#include <threads/pool.h>
+
 /**
  * @file
 *
@@ -34,18 +37,56 @@ lfthpool_t lfthpool_create(size_t workers, size_t queue_size);
  * @brief  Creates a pool of worker lfthpool for later use
  * @param  workers           Workers count (if < 1, hostcpu count is used).
  * @param  queue_size        Maximum lenght of job queue for workers to take work from.
- * @param  sleep_func        Sleep function (integrated with your scheduler). If NULL, sched_yield is used.
+ * @param  sleep_func        Sleep function for lfthpool_add_task_try retries (deprecated, use pool_attr_t.sched adapter
+ *                           with lfthpool_create_ex, it's woken, when queue slot is free). If NULL, pool_sched_thread is used.
  * @retval                   Returns a pointer to an initialised threadpool on
  *                           success or NULL on error (error code stored in errno).
  */
 lfthpool_t lfthpool_create_sched(size_t workers, size_t queue_size, int (*sleep_func)(useconds_t));
 
+/**
+ * @brief  Creates a pool of worker lfthpool with worker-local context
+ * @param  workers           Workers count (if < 1, hostcpu count is used).
+ * @param  queue_size        Maximum lenght of job queue for workers to take work from.
+ * @param  sleep_func        Sleep function (deprecated, see lfthpool_create_sched). If NULL, pool_sched_thread is used.
+ * @param  worker_init       Called in each worker before first task (can be NULL), context is returned by pool_current_worker().
+ *                           Create wait for all workers init and fail with init error.
+ * @param  worker_fini       Called in each worker before exit (can be NULL).
+ * @retval                   Returns a pointer to an initialised threadpool on
+ *                           success or NULL on error (error code stored in errno).
+ */
+lfthpool_t lfthpool_create_hooks(size_t workers, size_t queue_size, int (*sleep_func)(useconds_t),
+		pool_worker_init_t worker_init, pool_worker_fini_t worker_fini);
+
+/**
+ * @brief  Creates a pool of worker lfthpool with extended attributes (stack/guard size, names, scheduling policy, affinity)
+ * @param  attr              Attributes (see pool_attr_init).
+ * @retval                   Returns a pointer to an initialised threadpool on
+ *                           success or NULL on error (error code stored in errno).
+ */
+lfthpool_t lfthpool_create_ex(const pool_attr_t *attr);
+
+/**
+ * @brief  Set idle interval, after that workers arenas (see pool_current_arena) are shrinked to one chunk
+ * @param  pool            Threadpool
+ * @param  usecs           Idle interval (microseconds, POOL_ARENA_IDLE_USECS by default)
+ */
+void lfthpool_set_arena_idle(lfthpool_t pool, uint64_t usecs);
+
 /**
  * @brief  Count of workers lfthpool in thread poool
  * @param  pool            Threadpool
  */
 size_t lfthpool_workers_count(lfthpool_t pool);
 
+/**
+ * @brief  Enable spill mode: when queue is full, tasks are added to unbounded lock-free overflow list
+ *         (workers take from it every 8th task or when queue is below half), so lfthpool_add_task don't fail with EAGAIN
+ * @param  pool            Threadpool
+ * @param  enable          Enable (1) or disable (0) spill mode
+ */
+void lfthpool_set_spill(lfthpool_t pool, int enable);
+
 /**
  * @brief   Add a task to a thread pool
  * @param	pool			Threadpool to add task to.
@@ -60,7 +101,8 @@ int lfthpool_add_task(lfthpool_t pool, void (*function)(void *), void* arg);
  * @param	pool			Threadpool to add task to.
  * @param	function	Function/task for worker to execute.
  * @param	arg				Arguments to function/task.
- * @param usec      Sleep (millisec).
+ * @param usec      Park timeout (microseconds), caller is parked with scheduler adapter (see pool_sched_t) and
+ *                  woken, when worker take task from queue (0 - yield).
  * @param max_try   Try count (if queue is full).
  * @retval					Returns 0 on success, -1 or QERR_* on error.
  */
@@ -110,6 +152,15 @@ int lfthpool_worker_try_once(lfthpool_t pool);
   */
 void lfthpool_wait(lfthpool_t pool);
 
+/**
+ * @brief  Wait for all jobs done without blocking: waiter is queued and w->wake(w->arg) is called once
+ *         (in worker thread, or in caller, if other waiter is found idle), when pool is idle.
+ * @param  pool            Threadpool
+ * @param  w               Waiter (must be valid until wake)
+ * @retval                 Returns 0, if pool is already idle (waiter isn't queued), 1 if waiter is queued.
+ */
+int lfthpool_wait_async(lfthpool_t pool, pool_idle_waiter_t *w);
+
 /**
  * @brief  Shutdown thread poool
  * @param  pool            Threadpool
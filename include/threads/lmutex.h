@@ -0,0 +1,80 @@
+#ifndef _THREADS_LMUTEX_H_
+#define _THREADS_LMUTEX_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Lightweight mutex (benaphore): 4-byte futex word, spin then park in kernel */
+
+#define LMUTEX_INLINE static inline
+
+#ifndef LMUTEX_SPINS
+#define LMUTEX_SPINS 100
+#endif
+
+/**
+ * @brief   Lightweight mutex (0 - unlocked, 1 - locked, 2 - locked and may be waiters)
+ * @typedef lmutex_t
+ */
+typedef struct lmutex {
+	uint32_t state;
+} lmutex_t;
+
+#define LMUTEX_INITIALIZER { 0 }
+
+/**
+ * @brief       Init mutex
+ * @param  m    Mutex
+ */
+LMUTEX_INLINE void lmutex_init(lmutex_t *m) {
+	m->state = 0;
+}
+
+/**
+ * @brief       Destroy mutex
+ * @param  m    Mutex
+ */
+LMUTEX_INLINE void lmutex_destroy(lmutex_t *m) {
+	(void) m;
+}
+
+void lmutex_lock_slow(lmutex_t *m);
+
+void lmutex_wake(lmutex_t *m);
+
+/**
+ * @brief       Try to lock mutex
+ * @param  m    Mutex
+ * @retval      0 - on success, -1 - if mutex is locked
+ */
+LMUTEX_INLINE int lmutex_trylock(lmutex_t *m) {
+	uint32_t s = 0;
+	return __atomic_compare_exchange_n(&m->state, &s, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+/**
+ * @brief       Lock mutex
+ * @param  m    Mutex
+ */
+LMUTEX_INLINE void lmutex_lock(lmutex_t *m) {
+	if (lmutex_trylock(m) != 0)
+		lmutex_lock_slow(m);
+}
+
+/**
+ * @brief       Unlock mutex
+ * @param  m    Mutex
+ */
+LMUTEX_INLINE void lmutex_unlock(lmutex_t *m) {
+	if (__atomic_exchange_n(&m->state, 0, __ATOMIC_RELEASE) == 2)
+		lmutex_wake(m);
+}
+
+#undef LMUTEX_INLINE
+
+#endif /* _THREADS_LMUTEX_H_ */
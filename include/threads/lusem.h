@@ -1,6 +1,7 @@
 #ifndef _THREADS_LUSEM_H_
 #define _THREADS_LUSEM_H_
 
+#include <stddef.h>
 #include <sys/types.h>
 #include <errno.h>
 #include <stdint.h>
@@ -10,20 +11,54 @@
 
 #include <threads/usem.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 #define LUSEM_INLINE static inline
 
+/* Parked waiter (fair mode) */
+typedef struct lusem_waiter {
+	struct lusem_waiter *next;
+	int queued;
+	usem_t sem;
+	void (*wake)(void *arg); /* async waiter (see lusem_wait_async), sem is not used */
+	void *arg;
+} lusem_waiter_t;
+
 typedef struct lusem {
     ssize_t m_count;
 	usem_t sem;
 	int max_spins;
+	int fair; /* FIFO handoff to parked waiters */
+	int lock; /* spinlock for parked waiters queue (fair mode) */
+	ssize_t handoff; /* permits, handed off before waiter was queued (fair mode) */
+	struct lusem_waiter *head; /* parked waiters queue (fair mode) */
+	struct lusem_waiter *tail;
 } lusem_t;
 
 LUSEM_INLINE int lusem_init(lusem_t *lsem, unsigned int initial_count, int max_spins) {
     lsem->max_spins = max_spins;
     lsem->m_count = initial_count;
+	lsem->fair = 0;
+	lsem->lock = 0;
+	lsem->handoff = 0;
+	lsem->head = NULL;
+	lsem->tail = NULL;
 	return usem_init(&lsem->sem, initial_count);
 }
 
+/*
+ * Init semaphore in fair mode: while waiters are parked, signal hands the permit
+ * directly to the oldest parked waiter (FIFO). Spinning newcomers can take permit
+ * only while no one is parked.
+ */
+LUSEM_INLINE int lusem_init_fair(lusem_t *lsem, unsigned int initial_count, int max_spins) {
+	int rc = lusem_init(lsem, initial_count, max_spins);
+	lsem->fair = 1;
+	return rc;
+}
+
 LUSEM_INLINE int lusem_destroy(lusem_t *lsem) {
 	return usem_destroy(&lsem->sem);
 }
@@ -42,22 +77,44 @@ int lusem_wait(lusem_t *lsem);
 
 int lusem_timed_wait(lusem_t *lsem, uint64_t timeout_usecs);
 
+/*
+ * Async wait (fair mode only, without timeout): take permit or queue waiter, wake(arg) is called
+ * by signal (in signaling thread), when permit is handed off to waiter.
+ * Returns 0, if permit is taken, 1, if waiter is queued, or -1 (errno is EINVAL, if semaphore is not fair).
+ */
+int lusem_wait_async(lusem_t *lsem, lusem_waiter_t *w, void (*wake)(void *arg), void *arg);
+
+/* Hand off permits to the oldest parked waiters (fair mode) */
+void lusem_handoff(lusem_t *lsem, ssize_t count);
+
 LUSEM_INLINE void lusem_signal_count(lusem_t *lsem, ssize_t count) {
 	if (count > 0) {
 		ssize_t old_count = __atomic_fetch_add(&lsem->m_count, count, __ATOMIC_RELEASE);
 		ssize_t to_release = -old_count < count ? -old_count : count;
-		if (to_release > 0)
-			usem_signal_count(&lsem->sem, to_release);
+		if (to_release > 0) {
+			if (lsem->fair)
+				lusem_handoff(lsem, to_release);
+			else
+				usem_signal_count(&lsem->sem, to_release);
+		}
 	}
 }
 
 LUSEM_INLINE void lusem_signal(lusem_t *lsem) {
 	ssize_t old_count = __atomic_fetch_add(&lsem->m_count, 1, __ATOMIC_RELEASE);
 	ssize_t to_release = -old_count < 1 ? -old_count : 1;
-	if (to_release > 0)
-		usem_signal(&lsem->sem);
+	if (to_release > 0) {
+		if (lsem->fair)
+			lusem_handoff(lsem, to_release);
+		else
+			usem_signal(&lsem->sem);
+	}
 }
 
 #undef LUSEM_INLINE
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _THREADS_LUSEM_H_ */
@@ -0,0 +1,66 @@
+#ifndef _THREADS_MPSC_EXECUTOR_H_
+#define _THREADS_MPSC_EXECUTOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <threads/mpsc_queue.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Single consumer executor: one worker thread execute tasks, submitted from any thread
+ * through intrusive MPSC queue. Submit never fail and don't allocate (task is embedded in caller struct).
+ */
+
+/**
+ * @typedef mpsc_executor_t
+ * @brief   Single consumer executor
+ */
+typedef struct mpsc_executor* mpsc_executor_t;
+
+/**
+ * @brief   Task (embed it into your struct, it must be valid until function is called)
+ * @typedef mpsc_task_t
+ */
+typedef struct mpsc_task {
+	mpsc_node_t node;
+	void (*function)(struct mpsc_task *task);
+} mpsc_task_t;
+
+/**
+ * @brief  Create executor and start worker thread
+ * @retval Returns a pointer to executor on success or NULL on error (error code stored in errno).
+ */
+mpsc_executor_t mpsc_executor_create(void);
+
+/**
+ * @brief  Submit task (wait-free, any thread)
+ * @param  ex       Executor
+ * @param  task     Task
+ * @param  function Function, called with task in worker thread
+ */
+void mpsc_executor_submit(mpsc_executor_t ex, mpsc_task_t *task, void (*function)(mpsc_task_t *task));
+
+/**
+ * @brief  Wait for execute all tasks, submitted before
+ * @param  ex       Executor
+ */
+void mpsc_executor_wait(mpsc_executor_t ex);
+
+/**
+ * @brief  Execute submitted tasks, stop worker thread and destroy executor
+ * @param  ex       Executor
+ */
+void mpsc_executor_destroy(mpsc_executor_t ex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_MPSC_EXECUTOR_H_ */
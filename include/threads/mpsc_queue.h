@@ -0,0 +1,105 @@
+#ifndef _THREADS_MPSC_QUEUE_H_
+#define _THREADS_MPSC_QUEUE_H_
+
+#include <stddef.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Unbounded intrusive multi producer/single consumer queue (Vyukov).
+ * Push is wait-free (one XCHG), nodes are embedded in caller structs, so nothing is allocated.
+ * Pop can return NULL while producer is preempted between XCHG and link (queue is not empty, retry later).
+ */
+
+#define MPSC_QUEUE_INLINE static inline
+
+#define MPSC_QUEUE_CACHE_LINE 64
+
+/**
+ * @brief   Queue node (embed it into your struct)
+ * @typedef mpsc_node_t
+ */
+typedef struct mpsc_node {
+	struct mpsc_node *next;
+} mpsc_node_t;
+
+/**
+ * @brief   Queue
+ * @typedef mpsc_queue_t
+ */
+typedef struct mpsc_queue {
+	mpsc_node_t *head; /* producers */
+	char pad[MPSC_QUEUE_CACHE_LINE - sizeof(mpsc_node_t *)];
+	mpsc_node_t *tail; /* consumer */
+	mpsc_node_t stub;
+} mpsc_queue_t;
+
+/**
+ * @brief       Init queue
+ * @param  q    Queue
+ */
+MPSC_QUEUE_INLINE void mpsc_queue_init(mpsc_queue_t *q) {
+	q->stub.next = NULL;
+	q->head = &q->stub;
+	q->tail = &q->stub;
+}
+
+/**
+ * @brief       Push node (any thread)
+ * @param  q    Queue
+ * @param  n    Node
+ */
+MPSC_QUEUE_INLINE void mpsc_queue_push(mpsc_queue_t *q, mpsc_node_t *n) {
+	mpsc_node_t *prev;
+	__atomic_store_n(&n->next, NULL, __ATOMIC_RELAXED);
+	prev = __atomic_exchange_n(&q->head, n, __ATOMIC_ACQ_REL);
+	/* queue is unlinked here until store */
+	__atomic_store_n(&prev->next, n, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief       Pop node (consumer only)
+ * @param  q    Queue
+ * @retval      Node or NULL, if queue is empty (or push is in progress)
+ */
+MPSC_QUEUE_INLINE mpsc_node_t *mpsc_queue_pop(mpsc_queue_t *q) {
+	mpsc_node_t *tail = q->tail;
+	mpsc_node_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if (tail == &q->stub) {
+		if (next == NULL)
+			return NULL;
+		q->tail = next;
+		tail = next;
+		next = __atomic_load_n(&next->next, __ATOMIC_ACQUIRE);
+	}
+	if (next) {
+		q->tail = next;
+		return tail;
+	}
+	if (tail != __atomic_load_n(&q->head, __ATOMIC_ACQUIRE))
+		return NULL;
+	/* tail is last node, push stub after it for unlink */
+	mpsc_queue_push(q, &q->stub);
+	next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+	if (next) {
+		q->tail = next;
+		return tail;
+	}
+	return NULL;
+}
+
+/**
+ * @brief       Check if queue is empty and no push is in progress (consumer only)
+ * @param  q    Queue
+ */
+MPSC_QUEUE_INLINE int mpsc_queue_is_empty(mpsc_queue_t *q) {
+	return q->tail == &q->stub && __atomic_load_n(&q->head, __ATOMIC_ACQUIRE) == &q->stub;
+}
+
+#undef MPSC_QUEUE_INLINE
+
+#endif /* _THREADS_MPSC_QUEUE_H_ */
@@ -0,0 +1,82 @@
+#ifndef _THREADS_OBJPOOL_H_
+#define _THREADS_OBJPOOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Fixed size object pool: objects are preallocated in one slab, free objects are cached in
+ * per-thread magazines, backed by global lock-free stack (index with ABA tag).
+ * Get/put are O(1) and don't call malloc (except first use of pool in thread).
+ */
+
+/* objects per thread magazine */
+#define OBJPOOL_MAGAZINE 64
+
+/**
+ * @typedef objpool_t
+ * @brief   Object pool
+ */
+typedef struct objpool* objpool_t;
+
+/**
+ * @brief  Create object pool
+ * @param  obj_size  Object size
+ * @param  capacity  Objects count (less than 2^32 - 1)
+ * @retval           Returns a pointer to object pool on success or NULL on error (error code stored in errno).
+ */
+objpool_t objpool_create(size_t obj_size, size_t capacity);
+
+/**
+ * @brief  Destroy object pool (objects must not be used after)
+ * @param  pool  Object pool
+ */
+void objpool_destroy(objpool_t pool);
+
+/**
+ * @brief  Objects count
+ * @param  pool  Object pool
+ */
+size_t objpool_capacity(objpool_t pool);
+
+/**
+ * @brief  Get object
+ * @param  pool  Object pool
+ * @retval       Object or NULL, if pool is exhausted (errno is ENOMEM)
+ */
+void *objpool_get(objpool_t pool);
+
+/**
+ * @brief  Put object back to pool (can be called from any thread)
+ * @param  pool  Object pool
+ * @param  obj   Object
+ */
+void objpool_put(objpool_t pool, void *obj);
+
+/**
+ * @brief  Check if object is allocated from pool
+ * @param  pool  Object pool
+ * @param  obj   Object
+ */
+int objpool_owns(objpool_t pool, const void *obj);
+
+/**
+ * @brief  Return objects, cached in current thread magazine, to global stack
+ * @param  pool  Object pool
+ */
+void objpool_thread_flush(objpool_t pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_OBJPOOL_H_ */
@@ -0,0 +1,131 @@
+#ifndef _THREADS_PARALLEL_H_
+#define _THREADS_PARALLEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include <threads/executor.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Parallel loops over index ranges on executor (thpool, lfthpool, see executor_t).
+ * Range is split with guided self-scheduling: participants claim chunks from atomic cursor
+ * (remaining / (2 * participants), but not less than grain), so irregular iterations are balanced.
+ * One helper task per worker is submitted and calling thread participate, so call can be nested
+ * (called from task) and work is done, if executor queue is full.
+ */
+
+/**
+ * @brief  Loop body
+ * @param  ctx       Context
+ * @param  begin     Chunk begin
+ * @param  end       Chunk end (exclusive)
+ */
+typedef void (*parallel_for_fn)(void *ctx, size_t begin, size_t end);
+
+/**
+ * @brief  Reduce body: accumulate chunk into participant accumulator
+ * @param  ctx       Context
+ * @param  begin     Chunk begin
+ * @param  end       Chunk end (exclusive)
+ * @param  acc       Participant accumulator (initialized with copy of result)
+ */
+typedef void (*parallel_reduce_fn)(void *ctx, size_t begin, size_t end, void *acc);
+
+/**
+ * @brief  Join participant accumulator into result (called serialized, once per participant)
+ * @param  ctx       Context
+ * @param  result    Result
+ * @param  acc       Participant accumulator
+ */
+typedef void (*parallel_join_fn)(void *ctx, void *result, const void *acc);
+
+/**
+ * @brief  Run fn for chunks of [begin, end) in parallel and wait for all done
+ * @param  ex        Executor (NULL - run in caller)
+ * @param  begin     Range begin
+ * @param  end       Range end (exclusive)
+ * @param  grain     Minimal chunk size (0 - 1)
+ * @param  fn        Loop body
+ * @param  ctx       Context
+ * @retval           Returns 0 on success or -1 on error (error code stored in errno, range is not processed).
+ */
+int parallel_for(executor_t ex, size_t begin, size_t end, size_t grain, parallel_for_fn fn, void *ctx);
+
+/**
+ * @brief  Reduce [begin, end) in parallel: each participant accumulate chunks in own accumulator,
+ *         accumulators are joined into result
+ * @param  ex        Executor (NULL - run in caller)
+ * @param  begin     Range begin
+ * @param  end       Range end (exclusive)
+ * @param  grain     Minimal chunk size (0 - 1)
+ * @param  fn        Reduce body
+ * @param  join      Join accumulator
+ * @param  ctx       Context
+ * @param  result    Result, must be initialized with identity value (accumulators are copied from it)
+ * @param  acc_size  Result (accumulator) size
+ * @retval           Returns 0 on success or -1 on error (error code stored in errno, result is not changed).
+ */
+int parallel_reduce(executor_t ex, size_t begin, size_t end, size_t grain, parallel_reduce_fn fn,
+		parallel_join_fn join, void *ctx, void *result, size_t acc_size);
+
+/*
+ * Bulk kernels on executor (caller participate). If parallel_for fail, step is run in caller,
+ * so kernels fail only on temporary buffer allocation (array is not changed).
+ */
+
+/**
+ * @brief  Sort array in parallel: blocks are sorted with qsort, sorted runs are merged in rounds,
+ *         each merge is split to pieces with merge path (not stable)
+ * @param  ex        Executor (NULL - qsort in caller)
+ * @param  base      Array
+ * @param  nmemb     Elements count
+ * @param  size      Element size
+ * @param  compar    Compare function (as for qsort)
+ * @retval           Returns 0 on success or -1 on error (error code stored in errno).
+ */
+int parallel_sort(executor_t ex, void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *));
+
+/**
+ * @brief  Exclusive prefix sum in two passes (block sums, then blocks scan from block offsets)
+ * @param  ex        Executor (NULL - run in caller)
+ * @param  in        Input
+ * @param  out       Output (can be in)
+ * @param  n         Elements count
+ * @param  init      Initial value (out[0])
+ * @param  total     Sum of init and all elements (output, can be NULL)
+ * @retval           Returns 0 on success or -1 on error (error code stored in errno).
+ */
+int parallel_exclusive_scan(executor_t ex, const size_t *in, size_t *out, size_t n, size_t init, size_t *total);
+
+/**
+ * @brief  Copy memory in parallel with cache-sized chunks
+ * @param  ex        Executor (NULL - run in caller)
+ * @param  dst       Destination
+ * @param  src       Source (not overlapped with dst)
+ * @param  n         Size
+ */
+void parallel_memcpy(executor_t ex, void *dst, const void *src, size_t n);
+
+/**
+ * @brief  Fill memory in parallel with cache-sized chunks
+ * @param  ex        Executor (NULL - run in caller)
+ * @param  dst       Destination
+ * @param  c         Byte value
+ * @param  n         Size
+ */
+void parallel_memset(executor_t ex, void *dst, int c, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_PARALLEL_H_ */
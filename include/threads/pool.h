@@ -0,0 +1,154 @@
+#ifndef _THREADS_POOL_H_
+#define _THREADS_POOL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <threads/arena.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Worker-local context, shared by thpool_t and lfthpool_t.
+ * worker_init is called once in each worker thread before first task, worker_fini before thread exit,
+ * so tasks can use per-worker state (scratch buffers, connections, RNG) without per-task setup or lookup.
+ *
+ * Each worker also has scratch arena for task temporaries: it's reset after each task and
+ * shrinked to one chunk, when worker is idle for arena idle interval.
+ */
+
+/* default arena idle interval (microseconds) */
+#define POOL_ARENA_IDLE_USECS 1000000
+
+/*
+ * Pool memory flags (pool_attr_t.mem_flags), so first tasks burst don't stall on page faults.
+ */
+#define POOL_MEM_PREFAULT 1 /* prefault queue memory on create */
+#define POOL_MEM_HUGEPAGE 2 /* advise transparent huge pages for queue memory (Linux only) */
+#define POOL_MEM_LOCK     4 /* lock pool memory in RAM (mlock), create fail, if RLIMIT_MEMLOCK is exceeded */
+
+/* alignment of caller-provided pool memory (see thpool_init_inplace) */
+#define POOL_INPLACE_ALIGN 64
+
+/**
+ * @brief   Pool worker
+ * @typedef pool_worker_t
+ */
+typedef struct pool_worker {
+	size_t index; /* worker index (0 .. workers - 1) */
+	void *ctx; /* context, set by worker_init */
+} pool_worker_t;
+
+/**
+ * @brief  Worker init callback
+ * @param  index  Worker index
+ * @param  ctx    Context (output)
+ * @retval        Returns 0 on success or error code (pool create is failed with it in errno)
+ */
+typedef int (*pool_worker_init_t)(size_t index, void **ctx);
+
+/**
+ * @brief  Worker fini callback (called only if worker_init succeed)
+ * @param  ctx    Context
+ */
+typedef void (*pool_worker_fini_t)(void *ctx);
+
+/*
+ * Scheduler adapter (lfthpool only): blocking callers (lfthpool_add_task_try on full queue, lfthpool_wait) are
+ * parked with it and unparked by workers, so green threads (coroutines) are woken immediately, without timed polling.
+ * Semantic is park/unpark with permit: unpark before park make next park return immediately.
+ * Park can return spuriously (pool recheck wait condition).
+ */
+
+/**
+ * @brief   Scheduler adapter
+ * @typedef pool_sched_t
+ */
+typedef struct pool_sched {
+	void *ctx;
+	/* token of current (green) thread, passed to unpark */
+	uintptr_t (*self)(void *ctx);
+	/* park current thread until unpark or deadline (CLOCK_MONOTONIC microseconds, 0 - without deadline) */
+	void (*park)(void *ctx, uint64_t deadline);
+	/* unpark thread (called from pool workers or other threads) */
+	void (*unpark)(void *ctx, uintptr_t token);
+	/* yield cpu to other threads */
+	void (*yield)(void *ctx);
+} pool_sched_t;
+
+/**
+ * @brief   Pool creation attributes (init with pool_attr_init)
+ * @typedef pool_attr_t
+ */
+typedef struct pool_attr {
+	size_t workers; /* workers count */
+	size_t queue_size; /* maximum lenght of job queue */
+	size_t min_workers; /* workers, started on create (thpool only), others are started on demand, when queue grows */
+	uint64_t idle_timeout_usecs; /* workers, idle longer than timeout, exit down to min_workers (thpool only, 0 - don't exit) */
+	size_t stack_size; /* worker stack size (0 - default) */
+	size_t guard_size; /* worker stack guard size (0 - default) */
+	const char *name; /* workers names prefix, worker name is "<name>-<index>" (truncated to 15 chars, NULL - pool default) */
+	int nice; /* workers nice value (-20..19, 0 - not changed, Linux only) */
+	int sched_policy; /* SCHED_* policy (-1 - inherited) */
+	int sched_priority; /* priority for sched_policy */
+	const int *cpus; /* affinity cpus (NULL - not changed) */
+	size_t cpus_count;
+	int cpus_pin; /* pin worker to one cpu (cpus[index % cpus_count]), else all workers use cpus set */
+	pool_worker_init_t worker_init; /* see thpool_create_hooks (can be NULL) */
+	pool_worker_fini_t worker_fini; /* can be NULL */
+	int (*sleep_func)(useconds_t); /* lfthpool only, deprecated (use sched), see lfthpool_create_sched (can be NULL) */
+	const pool_sched_t *sched; /* lfthpool only, scheduler adapter for blocking callers (copied, NULL - pool_sched_thread) */
+	uint64_t arena_idle_usecs; /* see thpool_set_arena_idle */
+	int mem_flags; /* POOL_MEM_* flags (thpool only) */
+} pool_attr_t;
+
+/**
+ * @brief   Pool idle waiter (see thpool_wait_async), wake is called once, when all tasks are done
+ * @typedef pool_idle_waiter_t
+ */
+typedef struct pool_idle_waiter {
+	struct pool_idle_waiter *next;
+	void (*wake)(void *arg);
+	void *arg;
+} pool_idle_waiter_t;
+
+/**
+ * @brief  Init pool attributes with defaults
+ * @param  attr       Attributes
+ * @param  workers    Workers count
+ * @param  queue_size Maximum lenght of job queue
+ */
+void pool_attr_init(pool_attr_t *attr, size_t workers, size_t queue_size);
+
+/**
+ * @brief  Scheduler adapter for OS threads (futex-based park/unpark, sched_yield), used by pool workers
+ * @retval Adapter
+ */
+const pool_sched_t *pool_sched_thread(void);
+
+/**
+ * @brief  Current pool worker
+ * @retval Worker or NULL, if called not from pool worker thread
+ */
+const pool_worker_t *pool_current_worker(void);
+
+/**
+ * @brief  Current pool worker arena (allocations are freed after task return)
+ * @retval Arena or NULL, if called not from pool worker thread
+ */
+arena_t *pool_current_arena(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _THREADS_POOL_H_ */
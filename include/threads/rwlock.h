@@ -0,0 +1,124 @@
+#ifndef _THREADS_RWLOCK_H_
+#define _THREADS_RWLOCK_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Lightweight futex read-write lock with writer preference */
+
+#define RWLOCK_INLINE static inline
+
+#define RWLOCK_READERS_MASK 0x000FFFFFu /* readers, holds lock */
+#define RWLOCK_WRITER_WAIT  0x00100000u /* one waiting writer */
+#define RWLOCK_WRITERS_MASK 0x7FF00000u /* waiting writers */
+#define RWLOCK_WRITER       0x80000000u /* writer holds lock */
+
+/**
+ * @brief   Read-write lock (readers and writers counters packed in one 32-bit word)
+ * @typedef rwlock_t
+ */
+typedef struct rwlock {
+	uint32_t state;
+	uint32_t rseq; /* readers wakeup */
+	uint32_t wseq; /* writers wakeup */
+	uint32_t rwait; /* sleeping readers */
+	int max_spins;
+} rwlock_t;
+
+/**
+ * @brief            Init read-write lock
+ * @param  l         Lock
+ * @param  max_spins Spins before sleep in kernel
+ */
+RWLOCK_INLINE void rwlock_init(rwlock_t *l, int max_spins) {
+	l->state = 0;
+	l->rseq = 0;
+	l->wseq = 0;
+	l->rwait = 0;
+	l->max_spins = max_spins;
+}
+
+/**
+ * @brief       Destroy read-write lock
+ * @param  l    Lock
+ */
+RWLOCK_INLINE void rwlock_destroy(rwlock_t *l) {
+	(void) l;
+}
+
+void rwlock_rdlock_slow(rwlock_t *l);
+
+void rwlock_wrlock_slow(rwlock_t *l);
+
+void rwlock_wake(rwlock_t *l, uint32_t state);
+
+/**
+ * @brief       Try to lock for read (fail if writer holds or waits lock)
+ * @param  l    Lock
+ * @retval      0 - on success, -1 - if lock is busy
+ */
+RWLOCK_INLINE int rwlock_tryrdlock(rwlock_t *l) {
+	uint32_t s = __atomic_load_n(&l->state, __ATOMIC_RELAXED);
+	while ((s & (RWLOCK_WRITER | RWLOCK_WRITERS_MASK)) == 0) {
+		if (__atomic_compare_exchange_n(&l->state, &s, s + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 0;
+	}
+	return -1;
+}
+
+/**
+ * @brief       Lock for read
+ * @param  l    Lock
+ */
+RWLOCK_INLINE void rwlock_rdlock(rwlock_t *l) {
+	if (rwlock_tryrdlock(l) != 0)
+		rwlock_rdlock_slow(l);
+}
+
+/**
+ * @brief       Unlock after read
+ * @param  l    Lock
+ */
+RWLOCK_INLINE void rwlock_rdunlock(rwlock_t *l) {
+	uint32_t s = __atomic_sub_fetch(&l->state, 1, __ATOMIC_RELEASE);
+	if ((s & RWLOCK_READERS_MASK) == 0 && (s & RWLOCK_WRITERS_MASK) != 0)
+		rwlock_wake(l, s);
+}
+
+/**
+ * @brief       Try to lock for write
+ * @param  l    Lock
+ * @retval      0 - on success, -1 - if lock is busy
+ */
+RWLOCK_INLINE int rwlock_trywrlock(rwlock_t *l) {
+	uint32_t s = 0;
+	return __atomic_compare_exchange_n(&l->state, &s, RWLOCK_WRITER, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+/**
+ * @brief       Lock for write
+ * @param  l    Lock
+ */
+RWLOCK_INLINE void rwlock_wrlock(rwlock_t *l) {
+	if (rwlock_trywrlock(l) != 0)
+		rwlock_wrlock_slow(l);
+}
+
+/**
+ * @brief       Unlock after write
+ * @param  l    Lock
+ */
+RWLOCK_INLINE void rwlock_wrunlock(rwlock_t *l) {
+	uint32_t s = __atomic_sub_fetch(&l->state, RWLOCK_WRITER, __ATOMIC_SEQ_CST);
+	if ((s & RWLOCK_WRITERS_MASK) != 0 || __atomic_load_n(&l->rwait, __ATOMIC_SEQ_CST) != 0)
+		rwlock_wake(l, s);
+}
+
+#undef RWLOCK_INLINE
+
+#endif /* _THREADS_RWLOCK_H_ */
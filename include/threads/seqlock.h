@@ -0,0 +1,128 @@
+#ifndef _THREADS_SEQLOCK_H_
+#define _THREADS_SEQLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <threads/utils.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Sequence lock for small POD snapshots: readers never write shared memory,
+ * but retry if writer change data during read.
+ */
+
+#define SEQLOCK_INLINE static inline
+
+/**
+ * @brief   Sequence lock (odd sequence - writer in progress)
+ * @typedef seqlock_t
+ */
+typedef struct seqlock {
+	uint32_t seq;
+} seqlock_t;
+
+/**
+ * @brief       Init sequence lock
+ * @param  l    Lock
+ */
+SEQLOCK_INLINE void seqlock_init(seqlock_t *l) {
+	l->seq = 0;
+}
+
+/**
+ * @brief       Begin read section
+ * @param  l    Lock
+ * @retval      Sequence (pass to seqlock_read_retry)
+ */
+SEQLOCK_INLINE uint32_t seqlock_read_begin(seqlock_t *l) {
+	uint32_t seq;
+	while ((seq = __atomic_load_n(&l->seq, __ATOMIC_ACQUIRE)) & 1)
+		threads_cpu_relax();
+	return seq;
+}
+
+/**
+ * @brief       End read section
+ * @param  l    Lock
+ * @param  seq  Sequence, returned by seqlock_read_begin
+ * @retval      0 - readed data is consistent, 1 - data changed, read must be retried
+ */
+SEQLOCK_INLINE int seqlock_read_retry(seqlock_t *l, uint32_t seq) {
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&l->seq, __ATOMIC_RELAXED) != seq;
+}
+
+/**
+ * @brief       Lock for write (writers are serialized with spin)
+ * @param  l    Lock
+ */
+SEQLOCK_INLINE void seqlock_write_lock(seqlock_t *l) {
+	uint32_t seq = __atomic_load_n(&l->seq, __ATOMIC_RELAXED);
+	while (1) {
+		if ((seq & 1) == 0 && __atomic_compare_exchange_n(&l->seq, &seq, seq + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			break;
+		threads_cpu_relax();
+		seq = __atomic_load_n(&l->seq, __ATOMIC_RELAXED);
+	}
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+/**
+ * @brief       Unlock after write
+ * @param  l    Lock
+ */
+SEQLOCK_INLINE void seqlock_write_unlock(seqlock_t *l) {
+	__atomic_add_fetch(&l->seq, 1, __ATOMIC_RELEASE);
+}
+
+/* Copy data with relaxed atomic access (racy reads are expected under seqlock) */
+SEQLOCK_INLINE void seqlock_copy(void *dst, const void *src, size_t size) {
+	size_t i = 0;
+	if ((((uintptr_t) dst | (uintptr_t) src) & (sizeof(size_t) - 1)) == 0) {
+		for (; i + sizeof(size_t) <= size; i += sizeof(size_t)) {
+			__atomic_store_n((size_t *) ((char *) dst + i),
+				__atomic_load_n((const size_t *) ((const char *) src + i), __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+		}
+	}
+	for (; i < size; i++) {
+		__atomic_store_n((char *) dst + i, __atomic_load_n((const char *) src + i, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * @brief       Read consistent snapshot of protected data
+ * @param  l    Lock
+ * @param  dst  Snapshot destination
+ * @param  src  Protected data
+ * @param  size Data size
+ */
+SEQLOCK_INLINE void seqlock_read(seqlock_t *l, void *dst, const void *src, size_t size) {
+	uint32_t seq;
+	do {
+		seq = seqlock_read_begin(l);
+		seqlock_copy(dst, src, size);
+	} while (seqlock_read_retry(l, seq));
+}
+
+/**
+ * @brief       Write protected data
+ * @param  l    Lock
+ * @param  dst  Protected data
+ * @param  src  New data
+ * @param  size Data size
+ */
+SEQLOCK_INLINE void seqlock_write(seqlock_t *l, void *dst, const void *src, size_t size) {
+	seqlock_write_lock(l);
+	seqlock_copy(dst, src, size);
+	seqlock_write_unlock(l);
+}
+
+#undef SEQLOCK_INLINE
+
+#endif /* _THREADS_SEQLOCK_H_ */
@@ -0,0 +1,161 @@
+#ifndef _THREADS_SPINLOCK_H_
+#define _THREADS_SPINLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+
+#include <threads/utils.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Queued spinlocks (FIFO) for very short critical sections */
+
+#define SPINLOCK_INLINE static inline
+
+/* Spins before yield cpu (for oversubscribed systems) */
+#ifndef SPINLOCK_SPINS
+#define SPINLOCK_SPINS 128
+#endif
+
+/**
+ * @brief   Ticket spinlock
+ * @typedef ticketlock_t
+ */
+typedef struct ticketlock {
+	uint32_t next;
+	uint32_t owner;
+} ticketlock_t;
+
+/**
+ * @brief       Init ticket spinlock
+ * @param  l    Lock
+ */
+SPINLOCK_INLINE void ticketlock_init(ticketlock_t *l) {
+	l->next = 0;
+	l->owner = 0;
+}
+
+/**
+ * @brief       Lock ticket spinlock
+ * @param  l    Lock
+ */
+SPINLOCK_INLINE void ticketlock_lock(ticketlock_t *l) {
+	uint32_t ticket = __atomic_fetch_add(&l->next, 1, __ATOMIC_RELAXED);
+	int spin = SPINLOCK_SPINS;
+	while (__atomic_load_n(&l->owner, __ATOMIC_ACQUIRE) != ticket) {
+		if (--spin < 0) {
+			sched_yield();
+			spin = SPINLOCK_SPINS;
+		} else {
+			threads_cpu_relax();
+		}
+	}
+}
+
+/**
+ * @brief       Try to lock ticket spinlock
+ * @param  l    Lock
+ * @retval      0 - on success, -1 - if lock is busy
+ */
+SPINLOCK_INLINE int ticketlock_trylock(ticketlock_t *l) {
+	uint32_t owner = __atomic_load_n(&l->owner, __ATOMIC_RELAXED);
+	uint32_t next = owner;
+	return __atomic_compare_exchange_n(&l->next, &next, owner + 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+/**
+ * @brief       Unlock ticket spinlock
+ * @param  l    Lock
+ */
+SPINLOCK_INLINE void ticketlock_unlock(ticketlock_t *l) {
+	__atomic_store_n(&l->owner, l->owner + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief   MCS lock queue node (one per lock acquire, usually on stack)
+ * @typedef mcs_node_t
+ */
+typedef struct mcs_node {
+	struct mcs_node *next;
+	int locked;
+} mcs_node_t;
+
+/**
+ * @brief   MCS spinlock (each waiter spin on own node)
+ * @typedef mcslock_t
+ */
+typedef struct mcslock {
+	mcs_node_t *tail;
+} mcslock_t;
+
+/**
+ * @brief       Init MCS spinlock
+ * @param  l    Lock
+ */
+SPINLOCK_INLINE void mcslock_init(mcslock_t *l) {
+	l->tail = NULL;
+}
+
+/**
+ * @brief       Lock MCS spinlock
+ * @param  l    Lock
+ * @param  node Queue node (must be valid until unlock)
+ */
+SPINLOCK_INLINE void mcslock_lock(mcslock_t *l, mcs_node_t *node) {
+	mcs_node_t *prev;
+	int spin = SPINLOCK_SPINS;
+	node->next = NULL;
+	node->locked = 1;
+	prev = __atomic_exchange_n(&l->tail, node, __ATOMIC_ACQ_REL);
+	if (prev == NULL)
+		return;
+	__atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+	while (__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+		if (--spin < 0) {
+			sched_yield();
+			spin = SPINLOCK_SPINS;
+		} else {
+			threads_cpu_relax();
+		}
+	}
+}
+
+/**
+ * @brief       Try to lock MCS spinlock
+ * @param  l    Lock
+ * @param  node Queue node (must be valid until unlock)
+ * @retval      0 - on success, -1 - if lock is busy
+ */
+SPINLOCK_INLINE int mcslock_trylock(mcslock_t *l, mcs_node_t *node) {
+	mcs_node_t *expected = NULL;
+	node->next = NULL;
+	node->locked = 0;
+	return __atomic_compare_exchange_n(&l->tail, &expected, node, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) ? 0 : -1;
+}
+
+/**
+ * @brief       Unlock MCS spinlock
+ * @param  l    Lock
+ * @param  node Queue node, used for lock
+ */
+SPINLOCK_INLINE void mcslock_unlock(mcslock_t *l, mcs_node_t *node) {
+	mcs_node_t *next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE);
+	if (next == NULL) {
+		mcs_node_t *expected = node;
+		if (__atomic_compare_exchange_n(&l->tail, &expected, NULL, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			return;
+		/* successor is enqueuing */
+		while ((next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE)) == NULL)
+			sched_yield();
+	}
+	__atomic_store_n(&next->locked, 0, __ATOMIC_RELEASE);
+}
+
+#undef SPINLOCK_INLINE
+
+#endif /* _THREADS_SPINLOCK_H_ */
@@ -0,0 +1,172 @@
+#ifndef _THREADS_SPSC_RING_H_
+#define _THREADS_SPSC_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <threads/eventcount.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Single producer/single consumer ring of pointers.
+ * Producer and consumer indexes are on own cache lines, each side cache the other side index
+ * and reload it only when ring looks full (or empty).
+ */
+
+#define SPSC_RING_INLINE static inline
+
+#define SPSC_RING_CACHE_LINE 64
+
+/* enable spsc_ring_push_wait/spsc_ring_pop_wait (push/pop notify other side) */
+#define SPSC_RING_BLOCKING 1
+
+/**
+ * @brief   SPSC ring
+ * @typedef spsc_ring_t
+ */
+typedef struct spsc_ring {
+	/* shared, read-only */
+	void **items;
+	size_t mask;
+	int flags;
+	eventcount_t not_empty;
+	eventcount_t not_full;
+	char pad0[SPSC_RING_CACHE_LINE];
+	/* producer */
+	size_t head;
+	size_t cached_tail;
+	char pad1[SPSC_RING_CACHE_LINE - 2 * sizeof(size_t)];
+	/* consumer */
+	size_t tail;
+	size_t cached_head;
+	char pad2[SPSC_RING_CACHE_LINE - 2 * sizeof(size_t)];
+} spsc_ring_t;
+
+/**
+ * @brief        Init ring
+ * @param  r     Ring
+ * @param  size  Ring size (rounded up to power of 2)
+ * @param  flags Flags (SPSC_RING_BLOCKING)
+ * @retval       0 - on success, -1 - on error (error code stored in errno)
+ */
+int spsc_ring_init(spsc_ring_t *r, size_t size, int flags);
+
+/**
+ * @brief       Destroy ring
+ * @param  r    Ring
+ */
+void spsc_ring_destroy(spsc_ring_t *r);
+
+/**
+ * @brief       Ring size
+ * @param  r    Ring
+ */
+SPSC_RING_INLINE size_t spsc_ring_size(spsc_ring_t *r) {
+	return r->mask + 1;
+}
+
+/**
+ * @brief       Items count (approximate)
+ * @param  r    Ring
+ */
+SPSC_RING_INLINE size_t spsc_ring_len(spsc_ring_t *r) {
+	return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief       Push items (producer only)
+ * @param  r    Ring
+ * @param  items Items
+ * @param  n    Items count
+ * @retval      Pushed items count
+ */
+SPSC_RING_INLINE size_t spsc_ring_push_batch(spsc_ring_t *r, void * const *items, size_t n) {
+	size_t i, head = r->head, free_slots = r->mask + 1 - (head - r->cached_tail);
+	if (free_slots < n) {
+		r->cached_tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+		free_slots = r->mask + 1 - (head - r->cached_tail);
+		if (free_slots < n)
+			n = free_slots;
+		if (n == 0)
+			return 0;
+	}
+	for (i = 0; i < n; i++) {
+		r->items[(head + i) & r->mask] = items[i];
+	}
+	__atomic_store_n(&r->head, head + n, __ATOMIC_RELEASE);
+	if (r->flags & SPSC_RING_BLOCKING)
+		eventcount_notify(&r->not_empty);
+	return n;
+}
+
+/**
+ * @brief       Push item (producer only)
+ * @param  r    Ring
+ * @param  item Item
+ * @retval      0 - on success, -1 - ring is full
+ */
+SPSC_RING_INLINE int spsc_ring_push(spsc_ring_t *r, void *item) {
+	return spsc_ring_push_batch(r, &item, 1) == 1 ? 0 : -1;
+}
+
+/**
+ * @brief       Pop items (consumer only)
+ * @param  r    Ring
+ * @param  items Buffer for items
+ * @param  n    Buffer size
+ * @retval      Popped items count
+ */
+SPSC_RING_INLINE size_t spsc_ring_pop_batch(spsc_ring_t *r, void **items, size_t n) {
+	size_t i, tail = r->tail, avail = r->cached_head - tail;
+	if (avail < n) {
+		r->cached_head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+		avail = r->cached_head - tail;
+		if (avail < n)
+			n = avail;
+		if (n == 0)
+			return 0;
+	}
+	for (i = 0; i < n; i++) {
+		items[i] = r->items[(tail + i) & r->mask];
+	}
+	__atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);
+	if (r->flags & SPSC_RING_BLOCKING)
+		eventcount_notify(&r->not_full);
+	return n;
+}
+
+/**
+ * @brief       Pop item (consumer only)
+ * @param  r    Ring
+ * @retval      Item or NULL, if ring is empty
+ */
+SPSC_RING_INLINE void *spsc_ring_pop(spsc_ring_t *r) {
+	void *item;
+	return spsc_ring_pop_batch(r, &item, 1) == 1 ? item : NULL;
+}
+
+/**
+ * @brief       Push item, wait while ring is full (ring must be inited with SPSC_RING_BLOCKING)
+ * @param  r    Ring
+ * @param  item Item
+ */
+void spsc_ring_push_wait(spsc_ring_t *r, void *item);
+
+/**
+ * @brief       Pop items, wait while ring is empty (ring must be inited with SPSC_RING_BLOCKING)
+ * @param  r    Ring
+ * @param  items Buffer for items
+ * @param  n    Buffer size
+ * @param  timeout_usecs Timeout (microseconds), 0 - wait without timeout
+ * @retval      Popped items count (0 - on timeout)
+ */
+size_t spsc_ring_pop_wait(spsc_ring_t *r, void **items, size_t n, uint64_t timeout_usecs);
+
+#undef SPSC_RING_INLINE
+
+#endif /* _THREADS_SPSC_RING_H_ */
@@ -0,0 +1,62 @@
+#ifndef _THREADS_TBARRIER_H_
+#define _THREADS_TBARRIER_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/*
+ * Sense-reversing (generation counter) barrier: the last arrived thread start new round,
+ * others spin on round counter for configurable time and then sleep on futex.
+ */
+
+#define TBARRIER_CACHE_LINE 64
+
+/* returned to one (last arrived) thread, like PTHREAD_BARRIER_SERIAL_THREAD */
+#define TBARRIER_SERIAL_THREAD 1
+
+/* default spin time before sleep (microseconds) */
+#define TBARRIER_SPIN_USECS 50
+
+/**
+ * @brief   Barrier
+ * @typedef tbarrier_t
+ */
+typedef struct tbarrier {
+	uint32_t count; /* threads count */
+	uint32_t spin_usecs;
+	uint32_t arrived;
+	char pad[TBARRIER_CACHE_LINE - 3 * sizeof(uint32_t)];
+	/* spinned by waiters, so don't share cache line with arrived counter */
+	uint32_t round;
+	uint32_t waiters; /* may be waiters, sleeped in kernel */
+} tbarrier_t;
+
+/**
+ * @brief            Init barrier
+ * @param  b         Barrier
+ * @param  count     Threads count
+ * @param  spin_usecs Spin time before sleep (microseconds), 0 - sleep without spin
+ *                   (spin is disabled, if count is greater than cpu count)
+ * @retval           0 - on success, -1 - on error (errno is EINVAL)
+ */
+int tbarrier_init(tbarrier_t *b, uint32_t count, uint32_t spin_usecs);
+
+/**
+ * @brief       Destroy barrier
+ * @param  b    Barrier
+ */
+void tbarrier_destroy(tbarrier_t *b);
+
+/**
+ * @brief       Wait until all threads arrived
+ * @param  b    Barrier
+ * @retval      TBARRIER_SERIAL_THREAD - for one (last arrived) thread, 0 - for others
+ */
+int tbarrier_wait(tbarrier_t *b);
+
+#endif /* _THREADS_TBARRIER_H_ */
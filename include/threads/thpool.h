@@ -5,8 +5,11 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <unistd.h>
 
+#include <threads/pool.h>
+
 /**
  * @file
 *
@@ -30,6 +33,51 @@ typedef struct thpool* thpool_t;
  */
 thpool_t thpool_create(size_t workers, size_t queue_size);
 
+/**
+ * @brief  Creates a pool of worker thpool with worker-local context
+ * @param  workers           Workers count (if < 1, hostcpu count is used).
+ * @param  queue_size        Maximum lenght of job queue for workers to take work from.
+ * @param  worker_init       Called in each worker before first task (can be NULL), context is returned by pool_current_worker().
+ *                           Create wait for all workers init and fail with init error.
+ * @param  worker_fini       Called in each worker before exit (can be NULL).
+ * @retval                   Returns a pointer to an initialised threadpool on
+ *                           success or NULL on error (error code stored in errno).
+ */
+thpool_t thpool_create_hooks(size_t workers, size_t queue_size, pool_worker_init_t worker_init, pool_worker_fini_t worker_fini);
+
+/**
+ * @brief  Creates a pool of worker thpool with extended attributes (stack/guard size, names, scheduling policy, affinity)
+ * @param  attr              Attributes (see pool_attr_init).
+ * @retval                   Returns a pointer to an initialised threadpool on
+ *                           success or NULL on error (error code stored in errno).
+ */
+thpool_t thpool_create_ex(const pool_attr_t *attr);
+
+/**
+ * @brief  Memory size for thpool_init_inplace
+ * @param  attr              Attributes (see pool_attr_init).
+ * @retval                   Returns size or 0 on invalid attributes (errno is EINVAL).
+ */
+size_t thpool_inplace_size(const pool_attr_t *attr);
+
+/**
+ * @brief  Init a pool of worker thpool in caller-provided memory (pool, thread array, task queue),
+ *         memory must be valid until thpool_destroy and isn't freed by it.
+ * @param  mem               Memory, aligned to POOL_INPLACE_ALIGN.
+ * @param  size              Memory size (see thpool_inplace_size).
+ * @param  attr              Attributes (see pool_attr_init).
+ * @retval                   Returns a pointer to an initialised threadpool on
+ *                           success or NULL on error (error code stored in errno).
+ */
+thpool_t thpool_init_inplace(void *mem, size_t size, const pool_attr_t *attr);
+
+/**
+ * @brief  Set idle interval, after that workers arenas (see pool_current_arena) are shrinked to one chunk
+ * @param  pool            Threadpool
+ * @param  usecs           Idle interval (microseconds, POOL_ARENA_IDLE_USECS by default)
+ */
+void thpool_set_arena_idle(thpool_t pool, uint64_t usecs);
+
 /**
  * @brief  Count of workers thpool in thread poool
  * @param  pool            Threadpool
@@ -94,6 +142,20 @@ int thpool_worker_try_once(thpool_t pool);
 
 void thpool_wait(thpool_t pool);
 
+/**
+ * @brief  Wait for all jobs done without blocking: waiter is queued and w->wake(w->arg) is called once
+ *         (in worker thread, or in caller, if other waiter is found idle), when pool is idle.
+ * @param  pool            Threadpool
+ * @param  w               Waiter (must be valid until wake)
+ * @retval                 Returns 0, if pool is already idle (waiter isn't queued), 1 if waiter is queued.
+ */
+int thpool_wait_async(thpool_t pool, pool_idle_waiter_t *w);
+
+/**
+ * @brief  Queue lock type, selected at compile time (pthread, lmutex, ticket or mcs)
+ */
+const char *thpool_lock_name(void);
+
 /**
  * @brief  Shutdown thread poool
  * @param  pool            Threadpool
@@ -0,0 +1,516 @@
+#ifndef _THREADS_THREAD_POOL_HPP_
+#define _THREADS_THREAD_POOL_HPP_
+
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <new>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <threads/futex.h>
+#include <threads/lfthpool.h>
+#include <threads/lusem.h>
+#include <threads/objpool.h>
+#include <threads/thpool.h>
+
+#if defined(__cpp_impl_coroutine)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define THREADS_COROUTINES 1
+#endif
+#endif
+
+/**
+ * @file
+*
+* Public header (C++11, awaitables with C++20 coroutines)
+*/
+
+/*
+ * RAII wrappers over thpool_t and lfthpool_t.
+ * Callables are moved into task cells, preallocated in objpool_t (so submit don't allocate): cell is passed
+ * as task argument and hold type-erased call/destroy functions, callable (captures up to task_inline_size bytes
+ * are stored inline, larger ones are allocated) and then result or exception for future.
+ * Heap is used only, if all cells are in use (tasks are queued or futures are not released).
+ *
+ * With C++20 coroutines: co_await pool.schedule() (resume on pool worker), co_await future (resume on
+ * worker, which complete task), co_await pool.wait_async() and co_await threads::wait(lusem) without
+ * blocking threads. Coroutine handle is passed as task or waiter argument, so resume don't allocate.
+ */
+
+namespace threads {
+
+template <class R>
+class future;
+
+/* callables and results up to task_inline_size bytes are stored in task cell without allocation */
+static const std::size_t task_inline_size = 48;
+
+namespace detail {
+
+/* value storage: inline, if fits, else allocated */
+template <class T, bool Inline = (sizeof(T) <= task_inline_size &&
+	alignof(T) <= alignof(std::max_align_t) && std::is_nothrow_move_constructible<T>::value)>
+struct task_box {
+	template <class... A>
+	static void create(unsigned char *s, A &&...a) {
+		::new (static_cast<void *>(s)) T(std::forward<A>(a)...);
+	}
+	static T &get(unsigned char *s) {
+		return *reinterpret_cast<T *>(s);
+	}
+	static void destroy(unsigned char *s) {
+		get(s).~T();
+	}
+};
+
+template <class T>
+struct task_box<T, false> {
+	template <class... A>
+	static void create(unsigned char *s, A &&...a) {
+		*reinterpret_cast<T **>(s) = new T(std::forward<A>(a)...);
+	}
+	static T &get(unsigned char *s) {
+		return **reinterpret_cast<T **>(s);
+	}
+	static void destroy(unsigned char *s) {
+		delete *reinterpret_cast<T **>(s);
+	}
+};
+
+/* task cell states (futex word) */
+enum {
+	TASK_PENDING = 0,
+	TASK_DONE = 1,
+	TASK_WAITING = 2, /* pending, future wait on futex */
+	TASK_AWAITING = 3 /* pending, continuation is set */
+};
+
+struct task_cell {
+	void (*run)(task_cell *c); /* run and destroy callable, store result or exception */
+	void (*drop)(task_cell *c); /* destroy callable (if task is not run) or result */
+	objpool_t pool; /* NULL - allocated */
+	std::uint32_t state;
+	int refs; /* task and future */
+	bool detached; /* without future, exception terminate process */
+	void (*cont)(void *arg); /* continuation (awaiting coroutine resume) */
+	void *cont_arg;
+	std::exception_ptr error;
+	alignas(std::max_align_t) unsigned char storage[task_inline_size];
+};
+
+inline task_cell *task_cell_new(objpool_t pool, int refs) {
+	void *p = objpool_get(pool);
+	task_cell *c;
+	if (p == nullptr) {
+		p = ::operator new(sizeof(task_cell));
+		pool = nullptr;
+	}
+	c = ::new (p) task_cell;
+	c->drop = nullptr;
+	c->pool = pool;
+	c->state = TASK_PENDING;
+	c->refs = refs;
+	c->detached = refs == 1;
+	return c;
+}
+
+inline void task_cell_release(task_cell *c) {
+	objpool_t pool;
+	if (__atomic_sub_fetch(&c->refs, 1, __ATOMIC_ACQ_REL) != 0)
+		return;
+	if (c->drop)
+		c->drop(c);
+	pool = c->pool;
+	c->~task_cell();
+	if (pool) {
+		objpool_put(pool, c);
+	} else {
+		::operator delete(c);
+	}
+}
+
+inline void task_cell_wait(task_cell *c) {
+	std::uint32_t state = __atomic_load_n(&c->state, __ATOMIC_ACQUIRE);
+	while (state != TASK_DONE) {
+		if (state == TASK_PENDING && !__atomic_compare_exchange_n(&c->state, &state, TASK_WAITING, false,
+				__ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+			continue;
+		}
+		futex_wait(&c->state, TASK_WAITING);
+		state = __atomic_load_n(&c->state, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* pool task function */
+inline void task_cell_invoke(void *p) {
+	task_cell *c = static_cast<task_cell *>(p);
+	c->run(c);
+	if (c->detached && c->error)
+		std::terminate();
+	/* wake future only if it wait */
+	switch (__atomic_exchange_n(&c->state, TASK_DONE, __ATOMIC_ACQ_REL)) {
+	case TASK_WAITING:
+		futex_wake(&c->state, INT_MAX);
+		break;
+	case TASK_AWAITING:
+		c->cont(c->cont_arg);
+		break;
+	}
+	task_cell_release(c);
+}
+
+template <class Fn, class R>
+struct task_impl {
+	static void run(task_cell *c) {
+		bool destroyed = false;
+		try {
+			R r(task_box<Fn>::get(c->storage)());
+			task_box<Fn>::destroy(c->storage);
+			destroyed = true;
+			task_box<R>::create(c->storage, std::move(r));
+			c->drop = drop_result;
+		} catch (...) {
+			if (!destroyed)
+				task_box<Fn>::destroy(c->storage);
+			c->drop = nullptr;
+			c->error = std::current_exception();
+		}
+	}
+	static void drop_result(task_cell *c) {
+		task_box<R>::destroy(c->storage);
+	}
+	static void drop_callable(task_cell *c) {
+		task_box<Fn>::destroy(c->storage);
+	}
+};
+
+template <class Fn>
+struct task_impl<Fn, void> {
+	static void run(task_cell *c) {
+		try {
+			task_box<Fn>::get(c->storage)();
+		} catch (...) {
+			c->error = std::current_exception();
+		}
+		task_box<Fn>::destroy(c->storage);
+		c->drop = nullptr;
+	}
+	static void drop_callable(task_cell *c) {
+		task_box<Fn>::destroy(c->storage);
+	}
+};
+
+struct thpool_traits {
+	typedef thpool_t handle_type;
+	static handle_type create(const pool_attr_t *attr) { return thpool_create_ex(attr); }
+	static int add_task(handle_type p, void (*f)(void *), void *arg) { return thpool_add_task(p, f, arg); }
+	static void wait(handle_type p) { thpool_wait(p); }
+	static void pause(handle_type p) { thpool_pause(p); }
+	static void resume(handle_type p) { thpool_resume(p); }
+	static std::size_t workers(handle_type p) { return thpool_workers_count(p); }
+	static std::size_t active_tasks(handle_type p) { return thpool_active_tasks(p); }
+	static int wait_async(handle_type p, pool_idle_waiter_t *w) { return thpool_wait_async(p, w); }
+	static void destroy(handle_type p) { thpool_destroy(p); }
+};
+
+struct lfthpool_traits {
+	typedef lfthpool_t handle_type;
+	static handle_type create(const pool_attr_t *attr) { return lfthpool_create_ex(attr); }
+	static int add_task(handle_type p, void (*f)(void *), void *arg) { return lfthpool_add_task(p, f, arg); }
+	static void wait(handle_type p) { lfthpool_wait(p); }
+	static void pause(handle_type p) { lfthpool_pause(p); }
+	static void resume(handle_type p) { lfthpool_resume(p); }
+	static std::size_t workers(handle_type p) { return lfthpool_workers_count(p); }
+	static std::size_t active_tasks(handle_type p) { return lfthpool_active_tasks(p); }
+	static int wait_async(handle_type p, pool_idle_waiter_t *w) { return lfthpool_wait_async(p, w); }
+	static void destroy(handle_type p) { lfthpool_destroy(p); }
+};
+
+/* max preallocated task cells */
+static const std::size_t task_cells_max = 65536;
+
+#ifdef THREADS_COROUTINES
+
+inline void coro_resume(void *p) {
+	std::coroutine_handle<>::from_address(p).resume();
+}
+
+/* resume on pool worker */
+template <class Traits>
+class schedule_awaitable {
+public:
+	explicit schedule_awaitable(typename Traits::handle_type pool) noexcept : pool_(pool) {}
+	bool await_ready() const noexcept { return false; }
+	/* resume in caller, if queue is full */
+	bool await_suspend(std::coroutine_handle<> h) noexcept {
+		return Traits::add_task(pool_, coro_resume, h.address()) == 0;
+	}
+	void await_resume() const noexcept {}
+
+private:
+	typename Traits::handle_type pool_;
+};
+
+/* resume, when all pool tasks done */
+template <class Traits>
+class idle_awaitable {
+public:
+	explicit idle_awaitable(typename Traits::handle_type pool) noexcept : pool_(pool) {}
+	bool await_ready() const noexcept { return false; }
+	bool await_suspend(std::coroutine_handle<> h) noexcept {
+		w_.wake = coro_resume;
+		w_.arg = h.address();
+		return Traits::wait_async(pool_, &w_) != 0;
+	}
+	void await_resume() const noexcept {}
+
+private:
+	typename Traits::handle_type pool_;
+	pool_idle_waiter_t w_;
+};
+
+/* resume, when task done */
+template <class R>
+class future_awaitable {
+public:
+	explicit future_awaitable(future<R> &f) noexcept : f_(f) {}
+	bool await_ready() const noexcept { return f_.ready(); }
+	bool await_suspend(std::coroutine_handle<> h) noexcept {
+		task_cell *c = f_.cell_;
+		std::uint32_t state = TASK_PENDING;
+		c->cont = coro_resume;
+		c->cont_arg = h.address();
+		/* task can be done already */
+		return __atomic_compare_exchange_n(&c->state, &state, TASK_AWAITING, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+	}
+	R await_resume() { return f_.get(); }
+
+private:
+	future<R> &f_;
+};
+
+/* acquire lusem permit */
+class lusem_awaitable {
+public:
+	explicit lusem_awaitable(lusem_t &sem) noexcept : sem_(&sem) {}
+	bool await_ready() const noexcept { return lusem_try_wait(sem_) == 0; }
+	/* throws std::system_error, if semaphore is not fair */
+	bool await_suspend(std::coroutine_handle<> h) {
+		int rc = lusem_wait_async(sem_, &w_, coro_resume, h.address());
+		if (rc < 0)
+			throw std::system_error(errno, std::generic_category(), "lusem async wait");
+		return rc == 1;
+	}
+	void await_resume() const noexcept {}
+
+private:
+	lusem_t *sem_;
+	lusem_waiter_t w_;
+};
+
+#endif /* THREADS_COROUTINES */
+
+} // namespace detail
+
+/**
+ * @brief  Task result (move-only, must be released before pool destroy)
+ */
+template <class R>
+class future {
+public:
+	future() noexcept : cell_(nullptr) {}
+	explicit future(detail::task_cell *c) noexcept : cell_(c) {}
+	future(future &&other) noexcept : cell_(other.cell_) { other.cell_ = nullptr; }
+	future &operator=(future &&other) noexcept {
+		if (this != &other) {
+			reset();
+			cell_ = other.cell_;
+			other.cell_ = nullptr;
+		}
+		return *this;
+	}
+	future(const future &) = delete;
+	future &operator=(const future &) = delete;
+	~future() { reset(); }
+
+	/* future has task */
+	bool valid() const noexcept { return cell_ != nullptr; }
+
+	/* task is done */
+	bool ready() const noexcept { return __atomic_load_n(&cell_->state, __ATOMIC_ACQUIRE) == detail::TASK_DONE; }
+
+	/* wait for task done */
+	void wait() const { detail::task_cell_wait(cell_); }
+
+	/* wait for task done and get result (or rethrow task exception), future is invalid after */
+	R get() {
+		detail::task_cell *c = cell_;
+		cell_ = nullptr;
+		detail::task_cell_wait(c);
+		if (c->error) {
+			std::exception_ptr e = c->error;
+			detail::task_cell_release(c);
+			std::rethrow_exception(e);
+		}
+		R r(std::move(detail::task_box<R>::get(c->storage)));
+		detail::task_cell_release(c);
+		return r;
+	}
+
+#ifdef THREADS_COROUTINES
+	/* resume coroutine in worker, which complete task, and get result */
+	detail::future_awaitable<R> operator co_await() noexcept { return detail::future_awaitable<R>(*this); }
+#endif
+
+private:
+#ifdef THREADS_COROUTINES
+	friend class detail::future_awaitable<R>;
+#endif
+
+	void reset() noexcept {
+		if (cell_) {
+			detail::task_cell_release(cell_);
+			cell_ = nullptr;
+		}
+	}
+
+	detail::task_cell *cell_;
+};
+
+template <>
+inline void future<void>::get() {
+	detail::task_cell *c = cell_;
+	std::exception_ptr e;
+	cell_ = nullptr;
+	detail::task_cell_wait(c);
+	e = c->error;
+	detail::task_cell_release(c);
+	if (e)
+		std::rethrow_exception(e);
+}
+
+/**
+ * @brief  Thread pool (Traits select C pool)
+ */
+template <class Traits>
+class basic_thread_pool {
+public:
+	typedef typename Traits::handle_type native_handle_type;
+
+	/* throws std::system_error on error */
+	basic_thread_pool(std::size_t workers, std::size_t queue_size) {
+		pool_attr_t attr;
+		pool_attr_init(&attr, workers, queue_size);
+		init(attr);
+	}
+
+	explicit basic_thread_pool(const pool_attr_t &attr) { init(attr); }
+
+	basic_thread_pool(const basic_thread_pool &) = delete;
+	basic_thread_pool &operator=(const basic_thread_pool &) = delete;
+
+	/* wait for queued tasks */
+	~basic_thread_pool() {
+		Traits::destroy(pool_);
+		objpool_destroy(cells_);
+	}
+
+	/**
+	 * @brief  Submit task
+	 * @param  f   Callable without arguments
+	 * @retval     Future for result
+	 * @throws     std::system_error (resource_unavailable_try_again), if queue is full (callable is destroyed)
+	 */
+	template <class F, class Fn = typename std::decay<F>::type, class R = decltype(std::declval<Fn &>()())>
+	future<R> submit(F &&f) {
+		detail::task_cell *c = enqueue<Fn, R>(std::forward<F>(f), 2);
+		if (c == nullptr)
+			throw std::system_error(std::make_error_code(std::errc::resource_unavailable_try_again), "task queue is full");
+		return future<R>(c);
+	}
+
+	/**
+	 * @brief  Submit task without result (exception, thrown by task, terminate process)
+	 * @param  f   Callable without arguments
+	 * @retval     true on success or false, if queue is full (callable is destroyed)
+	 */
+	template <class F, class Fn = typename std::decay<F>::type>
+	bool post(F &&f) {
+		return enqueue<Fn, void>(std::forward<F>(f), 1) != nullptr;
+	}
+
+	void wait() { Traits::wait(pool_); }
+	void pause() { Traits::pause(pool_); }
+	void resume() { Traits::resume(pool_); }
+	std::size_t workers() const { return Traits::workers(pool_); }
+	std::size_t active_tasks() const { return Traits::active_tasks(pool_); }
+	native_handle_type native_handle() const noexcept { return pool_; }
+
+#ifdef THREADS_COROUTINES
+	/* co_await pool.schedule() resume coroutine on pool worker (in caller, if queue is full) */
+	detail::schedule_awaitable<Traits> schedule() noexcept { return detail::schedule_awaitable<Traits>(pool_); }
+
+	/* co_await pool.wait_async() resume coroutine, when all tasks done (without blocking thread) */
+	detail::idle_awaitable<Traits> wait_async() noexcept { return detail::idle_awaitable<Traits>(pool_); }
+#endif
+
+private:
+	void init(const pool_attr_t &attr) {
+		/* queued and running tasks, cells cached in workers and submitter magazines */
+		std::size_t n = attr.queue_size + attr.workers + (attr.workers + 1) * OBJPOOL_MAGAZINE;
+		if ((pool_ = Traits::create(&attr)) == nullptr)
+			throw std::system_error(errno, std::generic_category(), "pool create");
+		if ((cells_ = objpool_create(sizeof(detail::task_cell), n < detail::task_cells_max ? n : detail::task_cells_max)) == nullptr) {
+			int err = errno;
+			Traits::destroy(pool_);
+			throw std::system_error(err, std::generic_category(), "task cells create");
+		}
+	}
+
+	/* returns cell or nullptr, if queue is full */
+	template <class Fn, class R, class F>
+	detail::task_cell *enqueue(F &&f, int refs) {
+		detail::task_cell *c = detail::task_cell_new(cells_, refs);
+		try {
+			detail::task_box<Fn>::create(c->storage, std::forward<F>(f));
+		} catch (...) {
+			c->refs = 1;
+			detail::task_cell_release(c);
+			throw;
+		}
+		c->run = detail::task_impl<Fn, R>::run;
+		if (Traits::add_task(pool_, detail::task_cell_invoke, c) != 0) {
+			c->refs = 1;
+			c->drop = detail::task_impl<Fn, R>::drop_callable;
+			detail::task_cell_release(c);
+			return nullptr;
+		}
+		return c;
+	}
+
+	native_handle_type pool_;
+	objpool_t cells_;
+};
+
+/* mutex-locked pool (thpool_t) */
+typedef basic_thread_pool<detail::thpool_traits> thread_pool;
+
+/* lock-free pool (lfthpool_t) */
+typedef basic_thread_pool<detail::lfthpool_traits> lf_thread_pool;
+
+#ifdef THREADS_COROUTINES
+/* co_await threads::wait(sem) acquire permit without blocking thread (semaphore must be inited with lusem_init_fair),
+ * coroutine is resumed in signaling thread */
+inline detail::lusem_awaitable wait(lusem_t &sem) noexcept {
+	return detail::lusem_awaitable(sem);
+}
+#endif
+
+} // namespace threads
+
+#endif /* _THREADS_THREAD_POOL_HPP_ */
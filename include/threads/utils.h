@@ -15,4 +15,17 @@
  */
 int threads_cpu_count();
 
+/**
+ * @brief  Hint to cpu in spin-wait loop
+ */
+static inline void threads_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__)
+	__asm__ __volatile__("yield" ::: "memory");
+#else
+	__atomic_signal_fence(__ATOMIC_SEQ_CST);
+#endif
+}
+
 #endif /* _THREADS_UTILS_H_ */
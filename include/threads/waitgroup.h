@@ -0,0 +1,98 @@
+#ifndef _THREADS_WAITGROUP_H_
+#define _THREADS_WAITGROUP_H_
+
+#include <stdint.h>
+
+/**
+ * @file
+*
+* Public header
+*/
+
+/* Wait group (one 32-bit futex word, no mutex): reusable counter of pending jobs, like Go sync.WaitGroup */
+
+#define WAITGROUP_INLINE static inline
+
+#define WAITGROUP_COUNT_MASK 0x7FFFFFFFu
+#define WAITGROUP_WAITERS    0x80000000u /* may be waiters */
+
+/**
+ * @brief   Wait group
+ * @typedef waitgroup_t
+ */
+typedef struct waitgroup {
+	uint32_t state;
+} waitgroup_t;
+
+/**
+ * @brief       Init wait group
+ * @param  wg   Wait group
+ */
+WAITGROUP_INLINE void waitgroup_init(waitgroup_t *wg) {
+	wg->state = 0;
+}
+
+/**
+ * @brief       Destroy wait group
+ * @param  wg   Wait group
+ */
+WAITGROUP_INLINE void waitgroup_destroy(waitgroup_t *wg) {
+	(void) wg;
+}
+
+void waitgroup_wake(waitgroup_t *wg);
+
+/**
+ * @brief        Add delta to jobs counter (wake all waiters, when counter reach zero)
+ * @param  wg    Wait group
+ * @param  delta Delta (counter must not be negative)
+ */
+WAITGROUP_INLINE void waitgroup_add(waitgroup_t *wg, int delta) {
+	uint32_t s = __atomic_add_fetch(&wg->state, (uint32_t) delta, __ATOMIC_ACQ_REL);
+	if (s == WAITGROUP_WAITERS)
+		waitgroup_wake(wg);
+}
+
+/**
+ * @brief        Mark job as done (decrement jobs counter)
+ * @param  wg    Wait group
+ */
+WAITGROUP_INLINE void waitgroup_done(waitgroup_t *wg) {
+	waitgroup_add(wg, -1);
+}
+
+/**
+ * @brief       Check jobs counter without wait
+ * @param  wg   Wait group
+ * @retval      0 - counter is zero, -1 - counter is not zero
+ */
+WAITGROUP_INLINE int waitgroup_try_wait(waitgroup_t *wg) {
+	return (__atomic_load_n(&wg->state, __ATOMIC_ACQUIRE) & WAITGROUP_COUNT_MASK) == 0 ? 0 : -1;
+}
+
+int waitgroup_wait_slow(waitgroup_t *wg, uint64_t timeout_usecs);
+
+/**
+ * @brief       Wait until jobs counter reach zero
+ * @param  wg   Wait group
+ */
+WAITGROUP_INLINE void waitgroup_wait(waitgroup_t *wg) {
+	if (waitgroup_try_wait(wg) != 0)
+		waitgroup_wait_slow(wg, 0);
+}
+
+/**
+ * @brief       Wait until jobs counter reach zero with timeout
+ * @param  wg   Wait group
+ * @param  timeout_usecs Timeout (microseconds)
+ * @retval      0 - on success, -1 - on timeout (errno is ETIMEDOUT)
+ */
+WAITGROUP_INLINE int waitgroup_timed_wait(waitgroup_t *wg, uint64_t timeout_usecs) {
+	if (waitgroup_try_wait(wg) == 0)
+		return 0;
+	return waitgroup_wait_slow(wg, timeout_usecs);
+}
+
+#undef WAITGROUP_INLINE
+
+#endif /* _THREADS_WAITGROUP_H_ */
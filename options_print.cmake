@@ -11,6 +11,7 @@ message(STATUS "  Install prefix : ${CMAKE_INSTALL_PREFIX}")
 message(STATUS "  Binary dir     : ${BINDIR}")
 message(STATUS "  Lib dir        : ${LIBDIR}")
 message(STATUS "  Version        : ${VERSION}")
+message(STATUS "  thpool lock    : ${THPOOL_LOCK}")
 message(STATUS "")
 if(CMAKE_BUILD_TYPE STREQUAL "Plain")
     message(STATUS "CMAKE_CXX_FLAGS            : ${CMAKE_CXX_FLAGS}")
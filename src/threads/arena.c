@@ -0,0 +1,89 @@
+#include <errno.h>
+#include <stdlib.h>
+
+#include <threads/arena.h>
+
+static inline size_t arena_chunk_cap(const arena_chunk_t *c) {
+	return (size_t) (c->end - ((const char *) c + ARENA_CHUNK_HDR));
+}
+
+void arena_init(arena_t *a, size_t chunk_size) {
+	a->pos = NULL;
+	a->end = NULL;
+	a->chunk = NULL;
+	a->first = NULL;
+	a->chunk_size = chunk_size ? chunk_size : ARENA_CHUNK_SIZE;
+}
+
+static void arena_free_chunks(arena_chunk_t *c) {
+	arena_chunk_t *next;
+	for (; c; c = next) {
+		next = c->next;
+		free(c);
+	}
+}
+
+void arena_destroy(arena_t *a) {
+	arena_free_chunks(a->first);
+	arena_init(a, a->chunk_size);
+}
+
+void *arena_alloc_slow(arena_t *a, size_t size) {
+	arena_chunk_t *c = a->chunk ? a->chunk->next : a->first, *prev = a->chunk;
+	size_t cap;
+	char *p;
+
+	if (size > SIZE_MAX - ARENA_CHUNK_HDR) {
+		/* chunk size overflow */
+		errno = ENOMEM;
+		return NULL;
+	}
+	/* reuse kept chunks (too small ones are skipped until next reset) */
+	for (; c; prev = c, c = c->next) {
+		if (arena_chunk_cap(c) >= size)
+			break;
+	}
+	if (c == NULL) {
+		cap = size > a->chunk_size ? size : a->chunk_size;
+		if ((c = (arena_chunk_t *) malloc(ARENA_CHUNK_HDR + cap)) == NULL) {
+			errno = ENOMEM;
+			return NULL;
+		}
+		c->end = (char *) c + ARENA_CHUNK_HDR + cap;
+		/* insert after current chunk */
+		if (prev) {
+			c->next = prev->next;
+			prev->next = c;
+		} else {
+			c->next = a->first;
+			a->first = c;
+		}
+	}
+	a->chunk = c;
+	p = (char *) c + ARENA_CHUNK_HDR;
+	a->pos = p + size;
+	a->end = c->end;
+	return p;
+}
+
+void arena_shrink(arena_t *a) {
+	if (a->first) {
+		if (arena_chunk_cap(a->first) > a->chunk_size) {
+			/* first chunk is oversized by large allocation */
+			arena_destroy(a);
+			return;
+		}
+		arena_free_chunks(a->first->next);
+		a->first->next = NULL;
+		arena_reset(a);
+	}
+}
+
+size_t arena_size(const arena_t *a) {
+	const arena_chunk_t *c;
+	size_t size = 0;
+	for (c = a->first; c; c = c->next) {
+		size += arena_chunk_cap(c);
+	}
+	return size;
+}
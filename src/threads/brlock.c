@@ -0,0 +1,82 @@
+#include <errno.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/brlock.h>
+#include <threads/futex.h>
+#include <threads/utils.h>
+
+static size_t brlock_threads = 0;
+static __thread size_t brlock_thread_id = 0; /* 0 - not assigned */
+
+static size_t brlock_slot(brlock_t *l) {
+	if (brlock_thread_id == 0) {
+		brlock_thread_id = __atomic_add_fetch(&brlock_threads, 1, __ATOMIC_RELAXED);
+	}
+	return (brlock_thread_id - 1) % l->nslots;
+}
+
+int brlock_init(brlock_t *l, size_t nslots) {
+	void *slots;
+	int err;
+	if (nslots < 1) {
+		nslots = (size_t) threads_cpu_count();
+		if (nslots < 1)
+			nslots = 1;
+	}
+	if ((err = posix_memalign(&slots, BRLOCK_CACHE_LINE, nslots * sizeof(brlock_slot_t))) != 0) {
+		errno = err;
+		return -1;
+	}
+	memset(slots, 0, nslots * sizeof(brlock_slot_t));
+	l->slots = (brlock_slot_t *) slots;
+	l->nslots = nslots;
+	l->writer = 0;
+	return 0;
+}
+
+void brlock_destroy(brlock_t *l) {
+	free(l->slots);
+	l->slots = NULL;
+	l->nslots = 0;
+}
+
+size_t brlock_rdlock(brlock_t *l) {
+	size_t slot = brlock_slot(l);
+	uint32_t w;
+	while (1) {
+		__atomic_add_fetch(&l->slots[slot].readers, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&l->writer, __ATOMIC_SEQ_CST) == 0)
+			return slot;
+		/* writer holds or acquire lock, back off */
+		__atomic_sub_fetch(&l->slots[slot].readers, 1, __ATOMIC_RELEASE);
+		w = __atomic_load_n(&l->writer, __ATOMIC_RELAXED);
+		while (w != 0) {
+			if (w == 2 || __atomic_compare_exchange_n(&l->writer, &w, 2, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				futex_wait(&l->writer, 2);
+			w = __atomic_load_n(&l->writer, __ATOMIC_RELAXED);
+		}
+	}
+}
+
+void brlock_wrlock(brlock_t *l) {
+	size_t i;
+	uint32_t w = 0;
+	/* serialize writers */
+	if (!__atomic_compare_exchange_n(&l->writer, &w, 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+		while (__atomic_exchange_n(&l->writer, 2, __ATOMIC_SEQ_CST) != 0)
+			futex_wait(&l->writer, 2);
+	}
+	/* wait for readers drain */
+	for (i = 0; i < l->nslots; i++) {
+		while (__atomic_load_n(&l->slots[i].readers, __ATOMIC_ACQUIRE) != 0)
+			sched_yield();
+	}
+}
+
+void brlock_wrunlock(brlock_t *l) {
+	if (__atomic_exchange_n(&l->writer, 0, __ATOMIC_RELEASE) == 2)
+		futex_wake(&l->writer, INT_MAX);
+}
@@ -0,0 +1,412 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/chan.h>
+#include <threads/eventcount.h>
+
+#include "deadline.h"
+
+#define CHAN_CACHE_LINE 64
+
+/* closed flag in enqueue position, so enqueue after close is impossible */
+#define CHAN_CLOSED ((size_t) 1 << (sizeof(size_t) * 8 - 1))
+
+enum {
+	CHAN_OK = 0,
+	CHAN_FULL = 1,
+	CHAN_EMPTY = 1,
+	CHAN_CLOSE = 2
+};
+
+/**
+ * Ring slot header (followed by message)
+ *
+ * For position pos (lap is pos / ring_size) slot is free for enqueue, when seq is 2 * lap,
+ * and ready for dequeue, when seq is 2 * lap + 1 (work for any ring size, also for 1).
+ */
+typedef struct chan_slot {
+	size_t seq;
+} chan_slot_t;
+
+struct chan {
+	size_t elem_size;
+	size_t capacity; /* 0 for unbuffered */
+	size_t ring_size; /* slots count */
+	size_t stride; /* slot size */
+	char *slots;
+	uint32_t selecters; /* chan_select waiters */
+	uint32_t recv_selecters; /* chan_select waiters with receive case */
+	eventcount_t send_ec; /* senders wait for free slot (or for receiver on unbuffered channel) */
+	eventcount_t recv_ec; /* receivers wait for message */
+	char pad1[CHAN_CACHE_LINE];
+	size_t enqueue_pos;
+	char pad2[CHAN_CACHE_LINE - sizeof(size_t)];
+	size_t dequeue_pos;
+	char pad3[CHAN_CACHE_LINE - sizeof(size_t)];
+};
+
+/* chan_select waiters sleep here, channel notify it only if select waits on it */
+static eventcount_t chan_select_ec;
+
+static __thread uint32_t chan_select_seed;
+
+static inline chan_slot_t *chan_slot(chan_t ch, size_t pos, size_t *turn) {
+	size_t lap = pos / ch->ring_size;
+	*turn = 2 * lap;
+	return (chan_slot_t *) (ch->slots + (pos - lap * ch->ring_size) * ch->stride);
+}
+
+static int chan_enqueue(chan_t ch, const void *data, size_t *ppos) {
+	chan_slot_t *slot;
+	size_t seq, turn;
+	size_t pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+	while (1) {
+		if (pos & CHAN_CLOSED)
+			return CHAN_CLOSE;
+		slot = chan_slot(ch, pos, &turn);
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq == turn) {
+			if (__atomic_compare_exchange_n(&ch->enqueue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if ((intptr_t) (seq - turn) < 0) {
+			/* message from previous lap is not dequeued */
+			return CHAN_FULL;
+		} else {
+			pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	memcpy(slot + 1, data, ch->elem_size);
+	__atomic_store_n(&slot->seq, turn + 1, __ATOMIC_RELEASE);
+	if (ppos)
+		*ppos = pos;
+	return CHAN_OK;
+}
+
+static int chan_dequeue(chan_t ch, void *data) {
+	chan_slot_t *slot;
+	size_t seq, turn;
+	size_t pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+	while (1) {
+		slot = chan_slot(ch, pos, &turn);
+		seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+		if (seq == turn + 1) {
+			if (__atomic_compare_exchange_n(&ch->dequeue_pos, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if ((intptr_t) (seq - (turn + 1)) < 0) {
+			/* empty, check for closed and drained (no in-flight enqueue) */
+			if (__atomic_load_n(&ch->enqueue_pos, __ATOMIC_ACQUIRE) == (CHAN_CLOSED | pos))
+				return CHAN_CLOSE;
+			return CHAN_EMPTY;
+		} else {
+			pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_RELAXED);
+		}
+	}
+	memcpy(data, slot + 1, ch->elem_size);
+	__atomic_store_n(&slot->seq, turn + 2, __ATOMIC_RELEASE);
+	return CHAN_OK;
+}
+
+/* wake waiters on channel eventcount (count < 0 - wake all) and select waiters */
+static void chan_notify(chan_t ch, eventcount_t *ec, int count) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (ec && __atomic_load_n(&ec->waiters, __ATOMIC_RELAXED))
+		eventcount_wake(ec, count);
+	if (__atomic_load_n(&ch->selecters, __ATOMIC_RELAXED))
+		eventcount_notify_all(&chan_select_ec);
+}
+
+/* for unbuffered channel: is receiver waits */
+static int chan_has_receiver(chan_t ch) {
+	return __atomic_load_n(&ch->recv_ec.waiters, __ATOMIC_ACQUIRE) ||
+		__atomic_load_n(&ch->recv_selecters, __ATOMIC_ACQUIRE);
+}
+
+static int chan_wait(eventcount_t *ec, uint32_t key, uint64_t deadline) {
+	uint64_t remain;
+	if (deadline == 0) {
+		eventcount_commit_wait(ec, key);
+		return 0;
+	}
+	if ((remain = deadline_remain(deadline)) == 0) {
+		eventcount_cancel_wait(ec);
+		errno = ETIMEDOUT;
+		return -1;
+	}
+	return eventcount_commit_timed_wait(ec, key, remain);
+}
+
+chan_t chan_create(size_t elem_size, size_t capacity) {
+	chan_t ch;
+	size_t i;
+	void *p;
+	int err;
+
+	if (elem_size == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((err = posix_memalign(&p, CHAN_CACHE_LINE, sizeof(struct chan))) != 0) {
+		errno = err;
+		return NULL;
+	}
+	ch = (chan_t) p;
+	memset(ch, 0, sizeof(struct chan));
+	ch->elem_size = elem_size;
+	ch->capacity = capacity;
+	ch->ring_size = capacity ? capacity : 1;
+	ch->stride = (sizeof(chan_slot_t) + elem_size + sizeof(size_t) - 1) & ~(sizeof(size_t) - 1);
+	if ((ch->slots = (char *) malloc(ch->ring_size * ch->stride)) == NULL) {
+		free(ch);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (i = 0; i < ch->ring_size; i++) {
+		((chan_slot_t *) (ch->slots + i * ch->stride))->seq = 0;
+	}
+	eventcount_init(&ch->send_ec);
+	eventcount_init(&ch->recv_ec);
+	return ch;
+}
+
+void chan_destroy(chan_t ch) {
+	if (ch) {
+		free(ch->slots);
+		free(ch);
+	}
+}
+
+void chan_close(chan_t ch) {
+	__atomic_fetch_or(&ch->enqueue_pos, CHAN_CLOSED, __ATOMIC_SEQ_CST);
+	chan_notify(ch, &ch->send_ec, -1);
+	eventcount_notify_all(&ch->recv_ec);
+}
+
+int chan_is_closed(chan_t ch) {
+	return (__atomic_load_n(&ch->enqueue_pos, __ATOMIC_ACQUIRE) & CHAN_CLOSED) ? 1 : 0;
+}
+
+size_t chan_cap(chan_t ch) {
+	return ch->capacity;
+}
+
+size_t chan_len(chan_t ch) {
+	size_t dequeue_pos = __atomic_load_n(&ch->dequeue_pos, __ATOMIC_ACQUIRE);
+	size_t enqueue_pos = __atomic_load_n(&ch->enqueue_pos, __ATOMIC_ACQUIRE) & ~CHAN_CLOSED;
+	return enqueue_pos > dequeue_pos ? enqueue_pos - dequeue_pos : 0;
+}
+
+/*
+ * wait until receiver got message on unbuffered channel, returns 0 or error code (ETIMEDOUT, EPIPE),
+ * if message is withdrawn on timeout or close
+ */
+static int chan_wait_receiver(chan_t ch, size_t pos, uint64_t deadline) {
+	chan_slot_t *slot;
+	size_t turn, expected = pos;
+	uint32_t key;
+	int err = 0;
+
+	while (__atomic_load_n(&ch->dequeue_pos, __ATOMIC_ACQUIRE) <= pos) {
+		key = eventcount_prepare_wait(&ch->send_ec);
+		if (__atomic_load_n(&ch->dequeue_pos, __ATOMIC_SEQ_CST) > pos) {
+			eventcount_cancel_wait(&ch->send_ec);
+			break;
+		}
+		if (chan_is_closed(ch)) {
+			eventcount_cancel_wait(&ch->send_ec);
+			err = EPIPE;
+			break;
+		}
+		if (chan_wait(&ch->send_ec, key, deadline) == -1) {
+			err = ETIMEDOUT;
+			break;
+		}
+	}
+	if (err == 0)
+		return 0;
+	/* withdraw message: dequeue it as receiver, only one message is in flight (ring size is 1) */
+	if (!__atomic_compare_exchange_n(&ch->dequeue_pos, &expected, pos + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+		return 0; /* receiver got message */
+	slot = chan_slot(ch, pos, &turn);
+	__atomic_store_n(&slot->seq, turn + 2, __ATOMIC_RELEASE);
+	/* slot is free, wake other senders */
+	chan_notify(ch, &ch->send_ec, -1);
+	return err;
+}
+
+static int chan_send_(chan_t ch, const void *data, int block, uint64_t deadline) {
+	uint32_t key;
+	size_t pos;
+	int ret;
+
+	if (!block && ch->capacity == 0 && !chan_has_receiver(ch)) {
+		if (chan_is_closed(ch)) {
+			errno = EPIPE;
+		} else {
+			errno = EAGAIN;
+		}
+		return -1;
+	}
+	while ((ret = chan_enqueue(ch, data, &pos)) == CHAN_FULL) {
+		if (!block) {
+			errno = EAGAIN;
+			return -1;
+		}
+		key = eventcount_prepare_wait(&ch->send_ec);
+		if ((ret = chan_enqueue(ch, data, &pos)) != CHAN_FULL) {
+			eventcount_cancel_wait(&ch->send_ec);
+			break;
+		}
+		if (chan_wait(&ch->send_ec, key, deadline) == -1)
+			return -1;
+	}
+	if (ret == CHAN_CLOSE) {
+		errno = EPIPE;
+		return -1;
+	}
+	chan_notify(ch, &ch->recv_ec, 1);
+	if (ch->capacity == 0 && block && (ret = chan_wait_receiver(ch, pos, deadline)) != 0) {
+		errno = ret;
+		return -1;
+	}
+	return 0;
+}
+
+static int chan_recv_(chan_t ch, void *data, int block, uint64_t deadline) {
+	uint32_t key;
+	int ret;
+
+	while ((ret = chan_dequeue(ch, data)) == CHAN_EMPTY) {
+		if (!block) {
+			errno = EAGAIN;
+			return -1;
+		}
+		key = eventcount_prepare_wait(&ch->recv_ec);
+		if ((ret = chan_dequeue(ch, data)) != CHAN_EMPTY) {
+			eventcount_cancel_wait(&ch->recv_ec);
+			break;
+		}
+		if (ch->capacity == 0) {
+			/* nonblocking senders and select wait for receiver on unbuffered channel */
+			chan_notify(ch, NULL, 0);
+		}
+		if (chan_wait(&ch->recv_ec, key, deadline) == -1)
+			return -1;
+	}
+	if (ret == CHAN_CLOSE) {
+		errno = EPIPE;
+		return -1;
+	}
+	/* unbuffered channel: wake sender, waited for receiver, with others */
+	chan_notify(ch, &ch->send_ec, ch->capacity ? 1 : -1);
+	return 0;
+}
+
+int chan_send(chan_t ch, const void *data) {
+	return chan_send_(ch, data, 1, 0);
+}
+
+int chan_try_send(chan_t ch, const void *data) {
+	return chan_send_(ch, data, 0, 0);
+}
+
+int chan_timed_send(chan_t ch, const void *data, uint64_t timeout_usecs) {
+	return chan_send_(ch, data, 1, deadline_after(timeout_usecs));
+}
+
+int chan_recv(chan_t ch, void *data) {
+	return chan_recv_(ch, data, 1, 0);
+}
+
+int chan_try_recv(chan_t ch, void *data) {
+	return chan_recv_(ch, data, 0, 0);
+}
+
+int chan_timed_recv(chan_t ch, void *data, uint64_t timeout_usecs) {
+	return chan_recv_(ch, data, 1, deadline_after(timeout_usecs));
+}
+
+/* try to complete one of cases, return index or -1 */
+static int chan_select_try(chan_case_t *cases, size_t n) {
+	size_t i, start;
+	int ret;
+	chan_case_t *c;
+
+	/* xorshift, random start for fairness */
+	if (chan_select_seed == 0)
+		chan_select_seed = (uint32_t) (uintptr_t) &chan_select_seed | 1;
+	chan_select_seed ^= chan_select_seed << 13;
+	chan_select_seed ^= chan_select_seed >> 17;
+	chan_select_seed ^= chan_select_seed << 5;
+	start = chan_select_seed % n;
+
+	for (i = 0; i < n; i++) {
+		c = &cases[(start + i) % n];
+		if (c->op == CHAN_SEND) {
+			ret = chan_send_(c->ch, c->data, 0, 0);
+		} else {
+			ret = chan_recv_(c->ch, c->data, 0, 0);
+		}
+		if (ret == 0) {
+			c->err = 0;
+			return (int) ((start + i) % n);
+		} else if (errno == EPIPE) {
+			c->err = EPIPE;
+			return (int) ((start + i) % n);
+		}
+	}
+	return -1;
+}
+
+static int chan_select_(chan_case_t *cases, size_t n, int block, uint64_t deadline) {
+	uint32_t key;
+	size_t i;
+	int idx, ret;
+
+	if (n == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	while (1) {
+		if ((idx = chan_select_try(cases, n)) >= 0)
+			return idx;
+		if (!block) {
+			errno = EAGAIN;
+			return -1;
+		}
+		key = eventcount_prepare_wait(&chan_select_ec);
+		for (i = 0; i < n; i++) {
+			__atomic_add_fetch(&cases[i].ch->selecters, 1, __ATOMIC_SEQ_CST);
+			if (cases[i].op == CHAN_RECV) {
+				__atomic_add_fetch(&cases[i].ch->recv_selecters, 1, __ATOMIC_SEQ_CST);
+				if (cases[i].ch->capacity == 0) {
+					/* receiver waits, wake nonblocking senders on unbuffered channel */
+					chan_notify(cases[i].ch, NULL, 0);
+				}
+			}
+		}
+		if ((idx = chan_select_try(cases, n)) == -1) {
+			ret = chan_wait(&chan_select_ec, key, deadline);
+		} else {
+			eventcount_cancel_wait(&chan_select_ec);
+			ret = 0;
+		}
+		for (i = 0; i < n; i++) {
+			if (cases[i].op == CHAN_RECV)
+				__atomic_sub_fetch(&cases[i].ch->recv_selecters, 1, __ATOMIC_RELAXED);
+			__atomic_sub_fetch(&cases[i].ch->selecters, 1, __ATOMIC_RELAXED);
+		}
+		if (idx >= 0)
+			return idx;
+		if (ret == -1)
+			return -1;
+	}
+}
+
+int chan_select(chan_case_t *cases, size_t n, int block) {
+	return chan_select_(cases, n, block, 0);
+}
+
+int chan_timed_select(chan_case_t *cases, size_t n, uint64_t timeout_usecs) {
+	return chan_select_(cases, n, 1, deadline_after(timeout_usecs));
+}
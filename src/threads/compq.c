@@ -0,0 +1,201 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+#include <threads/compq.h>
+#include <threads/mpsc_queue.h>
+#include <threads/objpool.h>
+
+/**
+ * Completion record (task and completion)
+ */
+typedef struct compq_rec {
+	mpsc_node_t node;
+	compq_t cq;
+	intptr_t (*function)(void *);
+	void *arg;
+	uint64_t tag;
+	intptr_t result;
+} compq_rec_t;
+
+struct compq {
+	mpsc_queue_t queue; /* completed records */
+	int signaled; /* fd is written and not cleared by compq_poll */
+	size_t pending; /* submitted and not polled */
+	int fd; /* eventfd or pipe read end */
+	int wfd; /* pipe write end (fd for eventfd) */
+	objpool_t recs; /* preallocated records */
+};
+
+static compq_rec_t *_compq_rec_new(compq_t cq) {
+	compq_rec_t *rec = (compq_rec_t *) objpool_get(cq->recs);
+	if (rec == NULL)
+		rec = (compq_rec_t *) malloc(sizeof(compq_rec_t));
+	return rec;
+}
+
+static void _compq_rec_free(compq_t cq, compq_rec_t *rec) {
+	if (objpool_owns(cq->recs, rec)) {
+		objpool_put(cq->recs, rec);
+	} else {
+		free(rec);
+	}
+}
+
+/* write fd once until compq_poll */
+static void _compq_signal(compq_t cq) {
+	uint64_t v = 1;
+	ssize_t rc;
+	if (__atomic_exchange_n(&cq->signaled, 1, __ATOMIC_SEQ_CST))
+		return;
+	do {
+#if defined(__linux__)
+		rc = write(cq->wfd, &v, sizeof(v));
+#else
+		rc = write(cq->wfd, &v, 1);
+#endif
+	} while (rc < 0 && errno == EINTR);
+}
+
+/* reset fd readiness */
+static void _compq_clear(compq_t cq) {
+	uint64_t v;
+	ssize_t rc;
+#if defined(__linux__)
+	do {
+		rc = read(cq->fd, &v, sizeof(v));
+	} while (rc < 0 && errno == EINTR);
+#else
+	do {
+		rc = read(cq->fd, &v, sizeof(v));
+	} while (rc > 0 || (rc < 0 && errno == EINTR));
+#endif
+}
+
+/* task wrapper: run function in worker and complete */
+static void _compq_run(void *p) {
+	compq_rec_t *rec = (compq_rec_t *) p;
+	compq_t cq = rec->cq;
+	rec->result = rec->function(rec->arg);
+	mpsc_queue_push(&cq->queue, &rec->node);
+	_compq_signal(cq);
+}
+
+compq_t compq_create(size_t capacity) {
+	int err;
+	compq_t cq;
+	if (capacity < 1) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((cq = (compq_t) malloc(sizeof(struct compq))) == NULL)
+		return NULL;
+	mpsc_queue_init(&cq->queue);
+	cq->signaled = 0;
+	cq->pending = 0;
+#if defined(__linux__)
+	if ((cq->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+		goto ERROR_ERRNO;
+	cq->wfd = cq->fd;
+#else
+	{
+		int fds[2];
+		if (pipe(fds) == -1)
+			goto ERROR_ERRNO;
+		cq->fd = fds[0];
+		cq->wfd = fds[1];
+		fcntl(cq->fd, F_SETFL, fcntl(cq->fd, F_GETFL) | O_NONBLOCK);
+		fcntl(cq->wfd, F_SETFL, fcntl(cq->wfd, F_GETFL) | O_NONBLOCK);
+		fcntl(cq->fd, F_SETFD, FD_CLOEXEC);
+		fcntl(cq->wfd, F_SETFD, FD_CLOEXEC);
+	}
+#endif
+	if ((cq->recs = objpool_create(sizeof(compq_rec_t), capacity)) == NULL) {
+		err = errno;
+		close(cq->fd);
+		if (cq->wfd != cq->fd)
+			close(cq->wfd);
+		free(cq);
+		errno = err;
+		return NULL;
+	}
+	return cq;
+
+ERROR_ERRNO:
+	err = errno;
+	free(cq);
+	errno = err;
+	return NULL;
+}
+
+int compq_fd(compq_t cq) {
+	return cq->fd;
+}
+
+int compq_submit(compq_t cq, executor_t ex, intptr_t (*function)(void *), void *arg, uint64_t tag) {
+	int err;
+	compq_rec_t *rec = _compq_rec_new(cq);
+	if (rec == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	rec->cq = cq;
+	rec->function = function;
+	rec->arg = arg;
+	rec->tag = tag;
+	/* before submit, task can be completed and polled before return */
+	__atomic_add_fetch(&cq->pending, 1, __ATOMIC_RELAXED);
+	if (executor_submit(ex, _compq_run, rec) != 0) {
+		err = errno;
+		__atomic_sub_fetch(&cq->pending, 1, __ATOMIC_RELAXED);
+		_compq_rec_free(cq, rec);
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+size_t compq_poll(compq_t cq, compq_entry_t *entries, size_t max) {
+	compq_rec_t *rec;
+	size_t n = 0;
+	if (__atomic_load_n(&cq->signaled, __ATOMIC_ACQUIRE)) {
+		_compq_clear(cq);
+		/* completions, pushed after this, signal again (pair for exchange in _compq_signal) */
+		__atomic_store_n(&cq->signaled, 0, __ATOMIC_SEQ_CST);
+	}
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	while (n < max && (rec = (compq_rec_t *) mpsc_queue_pop(&cq->queue)) != NULL) {
+		entries[n].tag = rec->tag;
+		entries[n].result = rec->result;
+		_compq_rec_free(cq, rec);
+		n++;
+	}
+	if (n > 0)
+		__atomic_sub_fetch(&cq->pending, n, __ATOMIC_RELAXED);
+	/* leave fd readable for remaining completions */
+	if (n == max && !mpsc_queue_is_empty(&cq->queue))
+		_compq_signal(cq);
+	return n;
+}
+
+size_t compq_pending(compq_t cq) {
+	return __atomic_load_n(&cq->pending, __ATOMIC_RELAXED);
+}
+
+void compq_destroy(compq_t cq) {
+	compq_rec_t *rec;
+	if (cq) {
+		while ((rec = (compq_rec_t *) mpsc_queue_pop(&cq->queue)) != NULL) {
+			_compq_rec_free(cq, rec);
+		}
+		close(cq->fd);
+		if (cq->wfd != cq->fd)
+			close(cq->wfd);
+		objpool_destroy(cq->recs);
+		free(cq);
+	}
+}
@@ -0,0 +1,25 @@
+#ifndef _THREADS_DEADLINE_H_
+#define _THREADS_DEADLINE_H_
+
+#include <stdint.h>
+#include <time.h>
+
+/* Monotonic deadlines (microseconds) for timed waits */
+
+static inline uint64_t deadline_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static inline uint64_t deadline_after(uint64_t timeout_usecs) {
+	return deadline_now() + timeout_usecs;
+}
+
+/* Remaining time before deadline (0 - if deadline is expired) */
+static inline uint64_t deadline_remain(uint64_t deadline) {
+	uint64_t now = deadline_now();
+	return now < deadline ? deadline - now : 0;
+}
+
+#endif /* _THREADS_DEADLINE_H_ */
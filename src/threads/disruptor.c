@@ -0,0 +1,309 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/disruptor.h>
+#include <threads/eventcount.h>
+#include <threads/utils.h>
+
+#include "deadline.h"
+
+#define DISRUPTOR_CACHE_LINE 64
+
+/* spin iterations before sleep */
+#define DISRUPTOR_SPINS 100
+
+/**
+ * Consumer (one per cache line)
+ */
+typedef struct disruptor_consumer {
+	uint64_t seq; /* next sequence for process (all before are released) */
+	size_t ndeps;
+	int *deps;
+	char pad[DISRUPTOR_CACHE_LINE - sizeof(uint64_t) - sizeof(size_t) - sizeof(int *)];
+} disruptor_consumer_t;
+
+struct disruptor {
+	size_t entry_size;
+	size_t size;
+	size_t mask;
+	int flags;
+	size_t max_consumers;
+	size_t nconsumers;
+	disruptor_consumer_t *consumers;
+	char *entries;
+	uint64_t *published; /* multi writer: sequence + 1 of last published entry for slot */
+	eventcount_t ec; /* producers and consumers wait for progress */
+	int closed;
+	char pad1[DISRUPTOR_CACHE_LINE];
+	uint64_t claimed; /* next sequence for claim */
+	uint64_t gate; /* producers cached minimum of consumers sequences */
+	char pad2[DISRUPTOR_CACHE_LINE - 2 * sizeof(uint64_t)];
+	uint64_t cursor; /* single writer: next sequence for publish (all before are published) */
+	char pad3[DISRUPTOR_CACHE_LINE - sizeof(uint64_t)];
+};
+
+disruptor_t disruptor_create(size_t entry_size, size_t size, size_t max_consumers, int flags) {
+	disruptor_t d;
+	void *p;
+	int err;
+	size_t n = 2;
+
+	if (entry_size == 0 || size == 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	while (n < size)
+		n <<= 1;
+	if ((err = posix_memalign(&p, DISRUPTOR_CACHE_LINE, sizeof(struct disruptor))) != 0) {
+		errno = err;
+		return NULL;
+	}
+	d = (disruptor_t) p;
+	memset(d, 0, sizeof(struct disruptor));
+	d->entry_size = entry_size;
+	d->size = n;
+	d->mask = n - 1;
+	d->flags = flags;
+	d->max_consumers = max_consumers;
+	eventcount_init(&d->ec);
+	if (max_consumers > 0) {
+		if ((err = posix_memalign(&p, DISRUPTOR_CACHE_LINE, max_consumers * sizeof(disruptor_consumer_t))) != 0)
+			goto ERROR;
+		d->consumers = (disruptor_consumer_t *) p;
+		memset(d->consumers, 0, max_consumers * sizeof(disruptor_consumer_t));
+	}
+	if ((err = posix_memalign(&p, DISRUPTOR_CACHE_LINE, n * entry_size)) != 0)
+		goto ERROR;
+	d->entries = (char *) p;
+	if (flags & DISRUPTOR_MULTI_WRITER) {
+		if ((d->published = (uint64_t *) calloc(n, sizeof(uint64_t))) == NULL) {
+			err = ENOMEM;
+			goto ERROR;
+		}
+	}
+	return d;
+
+ERROR:
+	disruptor_destroy(d);
+	errno = err;
+	return NULL;
+}
+
+void disruptor_destroy(disruptor_t d) {
+	size_t i;
+	if (d) {
+		for (i = 0; i < d->nconsumers; i++) {
+			free(d->consumers[i].deps);
+		}
+		free(d->consumers);
+		free(d->entries);
+		free(d->published);
+		free(d);
+	}
+}
+
+int disruptor_consumer_add(disruptor_t d, const int *deps, size_t ndeps) {
+	disruptor_consumer_t *c;
+	size_t i;
+
+	if (d->nconsumers == d->max_consumers) {
+		errno = ENOSPC;
+		return -1;
+	}
+	for (i = 0; i < ndeps; i++) {
+		if (deps[i] < 0 || (size_t) deps[i] >= d->nconsumers) {
+			errno = EINVAL;
+			return -1;
+		}
+	}
+	c = &d->consumers[d->nconsumers];
+	c->seq = __atomic_load_n(&d->claimed, __ATOMIC_ACQUIRE);
+	if (ndeps) {
+		if ((c->deps = (int *) malloc(ndeps * sizeof(int))) == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		memcpy(c->deps, deps, ndeps * sizeof(int));
+	}
+	c->ndeps = ndeps;
+	return (int) d->nconsumers++;
+}
+
+size_t disruptor_size(disruptor_t d) {
+	return d->size;
+}
+
+void *disruptor_entry(disruptor_t d, uint64_t seq) {
+	return d->entries + (size_t) (seq & d->mask) * d->entry_size;
+}
+
+/* minimum of consumers sequences (producer can't overwrite entries after it) */
+static uint64_t disruptor_min_seq(disruptor_t d, uint64_t seq) {
+	size_t i;
+	uint64_t c;
+	for (i = 0; i < d->nconsumers; i++) {
+		c = __atomic_load_n(&d->consumers[i].seq, __ATOMIC_ACQUIRE);
+		if (c < seq)
+			seq = c;
+	}
+	return seq;
+}
+
+/* is entries before end is released by slowest consumer */
+static int disruptor_has_space(disruptor_t d, uint64_t end) {
+	uint64_t gate = __atomic_load_n(&d->gate, __ATOMIC_RELAXED);
+	if (end - gate <= d->size)
+		return 1;
+	gate = disruptor_min_seq(d, end);
+	__atomic_store_n(&d->gate, gate, __ATOMIC_RELAXED);
+	return end - gate <= d->size;
+}
+
+static void disruptor_wait_space(disruptor_t d, uint64_t end) {
+	uint32_t key;
+	int i;
+	for (i = 0; i < DISRUPTOR_SPINS; i++) {
+		if (disruptor_has_space(d, end))
+			return;
+		threads_cpu_relax();
+	}
+	while (!disruptor_has_space(d, end)) {
+		key = eventcount_prepare_wait(&d->ec);
+		if (disruptor_has_space(d, end)) {
+			eventcount_cancel_wait(&d->ec);
+			break;
+		}
+		eventcount_commit_wait(&d->ec, key);
+	}
+}
+
+uint64_t disruptor_claim(disruptor_t d, size_t n) {
+	uint64_t seq;
+	if (d->flags & DISRUPTOR_MULTI_WRITER) {
+		seq = __atomic_fetch_add(&d->claimed, n, __ATOMIC_ACQ_REL);
+	} else {
+		seq = d->claimed;
+		__atomic_store_n(&d->claimed, seq + n, __ATOMIC_RELAXED);
+	}
+	disruptor_wait_space(d, seq + n);
+	return seq;
+}
+
+int disruptor_try_claim(disruptor_t d, size_t n, uint64_t *seq) {
+	if ((d->flags & DISRUPTOR_MULTI_WRITER) || !disruptor_has_space(d, d->claimed + n)) {
+		errno = EAGAIN;
+		return -1;
+	}
+	*seq = d->claimed;
+	__atomic_store_n(&d->claimed, *seq + n, __ATOMIC_RELAXED);
+	return 0;
+}
+
+void disruptor_publish(disruptor_t d, uint64_t seq, size_t n) {
+	size_t i;
+	if (d->flags & DISRUPTOR_MULTI_WRITER) {
+		for (i = 0; i < n; i++) {
+			__atomic_store_n(&d->published[(seq + i) & d->mask], seq + i + 1, __ATOMIC_RELEASE);
+		}
+	} else {
+		__atomic_store_n(&d->cursor, seq + n, __ATOMIC_RELEASE);
+	}
+	eventcount_notify_all(&d->ec);
+}
+
+void disruptor_close(disruptor_t d) {
+	__atomic_store_n(&d->closed, 1, __ATOMIC_RELEASE);
+	eventcount_notify_all(&d->ec);
+}
+
+/* published entries end, starting from seq */
+static uint64_t disruptor_published_end(disruptor_t d, uint64_t seq) {
+	uint64_t end;
+	if ((d->flags & DISRUPTOR_MULTI_WRITER) == 0)
+		return __atomic_load_n(&d->cursor, __ATOMIC_ACQUIRE);
+	end = __atomic_load_n(&d->claimed, __ATOMIC_ACQUIRE);
+	while (seq < end && __atomic_load_n(&d->published[seq & d->mask], __ATOMIC_ACQUIRE) == seq + 1)
+		seq++;
+	return seq;
+}
+
+static size_t disruptor_available(disruptor_t d, disruptor_consumer_t *c, uint64_t seq) {
+	size_t i;
+	uint64_t end, dep;
+	if (c->ndeps == 0) {
+		end = disruptor_published_end(d, seq);
+	} else {
+		/* dependencies process only published entries */
+		end = UINT64_MAX;
+		for (i = 0; i < c->ndeps; i++) {
+			dep = __atomic_load_n(&d->consumers[c->deps[i]].seq, __ATOMIC_ACQUIRE);
+			if (dep < end)
+				end = dep;
+		}
+	}
+	return end > seq ? (size_t) (end - seq) : 0;
+}
+
+/* closed and all claimed entries are processed */
+static int disruptor_drained(disruptor_t d, uint64_t seq) {
+	return __atomic_load_n(&d->closed, __ATOMIC_ACQUIRE) &&
+		seq >= __atomic_load_n(&d->claimed, __ATOMIC_ACQUIRE);
+}
+
+static size_t disruptor_consume_wait_(disruptor_t d, int c, uint64_t *seq, uint64_t deadline) {
+	disruptor_consumer_t *consumer = &d->consumers[c];
+	uint32_t key;
+	uint64_t remain;
+	size_t n;
+	int i;
+
+	*seq = consumer->seq;
+	for (i = 0; i < DISRUPTOR_SPINS; i++) {
+		if ((n = disruptor_available(d, consumer, *seq)) > 0)
+			return n;
+		threads_cpu_relax();
+	}
+	while (1) {
+		key = eventcount_prepare_wait(&d->ec);
+		if ((n = disruptor_available(d, consumer, *seq)) > 0) {
+			eventcount_cancel_wait(&d->ec);
+			return n;
+		}
+		if (disruptor_drained(d, *seq)) {
+			eventcount_cancel_wait(&d->ec);
+			errno = EPIPE;
+			return 0;
+		}
+		if (deadline == 0) {
+			eventcount_commit_wait(&d->ec, key);
+			continue;
+		}
+		if ((remain = deadline_remain(deadline)) == 0) {
+			eventcount_cancel_wait(&d->ec);
+			errno = ETIMEDOUT;
+			return 0;
+		}
+		if (eventcount_commit_timed_wait(&d->ec, key, remain) == -1)
+			return 0;
+	}
+}
+
+size_t disruptor_consume_wait(disruptor_t d, int c, uint64_t *seq) {
+	return disruptor_consume_wait_(d, c, seq, 0);
+}
+
+size_t disruptor_consume_timed_wait(disruptor_t d, int c, uint64_t *seq, uint64_t timeout_usecs) {
+	return disruptor_consume_wait_(d, c, seq, deadline_after(timeout_usecs));
+}
+
+size_t disruptor_consume_try(disruptor_t d, int c, uint64_t *seq) {
+	*seq = d->consumers[c].seq;
+	return disruptor_available(d, &d->consumers[c], *seq);
+}
+
+void disruptor_release(disruptor_t d, int c, size_t n) {
+	disruptor_consumer_t *consumer = &d->consumers[c];
+	__atomic_store_n(&consumer->seq, consumer->seq + n, __ATOMIC_RELEASE);
+	eventcount_notify_all(&d->ec);
+}
@@ -0,0 +1,287 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/ebr.h>
+
+#define EBR_CACHE_LINE 64
+
+/* record state: 0 - inactive, (epoch << 1) | 1 - active, observe epoch */
+#define EBR_ACTIVE(epoch) (((epoch) << 1) | 1)
+#define EBR_EPOCH(state) ((state) >> 1)
+
+typedef struct ebr_retired {
+	void *ptr;
+	void (*free_fn)(void *);
+} ebr_retired_t;
+
+/**
+ * Objects, retired in one epoch
+ */
+typedef struct ebr_limbo {
+	ebr_retired_t *items;
+	size_t count;
+	size_t cap;
+	uint64_t epoch;
+} ebr_limbo_t;
+
+/**
+ * Per-thread record
+ */
+typedef struct ebr_record {
+	uint64_t state; /* scanned by other threads */
+	char pad[EBR_CACHE_LINE - sizeof(uint64_t)];
+	ebr_t d;
+	unsigned nest; /* critical sections nesting */
+	int online;
+	int used; /* owned by thread */
+	size_t pending; /* retired, not freed */
+	size_t reclaim_at; /* pending threshold for next reclaim */
+	ebr_limbo_t limbo[3];
+	struct ebr_record *next; /* all records, never removed until destroy */
+} ebr_record_t;
+
+struct ebr {
+	uint64_t epoch;
+	char pad[EBR_CACHE_LINE - sizeof(uint64_t)];
+	ebr_record_t *records;
+	pthread_key_t key;
+	pthread_mutex_t lock; /* records allocation */
+};
+
+static struct ebr ebr_default_domain __attribute__((aligned(EBR_CACHE_LINE)));
+static pthread_once_t ebr_default_once = PTHREAD_ONCE_INIT;
+
+static void ebr_limbo_free(ebr_record_t *r, ebr_limbo_t *l) {
+	size_t i;
+	for (i = 0; i < l->count; i++) {
+		l->items[i].free_fn(l->items[i].ptr);
+	}
+	r->pending -= l->count;
+	l->count = 0;
+}
+
+/* free objects, retired at least 2 epochs before */
+static void ebr_record_free(ebr_record_t *r, uint64_t epoch) {
+	int i;
+	for (i = 0; i < 3; i++) {
+		if (r->limbo[i].count && r->limbo[i].epoch + 2 <= epoch)
+			ebr_limbo_free(r, &r->limbo[i]);
+	}
+}
+
+/* advance global epoch, if all active threads observe it */
+static uint64_t ebr_try_advance(ebr_t d) {
+	uint64_t epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST), state;
+	ebr_record_t *r;
+	for (r = __atomic_load_n(&d->records, __ATOMIC_ACQUIRE); r; r = r->next) {
+		state = __atomic_load_n(&r->state, __ATOMIC_SEQ_CST);
+		if (state && EBR_EPOCH(state) != epoch)
+			return epoch;
+	}
+	if (__atomic_compare_exchange_n(&d->epoch, &epoch, epoch + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+		return epoch + 1;
+	return epoch;
+}
+
+/* thread exit: record is reused by other thread (with not freed objects) */
+static void ebr_thread_exit(void *p) {
+	ebr_record_t *r = (ebr_record_t *) p;
+	ebr_t d = r->d;
+	r->nest = 0;
+	r->online = 0;
+	__atomic_store_n(&r->state, 0, __ATOMIC_RELEASE);
+	if (r->pending) {
+		ebr_try_advance(d);
+		ebr_record_free(r, ebr_try_advance(d));
+	}
+	pthread_mutex_lock(&d->lock);
+	r->used = 0;
+	pthread_mutex_unlock(&d->lock);
+}
+
+static ebr_record_t *ebr_record(ebr_t d) {
+	ebr_record_t *r = (ebr_record_t *) pthread_getspecific(d->key);
+	void *p;
+	if (r)
+		return r;
+	pthread_mutex_lock(&d->lock);
+	for (r = d->records; r; r = r->next) {
+		if (!r->used)
+			break;
+	}
+	if (r == NULL) {
+		if (posix_memalign(&p, EBR_CACHE_LINE, sizeof(ebr_record_t)) != 0) {
+			/* thread can't be registered */
+			abort();
+		}
+		r = (ebr_record_t *) p;
+		memset(r, 0, sizeof(ebr_record_t));
+		r->d = d;
+		r->reclaim_at = EBR_BATCH;
+		r->next = d->records;
+		/* records list is scanned without lock */
+		__atomic_store_n(&d->records, r, __ATOMIC_RELEASE);
+	}
+	r->used = 1;
+	pthread_setspecific(d->key, r);
+	pthread_mutex_unlock(&d->lock);
+	return r;
+}
+
+static int ebr_domain_init(ebr_t d) {
+	int err;
+	memset(d, 0, sizeof(struct ebr));
+	if ((err = pthread_key_create(&d->key, ebr_thread_exit)) != 0)
+		return err;
+	if ((err = pthread_mutex_init(&d->lock, NULL)) != 0) {
+		pthread_key_delete(d->key);
+		return err;
+	}
+	return 0;
+}
+
+static void ebr_default_init(void) {
+	if (ebr_domain_init(&ebr_default_domain) != 0)
+		abort();
+}
+
+ebr_t ebr_create(void) {
+	void *p;
+	int err;
+	if ((err = posix_memalign(&p, EBR_CACHE_LINE, sizeof(struct ebr))) != 0) {
+		errno = err;
+		return NULL;
+	}
+	if ((err = ebr_domain_init((ebr_t) p)) != 0) {
+		free(p);
+		errno = err;
+		return NULL;
+	}
+	return (ebr_t) p;
+}
+
+void ebr_destroy(ebr_t d) {
+	ebr_record_t *r, *next;
+	int i;
+	if (d == NULL || d == &ebr_default_domain)
+		return;
+	pthread_key_delete(d->key);
+	for (r = d->records; r; r = next) {
+		next = r->next;
+		for (i = 0; i < 3; i++) {
+			ebr_limbo_free(r, &r->limbo[i]);
+			free(r->limbo[i].items);
+		}
+		free(r);
+	}
+	pthread_mutex_destroy(&d->lock);
+	free(d);
+}
+
+ebr_t ebr_default(void) {
+	pthread_once(&ebr_default_once, ebr_default_init);
+	return &ebr_default_domain;
+}
+
+void ebr_enter(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	if (r->nest++ == 0 && !r->online) {
+		__atomic_store_n(&r->state, EBR_ACTIVE(__atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST)), __ATOMIC_RELAXED);
+		/* state must be visible before reads of protected objects */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+}
+
+void ebr_exit(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	if (--r->nest == 0 && !r->online) {
+		__atomic_store_n(&r->state, 0, __ATOMIC_RELEASE);
+	}
+}
+
+void ebr_online(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	if (r->online)
+		return;
+	r->online = 1;
+	if (r->nest == 0) {
+		__atomic_store_n(&r->state, EBR_ACTIVE(__atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST)), __ATOMIC_RELAXED);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	}
+}
+
+void ebr_offline(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	if (!r->online)
+		return;
+	r->online = 0;
+	if (r->nest == 0) {
+		__atomic_store_n(&r->state, 0, __ATOMIC_RELEASE);
+	}
+}
+
+void ebr_quiescent(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	uint64_t epoch;
+	if (!r->online || r->nest)
+		return;
+	/*
+	 * Reads of protected objects after announce are ordered by acquire load of epoch,
+	 * so (unlike ebr_enter) full fence is not needed.
+	 */
+	epoch = __atomic_load_n(&d->epoch, __ATOMIC_ACQUIRE);
+	if (EBR_EPOCH(__atomic_load_n(&r->state, __ATOMIC_RELAXED)) != epoch) {
+		__atomic_store_n(&r->state, EBR_ACTIVE(epoch), __ATOMIC_RELEASE);
+		if (r->pending)
+			ebr_record_free(r, epoch);
+	}
+}
+
+int ebr_retire(ebr_t d, void *ptr, void (*free_fn)(void *)) {
+	ebr_record_t *r = ebr_record(d);
+	ebr_limbo_t *l;
+	uint64_t epoch;
+
+	/* unlink must be visible before epoch read */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	epoch = __atomic_load_n(&d->epoch, __ATOMIC_SEQ_CST);
+	l = &r->limbo[epoch % 3];
+	if (l->count && l->epoch != epoch) {
+		/* retired 3 or more epochs before */
+		ebr_limbo_free(r, l);
+	}
+	if (l->count == l->cap) {
+		size_t cap = l->cap ? l->cap * 2 : EBR_BATCH;
+		ebr_retired_t *items = (ebr_retired_t *) realloc(l->items, cap * sizeof(ebr_retired_t));
+		if (items == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		l->items = items;
+		l->cap = cap;
+	}
+	l->epoch = epoch;
+	l->items[l->count].ptr = ptr;
+	l->items[l->count].free_fn = free_fn;
+	l->count++;
+	if (++r->pending >= r->reclaim_at) {
+		ebr_reclaim(d);
+		/* don't rescan on each retire, if some reader is stalled */
+		r->reclaim_at = r->pending + EBR_BATCH;
+	}
+	return 0;
+}
+
+size_t ebr_reclaim(ebr_t d) {
+	ebr_record_t *r = ebr_record(d);
+	uint64_t epoch = ebr_try_advance(d);
+	if (r->pending) {
+		/* second step succeed, if other threads are inactive */
+		epoch = ebr_try_advance(d);
+	}
+	ebr_record_free(r, epoch);
+	return r->pending;
+}
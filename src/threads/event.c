@@ -0,0 +1,61 @@
+#include <errno.h>
+#include <limits.h>
+
+#include <threads/event.h>
+#include <threads/futex.h>
+
+#include "deadline.h"
+
+void event_set(event_t *e) {
+	uint32_t s = __atomic_load_n(&e->state, __ATOMIC_RELAXED);
+	if (s & EVENT_MANUAL) {
+		s = __atomic_exchange_n(&e->state, EVENT_MANUAL | EVENT_SET, __ATOMIC_RELEASE);
+		if (s & EVENT_WAITERS)
+			futex_wake(&e->state, INT_MAX);
+		return;
+	}
+	while ((s & EVENT_SET) == 0) {
+		if (__atomic_compare_exchange_n(&e->state, &s, EVENT_SET, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+			/* woken waiter restore waiters flag, if it consume event */
+			if (s & EVENT_WAITERS)
+				futex_wake(&e->state, 1);
+			return;
+		}
+	}
+}
+
+int event_wait_slow(event_t *e, uint64_t timeout_usecs) {
+	uint32_t s;
+	uint64_t deadline = 0, remain = 0;
+	int slept = 0;
+
+	if (timeout_usecs)
+		deadline = deadline_after(timeout_usecs);
+	s = __atomic_load_n(&e->state, __ATOMIC_ACQUIRE);
+	while (1) {
+		if (s & EVENT_SET) {
+			if (s & EVENT_MANUAL)
+				return 0;
+			/* consume auto-reset event, other waiters may sleep after us */
+			if (__atomic_compare_exchange_n(&e->state, &s, slept ? EVENT_WAITERS : 0, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+				return 0;
+			continue;
+		}
+		if ((s & EVENT_WAITERS) == 0) {
+			if (!__atomic_compare_exchange_n(&e->state, &s, s | EVENT_WAITERS, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+				continue;
+			s |= EVENT_WAITERS;
+		}
+		if (timeout_usecs) {
+			if ((remain = deadline_remain(deadline)) == 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			futex_timed_wait(&e->state, s, remain);
+		} else {
+			futex_wait(&e->state, s);
+		}
+		slept = 1;
+		s = __atomic_load_n(&e->state, __ATOMIC_ACQUIRE);
+	}
+}
@@ -0,0 +1,36 @@
+#include <errno.h>
+#include <limits.h>
+
+#include <threads/eventcount.h>
+#include <threads/futex.h>
+
+#include "deadline.h"
+
+void eventcount_wake(eventcount_t *ec, int count) {
+	__atomic_add_fetch(&ec->epoch, 1, __ATOMIC_SEQ_CST);
+	futex_wake(&ec->epoch, count < 0 ? INT_MAX : count);
+}
+
+void eventcount_commit_wait(eventcount_t *ec, uint32_t key) {
+	while (__atomic_load_n(&ec->epoch, __ATOMIC_ACQUIRE) == key) {
+		futex_wait(&ec->epoch, key);
+	}
+	__atomic_sub_fetch(&ec->waiters, 1, __ATOMIC_RELAXED);
+}
+
+int eventcount_commit_timed_wait(eventcount_t *ec, uint32_t key, uint64_t timeout_usecs) {
+	uint64_t deadline = deadline_after(timeout_usecs), remain;
+	int ret = 0;
+
+	while (__atomic_load_n(&ec->epoch, __ATOMIC_ACQUIRE) == key) {
+		if ((remain = deadline_remain(deadline)) == 0) {
+			ret = -1;
+			break;
+		}
+		futex_timed_wait(&ec->epoch, key, remain);
+	}
+	__atomic_sub_fetch(&ec->waiters, 1, __ATOMIC_RELAXED);
+	if (ret)
+		errno = ETIMEDOUT;
+	return ret;
+}
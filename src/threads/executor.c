@@ -0,0 +1,311 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/executor.h>
+
+struct executor {
+	const executor_ops_t *ops;
+	void *impl;
+	size_t submitted;
+	size_t rejected;
+	size_t caller_runs;
+};
+
+/*
+ * Implementation submit returns 0 (queued), -1 (error) or EXECUTOR_RUN_CALLER (task is run in caller),
+ * so caller runs are counted here for all implementations.
+ */
+#define EXECUTOR_RUN_CALLER 1
+
+/* ========================== THPOOL ================================ */
+
+static int _executor_thpool_submit(void *impl, void (*function)(void *), void *arg) {
+	if (thpool_add_task((thpool_t) impl, function, arg) != 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	return 0;
+}
+
+static void _executor_thpool_wait(void *impl) {
+	thpool_wait((thpool_t) impl);
+}
+
+static void _executor_thpool_pause(void *impl) {
+	thpool_pause((thpool_t) impl);
+}
+
+static void _executor_thpool_resume(void *impl) {
+	thpool_resume((thpool_t) impl);
+}
+
+static void _executor_thpool_stats(void *impl, executor_stats_t *stats) {
+	thpool_t pool = (thpool_t) impl;
+	stats->workers = thpool_workers_count(pool);
+	stats->active = thpool_active_tasks(pool);
+	stats->total = thpool_total_tasks(pool);
+}
+
+static void _executor_thpool_destroy(void *impl) {
+	thpool_destroy((thpool_t) impl);
+}
+
+static const executor_ops_t executor_thpool_ops = {
+	"thpool",
+	_executor_thpool_submit,
+	NULL,
+	_executor_thpool_wait,
+	_executor_thpool_pause,
+	_executor_thpool_resume,
+	_executor_thpool_stats,
+	NULL
+};
+
+static const executor_ops_t executor_thpool_owned_ops = {
+	"thpool",
+	_executor_thpool_submit,
+	NULL,
+	_executor_thpool_wait,
+	_executor_thpool_pause,
+	_executor_thpool_resume,
+	_executor_thpool_stats,
+	_executor_thpool_destroy
+};
+
+/* ========================== LFTHPOOL ============================== */
+
+static int _executor_lfthpool_submit(void *impl, void (*function)(void *), void *arg) {
+	if (lfthpool_add_task((lfthpool_t) impl, function, arg) != 0) {
+		if (errno != ENOMEM)
+			errno = EAGAIN;
+		return -1;
+	}
+	return 0;
+}
+
+static void _executor_lfthpool_wait(void *impl) {
+	lfthpool_wait((lfthpool_t) impl);
+}
+
+static void _executor_lfthpool_pause(void *impl) {
+	lfthpool_pause((lfthpool_t) impl);
+}
+
+static void _executor_lfthpool_resume(void *impl) {
+	lfthpool_resume((lfthpool_t) impl);
+}
+
+static void _executor_lfthpool_stats(void *impl, executor_stats_t *stats) {
+	lfthpool_t pool = (lfthpool_t) impl;
+	stats->workers = lfthpool_workers_count(pool);
+	stats->active = lfthpool_active_tasks(pool);
+	stats->total = lfthpool_total_tasks(pool);
+}
+
+static void _executor_lfthpool_destroy(void *impl) {
+	lfthpool_destroy((lfthpool_t) impl);
+}
+
+static const executor_ops_t executor_lfthpool_ops = {
+	"lfthpool",
+	_executor_lfthpool_submit,
+	NULL,
+	_executor_lfthpool_wait,
+	_executor_lfthpool_pause,
+	_executor_lfthpool_resume,
+	_executor_lfthpool_stats,
+	NULL
+};
+
+static const executor_ops_t executor_lfthpool_owned_ops = {
+	"lfthpool",
+	_executor_lfthpool_submit,
+	NULL,
+	_executor_lfthpool_wait,
+	_executor_lfthpool_pause,
+	_executor_lfthpool_resume,
+	_executor_lfthpool_stats,
+	_executor_lfthpool_destroy
+};
+
+/* ========================== INLINE ================================ */
+
+static int _executor_inline_submit(void *impl, void (*function)(void *), void *arg) {
+	(void) impl;
+	function(arg);
+	return EXECUTOR_RUN_CALLER;
+}
+
+static void _executor_inline_wait(void *impl) {
+	(void) impl;
+}
+
+static const executor_ops_t executor_inline_ops = {
+	"inline",
+	_executor_inline_submit,
+	NULL,
+	_executor_inline_wait,
+	NULL,
+	NULL,
+	NULL,
+	NULL
+};
+
+/* ========================== CALLER RUNS =========================== */
+
+static int _executor_caller_runs_submit(void *impl, void (*function)(void *), void *arg) {
+	if (executor_submit((executor_t) impl, function, arg) == 0)
+		return 0;
+	if (errno != EAGAIN)
+		return -1;
+	/* queue is full, caller is throttled by running task */
+	function(arg);
+	return EXECUTOR_RUN_CALLER;
+}
+
+static void _executor_caller_runs_wait(void *impl) {
+	executor_wait((executor_t) impl);
+}
+
+static void _executor_caller_runs_pause(void *impl) {
+	executor_pause((executor_t) impl);
+}
+
+static void _executor_caller_runs_resume(void *impl) {
+	executor_resume((executor_t) impl);
+}
+
+static void _executor_caller_runs_stats(void *impl, executor_stats_t *stats) {
+	executor_stats((executor_t) impl, stats);
+}
+
+static void _executor_caller_runs_destroy(void *impl) {
+	executor_destroy((executor_t) impl);
+}
+
+static const executor_ops_t executor_caller_runs_ops = {
+	"caller_runs",
+	_executor_caller_runs_submit,
+	NULL,
+	_executor_caller_runs_wait,
+	_executor_caller_runs_pause,
+	_executor_caller_runs_resume,
+	_executor_caller_runs_stats,
+	_executor_caller_runs_destroy
+};
+
+/* ========================== EXECUTOR ============================== */
+
+executor_t executor_create(const executor_ops_t *ops, void *impl) {
+	executor_t ex;
+	if (ops == NULL || ops->submit == NULL || ops->wait == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((ex = (executor_t) malloc(sizeof(struct executor))) == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	ex->ops = ops;
+	ex->impl = impl;
+	ex->submitted = 0;
+	ex->rejected = 0;
+	ex->caller_runs = 0;
+	return ex;
+}
+
+executor_t executor_thpool(thpool_t pool, int own) {
+	if (pool == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return executor_create(own ? &executor_thpool_owned_ops : &executor_thpool_ops, pool);
+}
+
+executor_t executor_lfthpool(lfthpool_t pool, int own) {
+	if (pool == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return executor_create(own ? &executor_lfthpool_owned_ops : &executor_lfthpool_ops, pool);
+}
+
+executor_t executor_inline(void) {
+	return executor_create(&executor_inline_ops, NULL);
+}
+
+executor_t executor_caller_runs(executor_t ex) {
+	if (ex == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return executor_create(&executor_caller_runs_ops, ex);
+}
+
+const char *executor_name(executor_t ex) {
+	return ex->ops->name;
+}
+
+int executor_submit(executor_t ex, void (*function)(void *), void *arg) {
+	int ret = ex->ops->submit(ex->impl, function, arg);
+	if (ret < 0) {
+		__atomic_add_fetch(&ex->rejected, 1, __ATOMIC_RELAXED);
+		return -1;
+	}
+	if (ret == EXECUTOR_RUN_CALLER)
+		__atomic_add_fetch(&ex->caller_runs, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&ex->submitted, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+size_t executor_submit_batch(executor_t ex, const executor_task_t *tasks, size_t count) {
+	size_t i;
+	if (ex->ops->submit_batch) {
+		i = ex->ops->submit_batch(ex->impl, tasks, count);
+		__atomic_add_fetch(&ex->submitted, i, __ATOMIC_RELAXED);
+		if (i < count)
+			__atomic_add_fetch(&ex->rejected, 1, __ATOMIC_RELAXED);
+		return i;
+	}
+	for (i = 0; i < count; i++) {
+		if (executor_submit(ex, tasks[i].function, tasks[i].arg) != 0)
+			break;
+	}
+	return i;
+}
+
+void executor_wait(executor_t ex) {
+	ex->ops->wait(ex->impl);
+}
+
+void executor_pause(executor_t ex) {
+	if (ex->ops->pause)
+		ex->ops->pause(ex->impl);
+}
+
+void executor_resume(executor_t ex) {
+	if (ex->ops->resume)
+		ex->ops->resume(ex->impl);
+}
+
+void executor_stats(executor_t ex, executor_stats_t *stats) {
+	size_t caller_runs;
+	memset(stats, 0, sizeof(executor_stats_t));
+	if (ex->ops->stats)
+		ex->ops->stats(ex->impl, stats);
+	/* wrapped executor caller runs are counted too */
+	caller_runs = stats->caller_runs + __atomic_load_n(&ex->caller_runs, __ATOMIC_RELAXED);
+	stats->submitted = __atomic_load_n(&ex->submitted, __ATOMIC_RELAXED);
+	stats->rejected = __atomic_load_n(&ex->rejected, __ATOMIC_RELAXED);
+	stats->caller_runs = caller_runs;
+}
+
+void executor_destroy(executor_t ex) {
+	if (ex) {
+		ex->ops->wait(ex->impl);
+		if (ex->ops->destroy)
+			ex->ops->destroy(ex->impl);
+		free(ex);
+	}
+}
@@ -0,0 +1,116 @@
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#include <threads/futex.h>
+
+#if defined(__linux__)
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+static int futex_wait_ts(uint32_t *addr, uint32_t val, const struct timespec *ts) {
+	if (syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, ts, NULL, 0) == -1) {
+		return -1;
+	}
+	return 0;
+}
+
+int futex_wait(uint32_t *addr, uint32_t val) {
+	return futex_wait_ts(addr, val, NULL);
+}
+
+int futex_timed_wait(uint32_t *addr, uint32_t val, uint64_t timeout_usecs) {
+	struct timespec ts;
+	ts.tv_sec = (time_t) (timeout_usecs / 1000000);
+	ts.tv_nsec = (long) (timeout_usecs % 1000000) * 1000;
+	return futex_wait_ts(addr, val, &ts);
+}
+
+int futex_wake(uint32_t *addr, int count) {
+	return (int) syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+}
+
+#else
+/*
+* ---------------------------------------------------------
+* Emulation with hashed mutex/condition variable buckets
+* ---------------------------------------------------------
+*/
+
+#include <stdint.h>
+#include <pthread.h>
+
+#define FUTEX_BUCKETS 64
+
+static struct futex_bucket {
+	pthread_mutex_t lock;
+	pthread_cond_t notify;
+} futex_buckets[FUTEX_BUCKETS];
+
+static pthread_once_t futex_once = PTHREAD_ONCE_INIT;
+
+static void futex_buckets_init(void) {
+	size_t i;
+	for (i = 0; i < FUTEX_BUCKETS; i++) {
+		pthread_mutex_init(&futex_buckets[i].lock, NULL);
+		pthread_cond_init(&futex_buckets[i].notify, NULL);
+	}
+}
+
+static struct futex_bucket *futex_bucket(uint32_t *addr) {
+	uintptr_t h = (uintptr_t) addr;
+	pthread_once(&futex_once, futex_buckets_init);
+	h ^= h >> 12;
+	return &futex_buckets[(h >> 2) % FUTEX_BUCKETS];
+}
+
+static int futex_wait_ts(uint32_t *addr, uint32_t val, const struct timespec *ts) {
+	int err = 0;
+	struct futex_bucket *b = futex_bucket(addr);
+	pthread_mutex_lock(&b->lock);
+	if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != val) {
+		pthread_mutex_unlock(&b->lock);
+		errno = EAGAIN;
+		return -1;
+	}
+	if (ts) {
+		err = pthread_cond_timedwait(&b->notify, &b->lock, ts);
+	} else {
+		err = pthread_cond_wait(&b->notify, &b->lock);
+	}
+	pthread_mutex_unlock(&b->lock);
+	if (err) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+int futex_wait(uint32_t *addr, uint32_t val) {
+	return futex_wait_ts(addr, val, NULL);
+}
+
+int futex_timed_wait(uint32_t *addr, uint32_t val, uint64_t timeout_usecs) {
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += (time_t) (timeout_usecs / 1000000);
+	ts.tv_nsec += (long) (timeout_usecs % 1000000) * 1000;
+	if (ts.tv_nsec >= 1000000000) {
+		ts.tv_nsec -= 1000000000;
+		++ts.tv_sec;
+	}
+	return futex_wait_ts(addr, val, &ts);
+}
+
+int futex_wake(uint32_t *addr, int count) {
+	struct futex_bucket *b = futex_bucket(addr);
+	(void) count;
+	pthread_mutex_lock(&b->lock);
+	pthread_cond_broadcast(&b->notify);
+	pthread_mutex_unlock(&b->lock);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,216 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/hazptr.h>
+
+#define HAZPTR_CACHE_LINE 64
+
+typedef struct hazptr_retired {
+	void *ptr;
+	void (*free_fn)(void *);
+} hazptr_retired_t;
+
+/**
+ * Per-thread record
+ */
+typedef struct hazptr_record {
+	void *slots[HAZPTR_SLOTS]; /* scanned by other threads */
+	char pad[HAZPTR_CACHE_LINE - sizeof(void *) * HAZPTR_SLOTS];
+	hazptr_t h;
+	int used; /* owned by thread */
+	hazptr_retired_t *retired;
+	size_t count;
+	size_t cap;
+	size_t reclaim_at; /* retired count threshold for next scan */
+	void **hazards; /* scan buffer */
+	size_t hazards_cap;
+	struct hazptr_record *next; /* all records, never removed until destroy */
+} hazptr_record_t;
+
+struct hazptr {
+	hazptr_record_t *records;
+	size_t records_count;
+	pthread_key_t key;
+	pthread_mutex_t lock; /* records allocation */
+};
+
+static int hazptr_cmp(const void *a, const void *b) {
+	uintptr_t x = (uintptr_t) *(void *const *) a, y = (uintptr_t) *(void *const *) b;
+	return x < y ? -1 : x > y;
+}
+
+static size_t hazptr_scan(hazptr_t h, hazptr_record_t *r) {
+	size_t n = 0, i, kept = 0, records;
+	hazptr_record_t *rec;
+	void *p;
+	int k;
+
+	if (r->count == 0)
+		return 0;
+	/* retired objects are unlinked before scan */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	/* records count is incremented before record publish */
+	rec = __atomic_load_n(&h->records, __ATOMIC_ACQUIRE);
+	records = __atomic_load_n(&h->records_count, __ATOMIC_ACQUIRE);
+	if (r->hazards_cap < records * HAZPTR_SLOTS) {
+		void **hazards = (void **) realloc(r->hazards, records * HAZPTR_SLOTS * sizeof(void *));
+		if (hazards == NULL)
+			return r->count;
+		r->hazards = hazards;
+		r->hazards_cap = records * HAZPTR_SLOTS;
+	}
+	for (; rec; rec = rec->next) {
+		for (k = 0; k < HAZPTR_SLOTS; k++) {
+			if ((p = __atomic_load_n(&rec->slots[k], __ATOMIC_SEQ_CST)) != NULL)
+				r->hazards[n++] = p;
+		}
+	}
+	qsort(r->hazards, n, sizeof(void *), hazptr_cmp);
+	for (i = 0; i < r->count; i++) {
+		if (n && bsearch(&r->retired[i].ptr, r->hazards, n, sizeof(void *), hazptr_cmp)) {
+			r->retired[kept++] = r->retired[i];
+		} else {
+			r->retired[i].free_fn(r->retired[i].ptr);
+		}
+	}
+	r->count = kept;
+	return kept;
+}
+
+/* thread exit: record is reused by other thread (with not freed objects) */
+static void hazptr_thread_exit(void *p) {
+	hazptr_record_t *r = (hazptr_record_t *) p;
+	hazptr_t h = r->h;
+	int k;
+	for (k = 0; k < HAZPTR_SLOTS; k++) {
+		__atomic_store_n(&r->slots[k], NULL, __ATOMIC_RELEASE);
+	}
+	hazptr_scan(h, r);
+	pthread_mutex_lock(&h->lock);
+	r->used = 0;
+	pthread_mutex_unlock(&h->lock);
+}
+
+static hazptr_record_t *hazptr_record(hazptr_t h) {
+	hazptr_record_t *r = (hazptr_record_t *) pthread_getspecific(h->key);
+	void *p;
+	if (r)
+		return r;
+	pthread_mutex_lock(&h->lock);
+	for (r = h->records; r; r = r->next) {
+		if (!r->used)
+			break;
+	}
+	if (r == NULL) {
+		if (posix_memalign(&p, HAZPTR_CACHE_LINE, sizeof(hazptr_record_t)) != 0) {
+			/* thread can't be registered */
+			abort();
+		}
+		r = (hazptr_record_t *) p;
+		memset(r, 0, sizeof(hazptr_record_t));
+		r->h = h;
+		r->reclaim_at = HAZPTR_BATCH;
+		r->next = h->records;
+		__atomic_add_fetch(&h->records_count, 1, __ATOMIC_RELEASE);
+		/* records list is scanned without lock */
+		__atomic_store_n(&h->records, r, __ATOMIC_RELEASE);
+	}
+	r->used = 1;
+	pthread_setspecific(h->key, r);
+	pthread_mutex_unlock(&h->lock);
+	return r;
+}
+
+hazptr_t hazptr_create(void) {
+	hazptr_t h;
+	int err;
+	if ((h = (hazptr_t) malloc(sizeof(struct hazptr))) == NULL)
+		return NULL;
+	memset(h, 0, sizeof(struct hazptr));
+	if ((err = pthread_key_create(&h->key, hazptr_thread_exit)) != 0)
+		goto ERROR;
+	if ((err = pthread_mutex_init(&h->lock, NULL)) != 0) {
+		pthread_key_delete(h->key);
+		goto ERROR;
+	}
+	return h;
+
+ERROR:
+	free(h);
+	errno = err;
+	return NULL;
+}
+
+void hazptr_destroy(hazptr_t h) {
+	hazptr_record_t *r, *next;
+	size_t i;
+	if (h) {
+		pthread_key_delete(h->key);
+		for (r = h->records; r; r = next) {
+			next = r->next;
+			for (i = 0; i < r->count; i++) {
+				r->retired[i].free_fn(r->retired[i].ptr);
+			}
+			free(r->retired);
+			free(r->hazards);
+			free(r);
+		}
+		pthread_mutex_destroy(&h->lock);
+		free(h);
+	}
+}
+
+void *hazptr_protect(hazptr_t h, int slot, void *const *src) {
+	hazptr_record_t *r = hazptr_record(h);
+	void *p = __atomic_load_n(src, __ATOMIC_RELAXED), *q;
+	while (1) {
+		__atomic_store_n(&r->slots[slot], p, __ATOMIC_RELAXED);
+		/* hazard must be visible before validation */
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if ((q = __atomic_load_n(src, __ATOMIC_ACQUIRE)) == p)
+			return p;
+		p = q;
+	}
+}
+
+void hazptr_set(hazptr_t h, int slot, void *ptr) {
+	hazptr_record_t *r = hazptr_record(h);
+	__atomic_store_n(&r->slots[slot], ptr, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void hazptr_clear(hazptr_t h, int slot) {
+	hazptr_record_t *r = hazptr_record(h);
+	__atomic_store_n(&r->slots[slot], NULL, __ATOMIC_RELEASE);
+}
+
+int hazptr_retire(hazptr_t h, void *ptr, void (*free_fn)(void *)) {
+	hazptr_record_t *r = hazptr_record(h);
+	size_t limit;
+	if (r->count == r->cap) {
+		size_t cap = r->cap ? r->cap * 2 : HAZPTR_BATCH;
+		hazptr_retired_t *retired = (hazptr_retired_t *) realloc(r->retired, cap * sizeof(hazptr_retired_t));
+		if (retired == NULL) {
+			errno = ENOMEM;
+			return -1;
+		}
+		r->retired = retired;
+		r->cap = cap;
+	}
+	r->retired[r->count].ptr = ptr;
+	r->retired[r->count].free_fn = free_fn;
+	if (++r->count >= r->reclaim_at) {
+		hazptr_scan(h, r);
+		/* scan cost is amortized: at least HAZPTR_BATCH and hazards count objects per scan */
+		limit = __atomic_load_n(&h->records_count, __ATOMIC_RELAXED) * HAZPTR_SLOTS;
+		r->reclaim_at = r->count + (limit > HAZPTR_BATCH ? limit : HAZPTR_BATCH);
+	}
+	return 0;
+}
+
+size_t hazptr_reclaim(hazptr_t h) {
+	return hazptr_scan(h, hazptr_record(h));
+}
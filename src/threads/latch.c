@@ -0,0 +1,55 @@
+#include <errno.h>
+#include <limits.h>
+
+#include <threads/latch.h>
+#include <threads/waitgroup.h>
+#include <threads/futex.h>
+
+#include "deadline.h"
+
+/* Wait until counter (low 31 bits of word) reach zero, shared by latch_t and waitgroup_t */
+static int counter_wait(uint32_t *state, uint32_t waiters, uint64_t timeout_usecs) {
+	uint32_t s;
+	uint64_t deadline = 0, remain = 0;
+
+	if (timeout_usecs)
+		deadline = deadline_after(timeout_usecs);
+	s = __atomic_load_n(state, __ATOMIC_ACQUIRE);
+	while ((s & ~waiters) != 0) {
+		if ((s & waiters) == 0) {
+			if (!__atomic_compare_exchange_n(state, &s, s | waiters, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+				continue;
+			s |= waiters;
+		}
+		if (timeout_usecs) {
+			if ((remain = deadline_remain(deadline)) == 0) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			futex_timed_wait(state, s, remain);
+		} else {
+			futex_wait(state, s);
+		}
+		s = __atomic_load_n(state, __ATOMIC_ACQUIRE);
+	}
+	return 0;
+}
+
+void latch_wake(latch_t *l) {
+	futex_wake(&l->state, INT_MAX);
+}
+
+int latch_wait_slow(latch_t *l, uint64_t timeout_usecs) {
+	return counter_wait(&l->state, LATCH_WAITERS, timeout_usecs);
+}
+
+void waitgroup_wake(waitgroup_t *wg) {
+	/* clear waiters flag (if counter is still zero) for next wait round */
+	uint32_t s = WAITGROUP_WAITERS;
+	__atomic_compare_exchange_n(&wg->state, &s, 0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+	futex_wake(&wg->state, INT_MAX);
+}
+
+int waitgroup_wait_slow(waitgroup_t *wg, uint64_t timeout_usecs) {
+	return counter_wait(&wg->state, WAITGROUP_WAITERS, timeout_usecs);
+}
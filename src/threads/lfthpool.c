@@ -20,16 +20,31 @@
 #endif
 
 #include <threads/lfthpool.h>
+#include <threads/ebr.h>
+#include <threads/mpsc_queue.h>
+#include <threads/objpool.h>
 
 #include <concurrent/mpmc_ring_queue.h>
 #include <concurrent/queuedef.h>
 
+#include "pool_worker.h"
+
 /* ========================== STRUCTURES ============================ */
 
+/* max preallocated tasks (if exhausted, tasks are allocated with malloc) */
+#define LFTHPOOL_TASK_POOL_MAX 65536
+
+/* worker prefer overflow list every Nth take, so spilled tasks aren't starved by full queue */
+#define LFTHPOOL_SPILL_PERIOD 8
+
+/* takes by current worker (for overflow list schedule) */
+static __thread unsigned lfthpool_take_count;
+
 /**
  * Struct to hold data for an individual task for a thread pool
  */
 typedef struct task {
+	mpsc_node_t node; /* overflow list node */
 	void (*function)(void *); //pointer to the function the task executes
 	void *arg;
 } task_t;
@@ -45,23 +60,46 @@ struct lfthpool {
 	volatile size_t thread_count;
 	mpmc_ring_queue *task_queue;    /* task queue */
 	size_t queue_size;
-	int (*sleep_func)(useconds_t usec); /* yield function */
+	int (*sleep_func)(useconds_t usec); /* deprecated sleep function for lfthpool_add_task_try (NULL - sched is used) */
+	pool_sched_t sched; /* scheduler adapter for blocking callers */
+	pool_waitq_t task_wq; /* workers wait for new task, resume or shutdown */
+	pool_waitq_t idle_wq; /* lfthpool_wait wait for all tasks done */
+	pool_waitq_t space_wq; /* lfthpool_add_task_try wait for free slot in queue */
+	pool_idle_waiter_t *idle_waiters; /* lfthpool_wait_async waiters (lock-free stack) */
+	int spill; /* spill tasks to overflow list, when queue is full */
+	int spill_lock; /* worker, which pop from overflow list */
+	size_t spill_count; /* tasks in overflow list */
+	mpsc_queue_t spill_queue; /* overflow list */
+	objpool_t task_pool; /* preallocated tasks */
+	pool_workers_t workers; /* worker hooks and contexts */
 };
 
 /* ========================== THREADPOOL ============================ */
 
 static void* _lfthpool_worker(void* _pool);
 
-static int sched_usleep(useconds_t usec);
-
 /* ========================== THREADPOOL ============================ */
 lfthpool_t lfthpool_create(size_t workers, size_t queue_size) {
 	return lfthpool_create_sched(workers, queue_size, NULL);
 }
 
 lfthpool_t lfthpool_create_sched(size_t workers, size_t queue_size, int (*sleep_func)(useconds_t)) {
+	return lfthpool_create_hooks(workers, queue_size, sleep_func, NULL, NULL);
+}
+
+lfthpool_t lfthpool_create_hooks(size_t workers, size_t queue_size, int (*sleep_func)(useconds_t),
+		pool_worker_init_t worker_init, pool_worker_fini_t worker_fini) {
+	pool_attr_t attr;
+	pool_attr_init(&attr, workers, queue_size);
+	attr.sleep_func = sleep_func;
+	attr.worker_init = worker_init;
+	attr.worker_fini = worker_fini;
+	return lfthpool_create_ex(&attr);
+}
+
+lfthpool_t lfthpool_create_ex(const pool_attr_t *attr) {
 	int err;
-	size_t i;
+	size_t i, workers = attr->workers, queue_size = attr->queue_size;
 	lfthpool_t pool;
 
 	if (workers < 1 || queue_size < 2) {
@@ -73,11 +111,8 @@ lfthpool_t lfthpool_create_sched(size_t workers, size_t queue_size, int (*sleep_
 	if (pool == NULL)
 		goto ERROR_ERRNO;
 
-	if (sleep_func) {
-		pool->sleep_func = sleep_func;
-	} else {
-		pool->sleep_func = sched_usleep;
-	}
+	pool->sleep_func = attr->sleep_func;
+	pool->sched = attr->sched ? *attr->sched : *pool_sched_thread();
 
 	/* Pool settings */
 	pool->queue_size = size_to_power_of_2((size_t) queue_size);
@@ -85,28 +120,41 @@ lfthpool_t lfthpool_create_sched(size_t workers, size_t queue_size, int (*sleep_
 
 	pool->running_count = 0;
 	pool->hold = 0;
-	/* allocate thread array */
-	pool->lfthpool = (pthread_t*) malloc(sizeof(pthread_t) * pool->thread_count);
+	pool_waitq_init(&pool->task_wq);
+	pool_waitq_init(&pool->idle_wq);
+	pool_waitq_init(&pool->space_wq);
+	pool->idle_waiters = NULL;
+	pool->spill = 0;
+	pool->spill_lock = 0;
+	pool->spill_count = 0;
+	mpsc_queue_init(&pool->spill_queue);
+	pool->shutdown = 0;
+	/* allocate thread array (zeroed, lfthpool_destroy join only started workers) */
+	pool->lfthpool = (pthread_t*) calloc(pool->thread_count, sizeof(pthread_t));
 	/* allocate task queue */
 	pool->task_queue = mpmc_ring_queue_new(pool->queue_size, NULL);
-
-	if (pool->lfthpool == NULL || pool->task_queue == NULL) {
-		err = ENOMEM;
+	/* allocate tasks */
+	i = pool->queue_size + pool->thread_count * OBJPOOL_MAGAZINE;
+	pool->task_pool = objpool_create(sizeof(task_t), i < LFTHPOOL_TASK_POOL_MAX ? i : LFTHPOOL_TASK_POOL_MAX);
+	/* keep worker attributes error (EINVAL, affinity, etc) */
+	if ((err = pool_workers_init(&pool->workers, pool, attr, "lfthp", NULL)) != 0) {
 		goto ERROR;
 	}
 
-	pool->shutdown = 0;
-
-	for (i = 0; i < (pool->thread_count); i++) {
-		pool->lfthpool[i] = 0;
+	if (pool->lfthpool == NULL || pool->task_queue == NULL || pool->task_pool == NULL) {
+		err = ENOMEM;
+		goto ERROR;
 	}
 
 	/* instantiate worker lfthpool */
 	for (i = 0; i < (pool->thread_count); i++) {
-		if ((err = pthread_create(&pool->lfthpool[i], NULL, _lfthpool_worker, (void *) pool))) {
-			goto ERROR_ERRNO;
+		if ((err = pool_worker_create(&pool->workers, i, &pool->lfthpool[i], _lfthpool_worker)) != 0) {
+			goto ERROR;
 		}
 	}
+	if ((err = pool_workers_wait(&pool->workers)) != 0) {
+		goto ERROR;
+	}
 
 	return pool;
 
@@ -120,13 +168,78 @@ ERROR:
 	return NULL;
 }
 
+static task_t *_lfthpool_task_new(lfthpool_t pool) {
+	task_t *task = (task_t *) objpool_get(pool->task_pool);
+	if (task == NULL)
+		task = (task_t *) malloc(sizeof(task_t));
+	return task;
+}
+
+static void _lfthpool_task_free(lfthpool_t pool, task_t *task) {
+	if (objpool_owns(pool->task_pool, task)) {
+		objpool_put(pool->task_pool, task);
+	} else {
+		free(task);
+	}
+}
+
 size_t lfthpool_workers_count(lfthpool_t pool) {
 	return pool->thread_count;
 }
 
+void lfthpool_set_arena_idle(lfthpool_t pool, uint64_t usecs) {
+	pool_workers_set_arena_idle(&pool->workers, usecs);
+}
+
+void lfthpool_set_spill(lfthpool_t pool, int enable) {
+	__atomic_store_n(&pool->spill, enable ? 1 : 0, __ATOMIC_RELEASE);
+}
+
+/* push task to overflow list (never fail) */
+static void _lfthpool_spill_push(lfthpool_t pool, task_t *task) {
+	__atomic_add_fetch(&pool->spill_count, 1, __ATOMIC_RELEASE);
+	mpsc_queue_push(&pool->spill_queue, &task->node);
+}
+
+/* pop task from overflow list (one worker at time, others don't wait) */
+static task_t *_lfthpool_spill_pop(lfthpool_t pool) {
+	task_t *task;
+	if (__atomic_exchange_n(&pool->spill_lock, 1, __ATOMIC_ACQUIRE))
+		return NULL;
+	if ((task = (task_t *) mpsc_queue_pop(&pool->spill_queue)) != NULL)
+		__atomic_sub_fetch(&pool->spill_count, 1, __ATOMIC_RELAXED);
+	__atomic_store_n(&pool->spill_lock, 0, __ATOMIC_RELEASE);
+	/* wake worker, which can't pop while we hold lock */
+	if (__atomic_load_n(&pool->spill_count, __ATOMIC_ACQUIRE) > 0)
+		pool_waitq_notify(&pool->task_wq);
+	return task;
+}
+
+/*
+ * take task from queue or from overflow list: overflow list is preferred every LFTHPOOL_SPILL_PERIOD take
+ * (per worker) or when queue is below half, so spilled tasks run under sustained load
+ */
+static task_t *_lfthpool_take(lfthpool_t pool) {
+	task_t *task = NULL;
+	if (__atomic_load_n(&pool->spill_count, __ATOMIC_ACQUIRE) > 0 &&
+			(++lfthpool_take_count % LFTHPOOL_SPILL_PERIOD == 0 ||
+			mpmc_ring_queue_len_relaxed(pool->task_queue) < pool->queue_size / 2)) {
+		task = _lfthpool_spill_pop(pool);
+	}
+	if (task == NULL) {
+		if ((task = mpmc_ring_queue_dequeue(pool->task_queue)) != NULL) {
+			/* wake lfthpool_add_task_try, parked on full queue */
+			pool_waitq_notify(&pool->space_wq);
+		} else if (__atomic_load_n(&pool->spill_count, __ATOMIC_ACQUIRE) > 0) {
+			task = _lfthpool_spill_pop(pool);
+		}
+	}
+	return task;
+}
+
 int lfthpool_add_task(lfthpool_t pool, void (*function)(void *), void* arg) {
 	/* set up task */
-	task_t *task = malloc(sizeof(task_t));
+	task_t *task = _lfthpool_task_new(pool);
 	if (task == NULL) {
 		return -1;
 	}
@@ -135,17 +248,22 @@ int lfthpool_add_task(lfthpool_t pool, void (*function)(void *), void* arg) {
 	task->arg = arg;
 
 	if (mpmc_ring_queue_enqueue(pool->task_queue, task) != QERR_OK) {
-		free(task);
-		errno = EAGAIN;
-		return -1;
+		if (__atomic_load_n(&pool->spill, __ATOMIC_RELAXED) == 0) {
+			_lfthpool_task_free(pool, task);
+			errno = EAGAIN;
+			return -1;
+		}
+		_lfthpool_spill_push(pool, task);
 	}
+	pool_waitq_notify(&pool->task_wq);
 
 	return 0;
 }
 
 int lfthpool_add_task_try(lfthpool_t pool, void (*function)(void *), void* arg, useconds_t usec, int max_try) {
+	pool_waiter_t w;
 	/* set up task */
-	task_t *task = malloc(sizeof(task_t));
+	task_t *task = _lfthpool_task_new(pool);
 	if (task == NULL) {
 		return -1;
 	}
@@ -157,16 +275,33 @@ int lfthpool_add_task_try(lfthpool_t pool, void (*function)(void *), void* arg,
 		qerr_t err = mpmc_ring_queue_enqueue(pool->task_queue, task);
 		if (err == QERR_OK) {
 			break;
+		} else if (err == QERR_FULL && __atomic_load_n(&pool->spill, __ATOMIC_RELAXED)) {
+			_lfthpool_spill_push(pool, task);
+			break;
 		} else if (err != QERR_FULL) {
-			free(task);
+			_lfthpool_task_free(pool, task);
 			return (int) err;
 		} else if (max_try < 0) {
-			free(task);
+			_lfthpool_task_free(pool, task);
 			errno = EAGAIN;
 			return -1;
 		}
-		pool->sleep_func(usec);
+		if (pool->sleep_func) {
+			pool->sleep_func(usec);
+		} else if (usec == 0) {
+			pool->sched.yield(pool->sched.ctx);
+		} else {
+			/* park until worker take task from queue */
+			pool_waitq_prepare(&pool->space_wq, &w, &pool->sched);
+			if (mpmc_ring_queue_len_relaxed(pool->task_queue) < pool->queue_size ||
+					__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE)) {
+				pool_waitq_cancel(&pool->space_wq, &w);
+			} else {
+				pool_waitq_commit(&pool->space_wq, &w, deadline_after(usec));
+			}
+		}
 	}
+	pool_waitq_notify(&pool->task_wq);
 
 	return 0;
 }
@@ -177,6 +312,7 @@ void lfthpool_pause(lfthpool_t pool) {
 
 void lfthpool_resume(lfthpool_t pool) {
 	__atomic_store_n(&(pool->hold), 0, __ATOMIC_RELEASE);
+	pool_waitq_notify_all(&pool->task_wq);
 }
 
 size_t lfthpool_active_tasks(lfthpool_t pool) {
@@ -184,34 +320,51 @@ size_t lfthpool_active_tasks(lfthpool_t pool) {
 }
 
 size_t lfthpool_total_tasks(lfthpool_t pool) {
-	return __atomic_add_fetch(&pool->running_count, 0, __ATOMIC_RELAXED) + mpmc_ring_queue_len_relaxed(pool->task_queue);
+	return __atomic_add_fetch(&pool->running_count, 0, __ATOMIC_RELAXED) + mpmc_ring_queue_len_relaxed(pool->task_queue) +
+		__atomic_load_n(&pool->spill_count, __ATOMIC_RELAXED);
 }
 
-void lfthpool_wait(lfthpool_t pool) {
-	while (1) {
-		if (lfthpool_active_tasks(pool) > 0) {
-			pool->sleep_func(10);
-			continue;
-		}
-		if (mpmc_ring_queue_len_relaxed(pool->task_queue) > 0) {
-			pool->sleep_func(10);
-			continue;
-		}
+static int _lfthpool_is_idle(lfthpool_t pool) {
+	return __atomic_load_n(&pool->running_count, __ATOMIC_ACQUIRE) == 0 &&
+		mpmc_ring_queue_len_relaxed(pool->task_queue) == 0 &&
+		__atomic_load_n(&pool->spill_count, __ATOMIC_ACQUIRE) == 0;
+}
 
-		__atomic_signal_fence(__ATOMIC_ACQUIRE);
+void lfthpool_wait(lfthpool_t pool) {
+	pool_waiter_t w;
+	while (!_lfthpool_is_idle(pool)) {
+		pool_waitq_prepare(&pool->idle_wq, &w, &pool->sched);
 		/* recheck active tasks */
-		if (lfthpool_active_tasks(pool) > 0) {
-			pool->sleep_func(10);
-			continue;
+		if (_lfthpool_is_idle(pool)) {
+			pool_waitq_cancel(&pool->idle_wq, &w);
+			break;
 		}
-		break;
+		pool_waitq_commit(&pool->idle_wq, &w, 0);
+	}
+}
+
+int lfthpool_wait_async(lfthpool_t pool, pool_idle_waiter_t *w) {
+	if (_lfthpool_is_idle(pool))
+		return 0;
+	w->next = __atomic_load_n(&pool->idle_waiters, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&pool->idle_waiters, &w->next, w, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+	}
+	/* recheck after push (pair with fence in _lfthpool_task_done) */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (_lfthpool_is_idle(pool) && __atomic_load_n(&pool->idle_waiters, __ATOMIC_ACQUIRE)) {
+		/* wake other waiters, self is not queued, if found in list */
+		if (pool_idle_wake(__atomic_exchange_n(&pool->idle_waiters, NULL, __ATOMIC_ACQ_REL), w))
+			return 0;
 	}
+	return 1;
 }
 
 void lfthpool_shutdown(lfthpool_t pool) {
 	size_t i;
 	__atomic_store_n(&pool->shutdown, 1, __ATOMIC_RELEASE);
-	for (i = 0; i < pool->thread_count; i++) {
+	pool_waitq_notify_all(&pool->task_wq);
+	pool_waitq_notify_all(&pool->space_wq);
+	for (i = 0; pool->lfthpool && i < pool->thread_count; i++) {
 		if (pool->lfthpool[i]) {
 			pthread_join(pool->lfthpool[i], NULL);
 			pool->lfthpool[i] = 0;
@@ -220,16 +373,39 @@ void lfthpool_shutdown(lfthpool_t pool) {
 }
 
 void lfthpool_destroy(lfthpool_t pool) {
+	task_t *task;
 	if (pool) {
 		lfthpool_shutdown(pool);
 		free(pool->lfthpool);
+		if (pool->task_pool) {
+			while ((task = (task_t *) mpsc_queue_pop(&pool->spill_queue)) != NULL) {
+				_lfthpool_task_free(pool, task);
+			}
+			while (pool->task_queue && (task = mpmc_ring_queue_dequeue(pool->task_queue)) != NULL) {
+				_lfthpool_task_free(pool, task);
+			}
+		}
 		mpmc_ring_queue_delete(pool->task_queue, free);
+		objpool_destroy(pool->task_pool);
+		pool_workers_destroy(&pool->workers);
 		free(pool);
 	}
 }
 
+/* decrement active tasks count and wake lfthpool_wait, if pool is idle */
+static void _lfthpool_task_done(lfthpool_t pool) {
+	if (__atomic_sub_fetch(&pool->running_count, 1, __ATOMIC_ACQ_REL) == 0 &&
+		mpmc_ring_queue_len_relaxed(pool->task_queue) == 0 &&
+		__atomic_load_n(&pool->spill_count, __ATOMIC_ACQUIRE) == 0) {
+		pool_waitq_notify_all(&pool->idle_wq);
+		__atomic_thread_fence(__ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&pool->idle_waiters, __ATOMIC_ACQUIRE))
+			pool_idle_wake(__atomic_exchange_n(&pool->idle_waiters, NULL, __ATOMIC_ACQ_REL), NULL);
+	}
+}
+
 int lfthpool_worker_try_once(lfthpool_t pool) {
-	task_t *task = mpmc_ring_queue_dequeue(pool->task_queue);
+	task_t *task = _lfthpool_take(pool);
 
 	/* wait for notification of new task when pool is empty */
 	if (task == NULL) {
@@ -247,56 +423,85 @@ int lfthpool_worker_try_once(lfthpool_t pool) {
 	/* execute task*/
 	(*task->function)(task->arg);
 
-	free(task);
+	_lfthpool_task_free(pool, task);
 
-	__atomic_sub_fetch(&pool->running_count, 1, __ATOMIC_RELAXED);
+	_lfthpool_task_done(pool);
 
 	return 0;
 }
 
 /* pool background worker */
 static void* _lfthpool_worker(void* p) {
-	lfthpool_t pool = (lfthpool_t) p;
-
+	pool_worker_slot_t *slot = (pool_worker_slot_t *) p;
+	lfthpool_t pool = (lfthpool_t) slot->pool;
+	const pool_sched_t *sched = pool_sched_thread();
+	pool_waiter_t w;
+	uint64_t idle_usecs;
+	/* tasks can read ebr_default() protected objects without critical sections */
+	ebr_t smr = ebr_default();
+
+	if (pool_worker_start(slot) != 0) {
+		/* lfthpool_create_ex fail with setup/worker_init error, don't run tasks */
+		pool_worker_stop(slot);
+		return NULL;
+	}
+	ebr_online(smr);
 	while (1) {
 		task_t *task;
 
 		/* check shutdown flag */		
 		if (__atomic_add_fetch(&pool->shutdown, 0, __ATOMIC_ACQUIRE) == 1) {
+			ebr_offline(smr);
+			pool_worker_stop(slot);
 			return NULL;
 		}
 
 		/* check thread pool hold */
 		if ( __atomic_add_fetch(&(pool->hold), 0, __ATOMIC_RELEASE)) {
-			sleep(1);
+			pool_waitq_prepare(&pool->task_wq, &w, sched);
+			if (__atomic_load_n(&pool->hold, __ATOMIC_ACQUIRE) && !__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE)) {
+				ebr_offline(smr);
+				pool_waitq_commit(&pool->task_wq, &w, 0);
+			} else {
+				pool_waitq_cancel(&pool->task_wq, &w);
+			}
 			continue;
 		}
 
 		/* wait for notification of new task when pool is empty */
-		if ((task = mpmc_ring_queue_dequeue(pool->task_queue)) == NULL) {
-			usleep(1);
-			continue;
+		if ((task = _lfthpool_take(pool)) == NULL) {
+			pool_waitq_prepare(&pool->task_wq, &w, sched);
+			if ((task = _lfthpool_take(pool)) == NULL) {
+				if (!__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE) && !__atomic_load_n(&pool->hold, __ATOMIC_ACQUIRE)) {
+					ebr_offline(smr);
+					/* wake up for shrink arena after idle interval */
+					idle_usecs = pool_worker_idle(slot);
+					pool_waitq_commit(&pool->task_wq, &w, idle_usecs ? deadline_after(idle_usecs) : 0);
+				} else {
+					pool_waitq_cancel(&pool->task_wq, &w);
+				}
+				continue;
+			}
+			pool_waitq_cancel(&pool->task_wq, &w);
 		}
 
 		/* increment active tasks count */
 		__atomic_add_fetch(&pool->running_count, 1, __ATOMIC_RELAXED);
 		
 		/* execute task*/
+		ebr_online(smr);
 		(task->function)(task->arg);
+		/* task don't hold references to protected objects */
+		ebr_quiescent(smr);
+		pool_worker_task_done(slot);
 
-		/* decrement active tasks count */
-		__atomic_sub_fetch(&pool->running_count, 1, __ATOMIC_RELAXED);
+		_lfthpool_task_free(pool, task);
 
-		free(task);
+		/* decrement active tasks count */
+		_lfthpool_task_done(pool);
 	}
 
 	return NULL;
 }
 
-static int sched_usleep(useconds_t usec) {
-	int ret = sched_yield();
-	usleep(usec);
-	return ret;
-}
-
 /* ========================== THREADPOOL THREAD ===================== */
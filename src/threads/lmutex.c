@@ -0,0 +1,23 @@
+#include <threads/lmutex.h>
+#include <threads/futex.h>
+#include <threads/utils.h>
+
+void lmutex_lock_slow(lmutex_t *m) {
+	uint32_t s;
+	int spin = LMUTEX_SPINS;
+	while (--spin >= 0) {
+		s = __atomic_load_n(&m->state, __ATOMIC_RELAXED);
+		if (s == 0 && __atomic_compare_exchange_n(&m->state, &s, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return;
+		if (s == 2)
+			break; /* already have sleepers, don't waste cpu */
+		threads_cpu_relax();
+	}
+	/* mark as contended and park */
+	while (__atomic_exchange_n(&m->state, 2, __ATOMIC_ACQUIRE) != 0)
+		futex_wait(&m->state, 2);
+}
+
+void lmutex_wake(lmutex_t *m) {
+	futex_wake(&m->state, 1);
+}
@@ -1,5 +1,110 @@
+#include <sched.h>
+
 #include <threads/lusem.h>
 
+static void lusem_lock(lusem_t *lsem) {
+    while (__atomic_exchange_n(&lsem->lock, 1, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&lsem->lock, __ATOMIC_RELAXED))
+            sched_yield();
+    }
+}
+
+static void lusem_unlock(lusem_t *lsem) {
+    __atomic_store_n(&lsem->lock, 0, __ATOMIC_RELEASE);
+}
+
+void lusem_handoff(lusem_t *lsem, ssize_t count) {
+    struct lusem_waiter *w;
+    while (count-- > 0) {
+        lusem_lock(lsem);
+        w = lsem->head;
+        if (w) {
+            lsem->head = w->next;
+            if (lsem->head == NULL)
+                lsem->tail = NULL;
+            w->queued = 0;
+            lusem_unlock(lsem);
+            if (w->wake)
+                w->wake(w->arg);
+            else
+                usem_signal(&w->sem);
+        } else {
+            /* waiter decrement count, but not queued yet */
+            lsem->handoff++;
+            lusem_unlock(lsem);
+        }
+    }
+}
+
+static void lusem_unlink(lusem_t *lsem, struct lusem_waiter *w) {
+    struct lusem_waiter *prev = NULL, *cur = lsem->head;
+    while (cur != w) {
+        prev = cur;
+        cur = cur->next;
+    }
+    if (prev)
+        prev->next = w->next;
+    else
+        lsem->head = w->next;
+    if (lsem->tail == w)
+        lsem->tail = prev;
+}
+
+/* Park in FIFO queue and wait for handoff (count already decremented) */
+static int lusem_park(lusem_t *lsem, uint64_t timeout_usecs) {
+    struct lusem_waiter w;
+    ssize_t old_count;
+    int rc;
+
+    lusem_lock(lsem);
+    if (lsem->handoff > 0) {
+        lsem->handoff--;
+        lusem_unlock(lsem);
+        return 0;
+    }
+    w.next = NULL;
+    w.queued = 1;
+    w.wake = NULL;
+    usem_init(&w.sem, 0);
+    if (lsem->tail)
+        lsem->tail->next = &w;
+    else
+        lsem->head = &w;
+    lsem->tail = &w;
+    lusem_unlock(lsem);
+
+    if (timeout_usecs == 0)
+        rc = usem_wait(&w.sem);
+    else
+        rc = usem_timed_wait(&w.sem, timeout_usecs);
+    if (rc == 0) {
+        usem_destroy(&w.sem);
+        return 0;
+    }
+
+    lusem_lock(lsem);
+    if (w.queued) {
+        old_count = __atomic_load_n(&lsem->m_count, __ATOMIC_ACQUIRE);
+        while (old_count < 0) {
+            if (__atomic_compare_exchange_n(&lsem->m_count, &old_count, old_count + 1, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                lusem_unlink(lsem, &w);
+                lusem_unlock(lsem);
+                usem_destroy(&w.sem);
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        }
+    }
+    lusem_unlock(lsem);
+    /*
+    * Count is not negative, so the permit is handed off (or handoff is in flight)
+    * to all queued waiters. Wait for it.
+    */
+    usem_wait(&w.sem);
+    usem_destroy(&w.sem);
+    return 0;
+}
+
 static int lusem_wait_with_part_spin(lusem_t *lsem, uint64_t timeout_usecs) {
     ssize_t old_count;
     int spin = lsem->max_spins;
@@ -13,6 +118,8 @@ static int lusem_wait_with_part_spin(lusem_t *lsem, uint64_t timeout_usecs) {
     old_count = __atomic_fetch_sub(&lsem->m_count, 1, __ATOMIC_ACQUIRE);
     if (old_count > 0)
         return 0;
+    if (lsem->fair)
+        return lusem_park(lsem, timeout_usecs);
     if (timeout_usecs == 0)
     {
         if (usem_wait(&lsem->sem) == 0)
@@ -38,6 +145,34 @@ static int lusem_wait_with_part_spin(lusem_t *lsem, uint64_t timeout_usecs) {
     }
 }
 
+int lusem_wait_async(lusem_t *lsem, lusem_waiter_t *w, void (*wake)(void *arg), void *arg) {
+    if (!lsem->fair) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (lusem_try_wait(lsem) == 0)
+        return 0;
+    if (__atomic_fetch_sub(&lsem->m_count, 1, __ATOMIC_ACQUIRE) > 0)
+        return 0;
+    lusem_lock(lsem);
+    if (lsem->handoff > 0) {
+        lsem->handoff--;
+        lusem_unlock(lsem);
+        return 0;
+    }
+    w->next = NULL;
+    w->queued = 1;
+    w->wake = wake;
+    w->arg = arg;
+    if (lsem->tail)
+        lsem->tail->next = w;
+    else
+        lsem->head = w;
+    lsem->tail = w;
+    lusem_unlock(lsem);
+    return 1;
+}
+
 int lusem_wait(lusem_t *lsem) {
     if (lusem_try_wait(lsem) == 0) {
         return 0;
@@ -0,0 +1,92 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include <threads/mpsc_executor.h>
+#include <threads/eventcount.h>
+#include <threads/event.h>
+
+struct mpsc_executor {
+	mpsc_queue_t queue;
+	eventcount_t ec; /* worker wait for tasks */
+	int shutdown;
+	pthread_t thread;
+};
+
+/**
+ * Wait marker task
+ */
+typedef struct mpsc_wait_task {
+	mpsc_task_t task;
+	event_t done;
+} mpsc_wait_task_t;
+
+static void *_mpsc_executor_worker(void *p) {
+	mpsc_executor_t ex = (mpsc_executor_t) p;
+	mpsc_task_t *task;
+	uint32_t key;
+
+	while (1) {
+		if ((task = (mpsc_task_t *) mpsc_queue_pop(&ex->queue)) != NULL) {
+			task->function(task);
+			continue;
+		}
+		key = eventcount_prepare_wait(&ex->ec);
+		if ((task = (mpsc_task_t *) mpsc_queue_pop(&ex->queue)) != NULL) {
+			eventcount_cancel_wait(&ex->ec);
+			task->function(task);
+			continue;
+		}
+		if (__atomic_load_n(&ex->shutdown, __ATOMIC_ACQUIRE) && mpsc_queue_is_empty(&ex->queue)) {
+			eventcount_cancel_wait(&ex->ec);
+			break;
+		}
+		/* empty or producer is preempted before link, it notify after */
+		eventcount_commit_wait(&ex->ec, key);
+	}
+	return NULL;
+}
+
+mpsc_executor_t mpsc_executor_create(void) {
+	int err;
+	mpsc_executor_t ex = (mpsc_executor_t) malloc(sizeof(struct mpsc_executor));
+	if (ex == NULL)
+		return NULL;
+	mpsc_queue_init(&ex->queue);
+	eventcount_init(&ex->ec);
+	ex->shutdown = 0;
+	if ((err = pthread_create(&ex->thread, NULL, _mpsc_executor_worker, ex)) != 0) {
+		free(ex);
+		errno = err;
+		return NULL;
+	}
+	return ex;
+}
+
+void mpsc_executor_submit(mpsc_executor_t ex, mpsc_task_t *task, void (*function)(mpsc_task_t *task)) {
+	task->function = function;
+	mpsc_queue_push(&ex->queue, &task->node);
+	eventcount_notify(&ex->ec);
+}
+
+static void _mpsc_executor_wait_done(mpsc_task_t *task) {
+	event_set(&((mpsc_wait_task_t *) task)->done);
+}
+
+void mpsc_executor_wait(mpsc_executor_t ex) {
+	mpsc_wait_task_t w;
+	/* tasks are executed in FIFO order, so wait for marker task */
+	event_init(&w.done, 1, 0);
+	mpsc_executor_submit(ex, &w.task, _mpsc_executor_wait_done);
+	event_wait(&w.done);
+	event_destroy(&w.done);
+}
+
+void mpsc_executor_destroy(mpsc_executor_t ex) {
+	if (ex) {
+		__atomic_store_n(&ex->shutdown, 1, __ATOMIC_RELEASE);
+		eventcount_notify_all(&ex->ec);
+		pthread_join(ex->thread, NULL);
+		free(ex);
+	}
+}
@@ -0,0 +1,235 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/objpool.h>
+
+#define OBJPOOL_CACHE_LINE 64
+
+/* stack head: low 32 bits - object index + 1 (0 - empty), high 32 bits - ABA tag */
+#define OBJPOOL_IDX(head) ((uint32_t) ((head) & 0xFFFFFFFFu))
+#define OBJPOOL_HEAD(tag, idx) (((uint64_t) (tag) << 32) | (uint64_t) (idx))
+
+/**
+ * Per-thread cache of free objects
+ */
+typedef struct objpool_magazine {
+	size_t count;
+	void *objs[OBJPOOL_MAGAZINE];
+	struct objpool_magazine *next; /* all magazines (for destroy) */
+	int used; /* owned by thread */
+} objpool_magazine_t;
+
+struct objpool {
+	size_t obj_size;
+	size_t stride;
+	size_t capacity;
+	char *slab;
+	uint32_t *next; /* free stack links (index + 1) */
+	pthread_key_t key;
+	pthread_mutex_t lock; /* magazines list */
+	objpool_magazine_t *magazines;
+	char pad[OBJPOOL_CACHE_LINE];
+	uint64_t head; /* free stack */
+	char pad2[OBJPOOL_CACHE_LINE - sizeof(uint64_t)];
+};
+
+static inline void *objpool_obj(objpool_t pool, uint32_t idx) {
+	return pool->slab + (size_t) (idx - 1) * pool->stride;
+}
+
+static inline uint32_t objpool_idx(objpool_t pool, const void *obj) {
+	return (uint32_t) ((size_t) ((const char *) obj - pool->slab) / pool->stride) + 1;
+}
+
+/* push chain first..last (linked in next) to global stack */
+static void objpool_push_chain(objpool_t pool, uint32_t first, uint32_t last) {
+	uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_RELAXED), new_head;
+	do {
+		__atomic_store_n(&pool->next[last - 1], OBJPOOL_IDX(head), __ATOMIC_RELAXED);
+		new_head = OBJPOOL_HEAD((head >> 32) + 1, first);
+	} while (!__atomic_compare_exchange_n(&pool->head, &head, new_head, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* pop up to n objects from global stack */
+static size_t objpool_pop_chain(objpool_t pool, void **objs, size_t n) {
+	uint64_t head = __atomic_load_n(&pool->head, __ATOMIC_ACQUIRE);
+	uint32_t idx;
+	size_t i;
+	while (1) {
+		if ((idx = OBJPOOL_IDX(head)) == 0)
+			return 0;
+		/* chain below head is stable, while head (with tag) is not changed */
+		for (i = 0; i < n && idx != 0; i++) {
+			objs[i] = objpool_obj(pool, idx);
+			idx = __atomic_load_n(&pool->next[idx - 1], __ATOMIC_RELAXED);
+		}
+		if (__atomic_compare_exchange_n(&pool->head, &head, OBJPOOL_HEAD((head >> 32) + 1, idx), 1,
+				__ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE))
+			return i;
+	}
+}
+
+static void objpool_flush(objpool_t pool, objpool_magazine_t *m, size_t n) {
+	uint32_t first, idx, prev;
+	size_t i;
+	if (n == 0)
+		return;
+	/* link last n objects */
+	first = prev = objpool_idx(pool, m->objs[m->count - 1]);
+	for (i = 2; i <= n; i++) {
+		idx = objpool_idx(pool, m->objs[m->count - i]);
+		__atomic_store_n(&pool->next[prev - 1], idx, __ATOMIC_RELAXED);
+		prev = idx;
+	}
+	objpool_push_chain(pool, first, prev);
+	m->count -= n;
+}
+
+/* thread exit: return objects, magazine is reused by other thread */
+static void objpool_thread_exit(void *p) {
+	objpool_magazine_t *m = (objpool_magazine_t *) p;
+	objpool_t pool = *(objpool_t *) (m + 1);
+	objpool_flush(pool, m, m->count);
+	pthread_mutex_lock(&pool->lock);
+	m->used = 0;
+	pthread_mutex_unlock(&pool->lock);
+}
+
+static objpool_magazine_t *objpool_magazine(objpool_t pool) {
+	objpool_magazine_t *m = (objpool_magazine_t *) pthread_getspecific(pool->key);
+	if (m)
+		return m;
+	pthread_mutex_lock(&pool->lock);
+	for (m = pool->magazines; m; m = m->next) {
+		if (!m->used)
+			break;
+	}
+	if (m == NULL) {
+		/* pool pointer is stored after magazine (for thread exit destructor) */
+		if ((m = (objpool_magazine_t *) malloc(sizeof(objpool_magazine_t) + sizeof(objpool_t))) != NULL) {
+			m->count = 0;
+			*(objpool_t *) (m + 1) = pool;
+			m->next = pool->magazines;
+			pool->magazines = m;
+		}
+	}
+	if (m) {
+		m->used = 1;
+		pthread_setspecific(pool->key, m);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return m;
+}
+
+objpool_t objpool_create(size_t obj_size, size_t capacity) {
+	objpool_t pool;
+	void *p;
+	size_t i;
+	int err;
+
+	if (obj_size == 0 || capacity == 0 || capacity >= UINT32_MAX) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((err = posix_memalign(&p, OBJPOOL_CACHE_LINE, sizeof(struct objpool))) != 0) {
+		errno = err;
+		return NULL;
+	}
+	pool = (objpool_t) p;
+	memset(pool, 0, sizeof(struct objpool));
+	pool->obj_size = obj_size;
+	pool->stride = (obj_size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	pool->capacity = capacity;
+	if ((err = posix_memalign(&p, OBJPOOL_CACHE_LINE, capacity * pool->stride)) != 0)
+		goto ERROR;
+	pool->slab = (char *) p;
+	if ((pool->next = (uint32_t *) malloc(capacity * sizeof(uint32_t))) == NULL) {
+		err = ENOMEM;
+		goto ERROR;
+	}
+	if ((err = pthread_key_create(&pool->key, objpool_thread_exit)) != 0)
+		goto ERROR;
+	if ((err = pthread_mutex_init(&pool->lock, NULL)) != 0) {
+		pthread_key_delete(pool->key);
+		goto ERROR;
+	}
+	for (i = 0; i < capacity; i++) {
+		pool->next[i] = i + 1 < capacity ? (uint32_t) (i + 2) : 0;
+	}
+	pool->head = OBJPOOL_HEAD(0, 1);
+	return pool;
+
+ERROR:
+	free(pool->next);
+	free(pool->slab);
+	free(pool);
+	errno = err;
+	return NULL;
+}
+
+void objpool_destroy(objpool_t pool) {
+	objpool_magazine_t *m, *next;
+	if (pool) {
+		pthread_key_delete(pool->key);
+		for (m = pool->magazines; m; m = next) {
+			next = m->next;
+			free(m);
+		}
+		pthread_mutex_destroy(&pool->lock);
+		free(pool->next);
+		free(pool->slab);
+		free(pool);
+	}
+}
+
+size_t objpool_capacity(objpool_t pool) {
+	return pool->capacity;
+}
+
+void *objpool_get(objpool_t pool) {
+	objpool_magazine_t *m = objpool_magazine(pool);
+	void *obj;
+	if (m == NULL) {
+		/* no memory for magazine, use global stack */
+		if (objpool_pop_chain(pool, &obj, 1) == 1)
+			return obj;
+		errno = ENOMEM;
+		return NULL;
+	}
+	if (m->count == 0) {
+		/* refill half of magazine */
+		if ((m->count = objpool_pop_chain(pool, m->objs, OBJPOOL_MAGAZINE / 2)) == 0) {
+			errno = ENOMEM;
+			return NULL;
+		}
+	}
+	return m->objs[--m->count];
+}
+
+void objpool_put(objpool_t pool, void *obj) {
+	objpool_magazine_t *m = objpool_magazine(pool);
+	uint32_t idx;
+	if (m == NULL) {
+		idx = objpool_idx(pool, obj);
+		objpool_push_chain(pool, idx, idx);
+		return;
+	}
+	if (m->count == OBJPOOL_MAGAZINE) {
+		/* return half of magazine */
+		objpool_flush(pool, m, OBJPOOL_MAGAZINE / 2);
+	}
+	m->objs[m->count++] = obj;
+}
+
+int objpool_owns(objpool_t pool, const void *obj) {
+	return (const char *) obj >= pool->slab && (const char *) obj < pool->slab + pool->capacity * pool->stride;
+}
+
+void objpool_thread_flush(objpool_t pool) {
+	objpool_magazine_t *m = (objpool_magazine_t *) pthread_getspecific(pool->key);
+	if (m)
+		objpool_flush(pool, m, m->count);
+}
@@ -0,0 +1,465 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/event.h>
+#include <threads/parallel.h>
+#include <threads/spinlock.h>
+
+/* accumulators are placed on separate cache lines */
+#define PARALLEL_CACHE_LINE 64
+
+/* bulk memory chunk (fits in L2 cache) */
+#define PARALLEL_BULK_CHUNK (256 * 1024)
+
+/* minimal elements per merge piece (and per block for sort/scan) */
+#define PARALLEL_SORT_PIECE 4096
+
+struct parallel_job;
+
+/**
+ * Participant (helper task argument)
+ */
+typedef struct parallel_slot {
+	struct parallel_job *job;
+	void *acc; /* accumulator (NULL for parallel_for) */
+} parallel_slot_t;
+
+/**
+ * Parallel loop state, shared by caller and helpers (freed by last participant,
+ * so helpers, started after loop end, don't touch caller stack)
+ */
+typedef struct parallel_job {
+	size_t cursor; /* first unclaimed index */
+	char pad[PARALLEL_CACHE_LINE - sizeof(size_t)];
+	size_t end;
+	size_t grain;
+	size_t parts; /* participants (helpers and caller) */
+	size_t total; /* iterations */
+	size_t completed; /* processed iterations (added, when participant leave loop) */
+	int refs;
+	ticketlock_t lock; /* serialize join */
+	event_t done; /* set, when all iterations are processed */
+	parallel_for_fn for_fn;
+	parallel_reduce_fn reduce_fn;
+	parallel_join_fn join;
+	void *ctx;
+	void *result;
+	parallel_slot_t *slots;
+} parallel_job_t;
+
+/* claim next chunk (guided self-scheduling), returns 0, if range is exhausted */
+static int _parallel_claim(parallel_job_t *job, size_t *begin, size_t *end) {
+	size_t cur = __atomic_load_n(&job->cursor, __ATOMIC_RELAXED), chunk;
+	do {
+		if (cur >= job->end)
+			return 0;
+		chunk = (job->end - cur) / (2 * job->parts);
+		if (chunk < job->grain)
+			chunk = job->grain;
+		if (chunk > job->end - cur)
+			chunk = job->end - cur;
+	} while (!__atomic_compare_exchange_n(&job->cursor, &cur, cur + chunk, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	*begin = cur;
+	*end = cur + chunk;
+	return 1;
+}
+
+static void _parallel_participate(parallel_slot_t *slot) {
+	parallel_job_t *job = slot->job;
+	size_t begin, end, n = 0;
+	while (_parallel_claim(job, &begin, &end)) {
+		if (slot->acc)
+			job->reduce_fn(job->ctx, begin, end, slot->acc);
+		else
+			job->for_fn(job->ctx, begin, end);
+		n += end - begin;
+	}
+	if (n == 0)
+		return;
+	if (slot->acc) {
+		ticketlock_lock(&job->lock);
+		job->join(job->ctx, job->result, slot->acc);
+		ticketlock_unlock(&job->lock);
+	}
+	if (__atomic_add_fetch(&job->completed, n, __ATOMIC_ACQ_REL) == job->total)
+		event_set(&job->done);
+}
+
+static void _parallel_release(parallel_job_t *job) {
+	if (__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		event_destroy(&job->done);
+		free(job);
+	}
+}
+
+/* helper task */
+static void _parallel_helper(void *p) {
+	parallel_slot_t *slot = (parallel_slot_t *) p;
+	parallel_job_t *job = slot->job;
+	_parallel_participate(slot);
+	_parallel_release(job);
+}
+
+/* participants (workers and caller) */
+static size_t _parallel_parts(executor_t ex) {
+	executor_stats_t stats;
+	if (ex == NULL)
+		return 1;
+	executor_stats(ex, &stats);
+	return stats.workers + 1;
+}
+
+static int _parallel_run(executor_t ex, size_t begin, size_t end, size_t grain, parallel_for_fn for_fn,
+		parallel_reduce_fn reduce_fn, parallel_join_fn join, void *ctx, void *result, size_t acc_size) {
+	parallel_job_t *job;
+	size_t i, total, helpers, submitted, stride = 0;
+	char *accs;
+
+	if (end <= begin)
+		return 0;
+	if (grain == 0)
+		grain = 1;
+	total = end - begin;
+	helpers = _parallel_parts(ex) - 1;
+	/* chunks count, except caller chunk */
+	if (helpers > (total - 1) / grain)
+		helpers = (total - 1) / grain;
+	if (helpers == 0) {
+		/* result is initialized with identity, so accumulate into it */
+		if (reduce_fn)
+			reduce_fn(ctx, begin, end, result);
+		else
+			for_fn(ctx, begin, end);
+		return 0;
+	}
+
+	if (reduce_fn)
+		stride = (acc_size + PARALLEL_CACHE_LINE - 1) & ~((size_t) PARALLEL_CACHE_LINE - 1);
+	job = (parallel_job_t *) malloc(sizeof(parallel_job_t) + (helpers + 1) * (sizeof(parallel_slot_t) + stride) +
+		(stride ? PARALLEL_CACHE_LINE : 0));
+	if (job == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	job->cursor = begin;
+	job->end = end;
+	job->grain = grain;
+	job->parts = helpers + 1;
+	job->total = total;
+	job->completed = 0;
+	job->refs = (int) helpers + 1;
+	ticketlock_init(&job->lock);
+	event_init(&job->done, 1, 0);
+	job->for_fn = for_fn;
+	job->reduce_fn = reduce_fn;
+	job->join = join;
+	job->ctx = ctx;
+	job->result = result;
+	job->slots = (parallel_slot_t *) (job + 1);
+	accs = (char *) (job->slots + helpers + 1);
+	if (stride)
+		accs += PARALLEL_CACHE_LINE - (size_t) ((uintptr_t) accs % PARALLEL_CACHE_LINE);
+	for (i = 0; i <= helpers; i++) {
+		job->slots[i].job = job;
+		if (stride) {
+			job->slots[i].acc = accs + i * stride;
+			memcpy(job->slots[i].acc, result, acc_size);
+		} else {
+			job->slots[i].acc = NULL;
+		}
+	}
+
+	for (submitted = 0; submitted < helpers; submitted++) {
+		/* queue is full, caller process remaining chunks */
+		if (executor_submit(ex, _parallel_helper, &job->slots[submitted + 1]) != 0)
+			break;
+	}
+	if (submitted < helpers)
+		__atomic_sub_fetch(&job->refs, (int) (helpers - submitted), __ATOMIC_RELAXED);
+
+	_parallel_participate(&job->slots[0]);
+	/* wait for chunks, claimed by helpers */
+	if (__atomic_load_n(&job->completed, __ATOMIC_ACQUIRE) != total)
+		event_wait(&job->done);
+	_parallel_release(job);
+	return 0;
+}
+
+int parallel_for(executor_t ex, size_t begin, size_t end, size_t grain, parallel_for_fn fn, void *ctx) {
+	if (fn == NULL) {
+		errno = EINVAL;
+		return -1;
+	}
+	return _parallel_run(ex, begin, end, grain, fn, NULL, NULL, ctx, NULL, 0);
+}
+
+int parallel_reduce(executor_t ex, size_t begin, size_t end, size_t grain, parallel_reduce_fn fn,
+		parallel_join_fn join, void *ctx, void *result, size_t acc_size) {
+	if (fn == NULL || join == NULL || result == NULL || acc_size == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	return _parallel_run(ex, begin, end, grain, NULL, fn, join, ctx, result, acc_size);
+}
+
+/* ========================== BULK MEMORY =========================== */
+
+/* parallel_for over [0, n) with step 1, run in caller, if parallel_for fail (so kernels don't fail on half way) */
+static void _parallel_steps(executor_t ex, size_t n, parallel_for_fn fn, void *ctx) {
+	if (parallel_for(ex, 0, n, 1, fn, ctx) != 0)
+		fn(ctx, 0, n);
+}
+
+typedef struct parallel_bulk {
+	char *dst;
+	const char *src;
+	int c;
+	size_t n;
+} parallel_bulk_t;
+
+static void _parallel_memcpy_fn(void *ctx, size_t begin, size_t end) {
+	parallel_bulk_t *b = (parallel_bulk_t *) ctx;
+	size_t from = begin * PARALLEL_BULK_CHUNK, to = end * PARALLEL_BULK_CHUNK;
+	if (to > b->n)
+		to = b->n;
+	memcpy(b->dst + from, b->src + from, to - from);
+}
+
+static void _parallel_memset_fn(void *ctx, size_t begin, size_t end) {
+	parallel_bulk_t *b = (parallel_bulk_t *) ctx;
+	size_t from = begin * PARALLEL_BULK_CHUNK, to = end * PARALLEL_BULK_CHUNK;
+	if (to > b->n)
+		to = b->n;
+	memset(b->dst + from, b->c, to - from);
+}
+
+void parallel_memcpy(executor_t ex, void *dst, const void *src, size_t n) {
+	parallel_bulk_t b;
+	size_t chunks = (n + PARALLEL_BULK_CHUNK - 1) / PARALLEL_BULK_CHUNK;
+	if (chunks < 2) {
+		memcpy(dst, src, n);
+		return;
+	}
+	b.dst = (char *) dst;
+	b.src = (const char *) src;
+	b.c = 0;
+	b.n = n;
+	_parallel_steps(ex, chunks, _parallel_memcpy_fn, &b);
+}
+
+void parallel_memset(executor_t ex, void *dst, int c, size_t n) {
+	parallel_bulk_t b;
+	size_t chunks = (n + PARALLEL_BULK_CHUNK - 1) / PARALLEL_BULK_CHUNK;
+	if (chunks < 2) {
+		memset(dst, c, n);
+		return;
+	}
+	b.dst = (char *) dst;
+	b.src = NULL;
+	b.c = c;
+	b.n = n;
+	_parallel_steps(ex, chunks, _parallel_memset_fn, &b);
+}
+
+/* ========================== SCAN ================================== */
+
+typedef struct parallel_scan {
+	const size_t *in;
+	size_t *out;
+	size_t n;
+	size_t block;
+	size_t *sums; /* block sums, then block offsets */
+} parallel_scan_t;
+
+/* pass 1: block sums */
+static void _parallel_scan_sum_fn(void *ctx, size_t begin, size_t end) {
+	parallel_scan_t *sc = (parallel_scan_t *) ctx;
+	size_t k, i, to, sum;
+	for (k = begin; k < end; k++) {
+		to = (k + 1) * sc->block < sc->n ? (k + 1) * sc->block : sc->n;
+		sum = 0;
+		for (i = k * sc->block; i < to; i++)
+			sum += sc->in[i];
+		sc->sums[k] = sum;
+	}
+}
+
+/* pass 2: exclusive scan of block from block offset */
+static void _parallel_scan_fn(void *ctx, size_t begin, size_t end) {
+	parallel_scan_t *sc = (parallel_scan_t *) ctx;
+	size_t k, i, to, sum, v;
+	for (k = begin; k < end; k++) {
+		to = (k + 1) * sc->block < sc->n ? (k + 1) * sc->block : sc->n;
+		sum = sc->sums[k];
+		for (i = k * sc->block; i < to; i++) {
+			/* in can be out */
+			v = sc->in[i];
+			sc->out[i] = sum;
+			sum += v;
+		}
+	}
+}
+
+int parallel_exclusive_scan(executor_t ex, const size_t *in, size_t *out, size_t n, size_t init, size_t *total) {
+	parallel_scan_t sc;
+	size_t k, blocks, sum, v, parts = _parallel_parts(ex);
+
+	blocks = parts * 4;
+	if (blocks > n / PARALLEL_SORT_PIECE)
+		blocks = n / PARALLEL_SORT_PIECE;
+	if (parts == 1 || blocks < 2) {
+		sum = init;
+		for (k = 0; k < n; k++) {
+			v = in[k];
+			out[k] = sum;
+			sum += v;
+		}
+		if (total)
+			*total = sum;
+		return 0;
+	}
+	if ((sc.sums = (size_t *) malloc(blocks * sizeof(size_t))) == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	sc.in = in;
+	sc.out = out;
+	sc.n = n;
+	sc.block = (n + blocks - 1) / blocks;
+	blocks = (n + sc.block - 1) / sc.block;
+	_parallel_steps(ex, blocks, _parallel_scan_sum_fn, &sc);
+	sum = init;
+	for (k = 0; k < blocks; k++) {
+		v = sc.sums[k];
+		sc.sums[k] = sum;
+		sum += v;
+	}
+	_parallel_steps(ex, blocks, _parallel_scan_fn, &sc);
+	free(sc.sums);
+	if (total)
+		*total = sum;
+	return 0;
+}
+
+/* ========================== SORT ================================== */
+
+typedef struct parallel_sort {
+	char *base;
+	size_t n;
+	size_t size;
+	int (*compar)(const void *, const void *);
+	size_t block; /* block size for first pass */
+	/* merge round */
+	const char *src;
+	char *dst;
+	size_t width; /* sorted runs width */
+	size_t piece; /* output elements per merge piece */
+	size_t pieces; /* pieces per runs pair */
+} parallel_sort_t;
+
+/* pass 1: sort blocks */
+static void _parallel_sort_block_fn(void *ctx, size_t begin, size_t end) {
+	parallel_sort_t *so = (parallel_sort_t *) ctx;
+	size_t k, lo, cnt;
+	for (k = begin; k < end; k++) {
+		lo = k * so->block;
+		cnt = lo + so->block < so->n ? so->block : so->n - lo;
+		qsort(so->base + lo * so->size, cnt, so->size, so->compar);
+	}
+}
+
+/* merge path: count of a elements in first d elements of merged a and b (a first on equal) */
+static size_t _parallel_merge_split(const parallel_sort_t *so, const char *a, size_t na, const char *b, size_t nb, size_t d) {
+	size_t lo = d > nb ? d - nb : 0, hi = d < na ? d : na, i;
+	while (lo < hi) {
+		i = lo + (hi - lo) / 2;
+		if (so->compar(a + i * so->size, b + (d - i - 1) * so->size) <= 0)
+			lo = i + 1;
+		else
+			hi = i;
+	}
+	return lo;
+}
+
+/* merge output elements [d0, d1) of sorted a and b */
+static void _parallel_merge_range(const parallel_sort_t *so, const char *a, size_t na, const char *b, size_t nb,
+		size_t d0, size_t d1, char *out) {
+	size_t size = so->size;
+	size_t i = _parallel_merge_split(so, a, na, b, nb, d0), j = d0 - i;
+	size_t ie = _parallel_merge_split(so, a, na, b, nb, d1), je = d1 - ie;
+	out += d0 * size;
+	while (i < ie && j < je) {
+		if (so->compar(b + j * size, a + i * size) < 0) {
+			memcpy(out, b + j * size, size);
+			j++;
+		} else {
+			memcpy(out, a + i * size, size);
+			i++;
+		}
+		out += size;
+	}
+	memcpy(out, a + i * size, (ie - i) * size);
+	out += (ie - i) * size;
+	memcpy(out, b + j * size, (je - j) * size);
+}
+
+/* pass 2: merge pairs of sorted runs, each pair is split to pieces */
+static void _parallel_sort_merge_fn(void *ctx, size_t begin, size_t end) {
+	parallel_sort_t *so = (parallel_sort_t *) ctx;
+	size_t k, lo, mid, hi, d0, d1;
+	for (k = begin; k < end; k++) {
+		lo = k / so->pieces * 2 * so->width;
+		if (lo >= so->n)
+			continue;
+		mid = so->n - lo > so->width ? lo + so->width : so->n;
+		hi = so->n - lo > 2 * so->width ? lo + 2 * so->width : so->n;
+		d0 = k % so->pieces * so->piece;
+		if (d0 >= hi - lo)
+			continue;
+		d1 = d0 + so->piece < hi - lo ? d0 + so->piece : hi - lo;
+		_parallel_merge_range(so, so->src + lo * so->size, mid - lo, so->src + mid * so->size, hi - mid,
+			d0, d1, so->dst + lo * so->size);
+	}
+}
+
+int parallel_sort(executor_t ex, void *base, size_t nmemb, size_t size, int (*compar)(const void *, const void *)) {
+	parallel_sort_t so;
+	char *tmp, *dst;
+	size_t parts = _parallel_parts(ex), pairs;
+
+	if (parts == 1 || nmemb < 2 * PARALLEL_SORT_PIECE) {
+		qsort(base, nmemb, size, compar);
+		return 0;
+	}
+	if ((tmp = (char *) malloc(nmemb * size)) == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	so.base = (char *) base;
+	so.n = nmemb;
+	so.size = size;
+	so.compar = compar;
+	so.block = (nmemb + parts - 1) / parts;
+	so.piece = nmemb / (parts * 4);
+	if (so.piece < PARALLEL_SORT_PIECE)
+		so.piece = PARALLEL_SORT_PIECE;
+	_parallel_steps(ex, (nmemb + so.block - 1) / so.block, _parallel_sort_block_fn, &so);
+
+	/* merge rounds (ping-pong between base and tmp) */
+	so.src = so.base;
+	dst = tmp;
+	for (so.width = so.block; so.width < nmemb; so.width *= 2) {
+		so.dst = dst;
+		pairs = (nmemb + 2 * so.width - 1) / (2 * so.width);
+		so.pieces = (2 * so.width + so.piece - 1) / so.piece;
+		_parallel_steps(ex, pairs * so.pieces, _parallel_sort_merge_fn, &so);
+		dst = (char *) so.src;
+		so.src = so.dst;
+	}
+	if (so.src != so.base)
+		parallel_memcpy(ex, so.base, so.src, nmemb * size);
+	free(tmp);
+	return 0;
+}
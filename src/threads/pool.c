@@ -0,0 +1,447 @@
+#if defined(__linux__)
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pthread_setaffinity_np */
+#endif
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include <threads/futex.h>
+
+#include "pool_worker.h"
+
+static __thread pool_worker_t *pool_worker_current;
+
+const pool_worker_t *pool_current_worker(void) {
+	return pool_worker_current;
+}
+
+arena_t *pool_current_arena(void) {
+	/* public part is first field of slot */
+	return pool_worker_current ? &((pool_worker_slot_t *) pool_worker_current)->arena : NULL;
+}
+
+void pool_attr_init(pool_attr_t *attr, size_t workers, size_t queue_size) {
+	memset(attr, 0, sizeof(pool_attr_t));
+	attr->workers = workers;
+	attr->queue_size = queue_size;
+	attr->min_workers = workers;
+	attr->sched_policy = -1;
+	attr->arena_idle_usecs = POOL_ARENA_IDLE_USECS;
+}
+
+int pool_workers_init(pool_workers_t *ws, void *pool, const pool_attr_t *attr, const char *default_name, pool_worker_slot_t *slots) {
+	size_t i, started = attr->min_workers < attr->workers ? attr->min_workers : attr->workers;
+	memset(ws, 0, sizeof(pool_workers_t));
+	/* setpriority silently clamp value out of range */
+	if (attr->nice < -20 || attr->nice > 19)
+		return EINVAL;
+	if (slots) {
+		memset(slots, 0, attr->workers * sizeof(pool_worker_slot_t));
+		ws->slots = slots;
+	} else if ((ws->slots = (pool_worker_slot_t *) calloc(attr->workers, sizeof(pool_worker_slot_t))) == NULL) {
+		return ENOMEM;
+	} else {
+		ws->slots_owned = 1;
+	}
+	for (i = 0; i < attr->workers; i++) {
+		ws->slots[i].w.index = i;
+		ws->slots[i].pool = pool;
+		ws->slots[i].ws = ws;
+		ws->slots[i].notify_start = i < started;
+		arena_init(&ws->slots[i].arena, 0);
+	}
+	ws->count = attr->workers;
+	ws->init = attr->worker_init;
+	ws->fini = attr->worker_fini;
+	ws->arena_idle_usecs = attr->arena_idle_usecs;
+	ws->stack_size = attr->stack_size;
+	ws->guard_size = attr->guard_size;
+	/* room for "-<index>" suffix */
+	snprintf(ws->name, 11, "%s", attr->name ? attr->name : default_name);
+	ws->nice = attr->nice;
+	ws->sched_policy = attr->sched_policy;
+	ws->sched_priority = attr->sched_priority;
+	if (attr->cpus && attr->cpus_count) {
+		if ((ws->cpus = (int *) malloc(attr->cpus_count * sizeof(int))) == NULL) {
+			/* nothing to destroy for caller on error */
+			pool_workers_destroy(ws);
+			return ENOMEM;
+		}
+		memcpy(ws->cpus, attr->cpus, attr->cpus_count * sizeof(int));
+		ws->cpus_count = attr->cpus_count;
+		ws->cpus_pin = attr->cpus_pin;
+	}
+	/* started on create */
+	latch_init(&ws->started, (uint32_t) started);
+	return 0;
+}
+
+int pool_worker_create(pool_workers_t *ws, size_t index, pthread_t *thread, void *(*worker)(void *)) {
+	pthread_attr_t attr;
+	int err;
+	if (ws->stack_size == 0 && ws->guard_size == 0)
+		return pthread_create(thread, NULL, worker, &ws->slots[index]);
+	if ((err = pthread_attr_init(&attr)) != 0)
+		return err;
+	if (ws->stack_size && (err = pthread_attr_setstacksize(&attr, ws->stack_size)) != 0)
+		goto END;
+	if (ws->guard_size && (err = pthread_attr_setguardsize(&attr, ws->guard_size)) != 0)
+		goto END;
+	err = pthread_create(thread, &attr, worker, &ws->slots[index]);
+END:
+	pthread_attr_destroy(&attr);
+	return err;
+}
+
+void pool_workers_destroy(pool_workers_t *ws) {
+	size_t i;
+	if (ws->slots) {
+		for (i = 0; i < ws->count; i++) {
+			arena_destroy(&ws->slots[i].arena);
+		}
+	}
+	if (ws->slots_owned)
+		free(ws->slots);
+	ws->slots = NULL;
+	free(ws->cpus);
+	ws->cpus = NULL;
+}
+
+int pool_workers_wait(pool_workers_t *ws) {
+	/* wait only if worker setup can fail */
+	if (ws->init == NULL && ws->nice == 0 && ws->sched_policy == -1 && ws->cpus == NULL)
+		return 0;
+	latch_wait(&ws->started);
+	return __atomic_load_n(&ws->err, __ATOMIC_ACQUIRE);
+}
+
+/* apply thread attributes in worker thread, returns 0 on success or error code */
+static int pool_worker_setup(pool_worker_slot_t *slot) {
+	pool_workers_t *ws = slot->ws;
+	char name[32];
+	int err;
+	size_t i;
+
+	snprintf(name, sizeof(name), "%s-%zu", ws->name, slot->w.index);
+	/* thread name limit */
+	name[15] = '\0';
+#if defined(__linux__)
+	prctl(PR_SET_NAME, name, 0, 0, 0);
+	/* nice is per-thread on Linux */
+	if (ws->nice && setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), ws->nice) == -1)
+		return errno;
+#elif defined(__APPLE__)
+	pthread_setname_np(name);
+#endif
+	if (ws->sched_policy != -1) {
+		struct sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = ws->sched_priority;
+		if ((err = pthread_setschedparam(pthread_self(), ws->sched_policy, &param)) != 0)
+			return err;
+	}
+	if (ws->cpus) {
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		if (ws->cpus_pin) {
+			CPU_SET((size_t) ws->cpus[slot->w.index % ws->cpus_count], &set);
+		} else {
+			for (i = 0; i < ws->cpus_count; i++) {
+				CPU_SET((size_t) ws->cpus[i], &set);
+			}
+		}
+		if ((err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) != 0)
+			return err;
+#else
+		(void) i;
+		return ENOTSUP;
+#endif
+	}
+	return 0;
+}
+
+int pool_worker_start(pool_worker_slot_t *slot) {
+	pool_workers_t *ws = slot->ws;
+	int err, expected = 0;
+	pool_worker_current = &slot->w;
+	if ((err = pool_worker_setup(slot)) != 0) {
+		__atomic_compare_exchange_n(&ws->err, &expected, err, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+	} else if (ws->init) {
+		if ((err = ws->init(slot->w.index, &slot->w.ctx)) != 0) {
+			__atomic_compare_exchange_n(&ws->err, &expected, err, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+		} else {
+			slot->inited = 1;
+		}
+	}
+	if (slot->notify_start) {
+		slot->notify_start = 0;
+		latch_count_down(&ws->started, 1);
+	}
+	return err;
+}
+
+void pool_worker_stop(pool_worker_slot_t *slot) {
+	if (slot->inited && slot->ws->fini)
+		slot->ws->fini(slot->w.ctx);
+	/* slot can be reused by new worker thread */
+	slot->inited = 0;
+	slot->w.ctx = NULL;
+	pool_worker_current = NULL;
+}
+
+uint64_t pool_worker_idle(pool_worker_slot_t *slot) {
+	uint64_t remain;
+	if (arena_size(&slot->arena) <= slot->arena.chunk_size)
+		return 0;
+	remain = deadline_remain(slot->arena_used_at + __atomic_load_n(&slot->ws->arena_idle_usecs, __ATOMIC_RELAXED));
+	if (remain == 0)
+		arena_shrink(&slot->arena);
+	return remain;
+}
+
+void *pool_mem_alloc(size_t size, int flags) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	void *p;
+	if (flags & POOL_MEM_HUGEPAGE) {
+		/* page aligned, populated after huge pages advice */
+		p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		return p == MAP_FAILED ? NULL : p;
+	}
+#else
+	(void) flags;
+#endif
+	return malloc(size);
+}
+
+void pool_mem_free(void *p, size_t size, int flags) {
+	if (p == NULL)
+		return;
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	if (flags & POOL_MEM_HUGEPAGE) {
+		munmap(p, size);
+		return;
+	}
+#else
+	(void) flags;
+#endif
+	(void) size;
+	free(p);
+}
+
+int pool_mem_prepare(void *p, size_t size, int flags) {
+	volatile char *c = (volatile char *) p;
+	size_t i, page = (size_t) sysconf(_SC_PAGESIZE);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+	uintptr_t start, end;
+	if (flags & POOL_MEM_HUGEPAGE) {
+		/* advice whole pages only */
+		start = ((uintptr_t) p + page - 1) & ~((uintptr_t) page - 1);
+		end = ((uintptr_t) p + size) & ~((uintptr_t) page - 1);
+		if (end > start)
+			madvise((void *) start, end - start, MADV_HUGEPAGE);
+	}
+#endif
+	if ((flags & POOL_MEM_PREFAULT) && size) {
+		/* write fault on each page */
+		for (i = 0; i < size; i += page) {
+			c[i] = 0;
+		}
+		c[size - 1] = 0;
+	}
+	if ((flags & POOL_MEM_LOCK) && mlock(p, size) != 0)
+		return errno;
+	return 0;
+}
+
+void pool_mem_release(void *p, size_t size, int flags) {
+	if (p && (flags & POOL_MEM_LOCK))
+		munlock(p, size);
+}
+
+int pool_idle_wake(pool_idle_waiter_t *w, const pool_idle_waiter_t *self) {
+	pool_idle_waiter_t *next;
+	int found = 0;
+	for (; w; w = next) {
+		/* waiter can be released by wake */
+		next = w->next;
+		if (w == self)
+			found = 1;
+		else
+			w->wake(w->arg);
+	}
+	return found;
+}
+
+/* ========================== SCHEDULER ============================= */
+
+/* park permit of OS thread (futex word) */
+static __thread uint32_t pool_thread_permit;
+
+static uintptr_t _pool_thread_self(void *ctx) {
+	(void) ctx;
+	return (uintptr_t) &pool_thread_permit;
+}
+
+static void _pool_thread_park(void *ctx, uint64_t deadline) {
+	uint64_t remain;
+	(void) ctx;
+	if (__atomic_exchange_n(&pool_thread_permit, 0, __ATOMIC_ACQUIRE))
+		return;
+	if (deadline == 0) {
+		futex_wait(&pool_thread_permit, 0);
+	} else if ((remain = deadline_remain(deadline)) > 0) {
+		futex_timed_wait(&pool_thread_permit, 0, remain);
+	}
+	__atomic_exchange_n(&pool_thread_permit, 0, __ATOMIC_ACQUIRE);
+}
+
+static void _pool_thread_unpark(void *ctx, uintptr_t token) {
+	uint32_t *permit = (uint32_t *) token;
+	(void) ctx;
+	__atomic_store_n(permit, 1, __ATOMIC_RELEASE);
+	futex_wake(permit, 1);
+}
+
+static void _pool_thread_yield(void *ctx) {
+	(void) ctx;
+	sched_yield();
+}
+
+static const pool_sched_t pool_sched_thread_ops = {
+	NULL,
+	_pool_thread_self,
+	_pool_thread_park,
+	_pool_thread_unpark,
+	_pool_thread_yield
+};
+
+const pool_sched_t *pool_sched_thread(void) {
+	return &pool_sched_thread_ops;
+}
+
+/* ========================== WAIT QUEUE ============================ */
+
+void pool_waitq_init(pool_waitq_t *q) {
+	ticketlock_init(&q->lock);
+	q->head = NULL;
+	q->tail = NULL;
+	q->waiters = 0;
+}
+
+void pool_waitq_prepare(pool_waitq_t *q, pool_waiter_t *w, const pool_sched_t *sched) {
+	w->sched = sched;
+	w->token = sched->self(sched->ctx);
+	w->state = POOL_WAITER_QUEUED;
+	w->next = NULL;
+	ticketlock_lock(&q->lock);
+	w->prev = q->tail;
+	if (q->tail)
+		q->tail->next = w;
+	else
+		q->head = w;
+	q->tail = w;
+	__atomic_add_fetch(&q->waiters, 1, __ATOMIC_SEQ_CST);
+	ticketlock_unlock(&q->lock);
+	/* order waiters increment before condition recheck (pair for pool_waitq_notify) */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+/* remove queued waiter, returns 0, if waiter is already dequeued by wake */
+static int _pool_waitq_remove(pool_waitq_t *q, pool_waiter_t *w) {
+	int removed = 0;
+	ticketlock_lock(&q->lock);
+	if (__atomic_load_n(&w->state, __ATOMIC_RELAXED) == POOL_WAITER_QUEUED) {
+		if (w->prev)
+			w->prev->next = w->next;
+		else
+			q->head = w->next;
+		if (w->next)
+			w->next->prev = w->prev;
+		else
+			q->tail = w->prev;
+		__atomic_sub_fetch(&q->waiters, 1, __ATOMIC_RELAXED);
+		removed = 1;
+	}
+	ticketlock_unlock(&q->lock);
+	return removed;
+}
+
+/* wait for unpark done by waker (waiter must be valid until it) */
+static void _pool_waiter_woken(pool_waiter_t *w) {
+	while (__atomic_load_n(&w->state, __ATOMIC_ACQUIRE) != POOL_WAITER_WOKEN)
+		w->sched->yield(w->sched->ctx);
+}
+
+void pool_waitq_cancel(pool_waitq_t *q, pool_waiter_t *w) {
+	if (_pool_waitq_remove(q, w))
+		return;
+	_pool_waiter_woken(w);
+	/* pass consumed wake to other waiter */
+	pool_waitq_notify(q);
+}
+
+int pool_waitq_commit(pool_waitq_t *q, pool_waiter_t *w, uint64_t deadline) {
+	int state;
+	while ((state = __atomic_load_n(&w->state, __ATOMIC_ACQUIRE)) != POOL_WAITER_WOKEN) {
+		if (state == POOL_WAITER_DEQUEUED) {
+			_pool_waiter_woken(w);
+			break;
+		}
+		if (deadline && deadline_now() >= deadline) {
+			if (_pool_waitq_remove(q, w)) {
+				errno = ETIMEDOUT;
+				return -1;
+			}
+			continue;
+		}
+		w->sched->park(w->sched->ctx, deadline);
+	}
+	return 0;
+}
+
+void pool_waitq_wake(pool_waitq_t *q, int count) {
+	pool_waiter_t *w, *next, *list, *last = NULL;
+	const pool_sched_t *sched;
+	uintptr_t token;
+	size_t n = 0;
+
+	ticketlock_lock(&q->lock);
+	list = q->head;
+	for (w = list; w && count != 0; w = w->next, count--) {
+		__atomic_store_n(&w->state, POOL_WAITER_DEQUEUED, __ATOMIC_RELAXED);
+		last = w;
+		n++;
+	}
+	if (last) {
+		q->head = last->next;
+		if (q->head)
+			q->head->prev = NULL;
+		else
+			q->tail = NULL;
+		last->next = NULL;
+		__atomic_sub_fetch(&q->waiters, n, __ATOMIC_RELAXED);
+	}
+	ticketlock_unlock(&q->lock);
+
+	for (w = last ? list : NULL; w; w = next) {
+		/* waiter is released after state change */
+		next = w->next;
+		sched = w->sched;
+		token = w->token;
+		sched->unpark(sched->ctx, token);
+		__atomic_store_n(&w->state, POOL_WAITER_WOKEN, __ATOMIC_RELEASE);
+	}
+}
@@ -0,0 +1,150 @@
+#ifndef _THREADS_POOL_WORKER_H_
+#define _THREADS_POOL_WORKER_H_
+
+#include <pthread.h>
+
+#include <threads/arena.h>
+#include <threads/latch.h>
+#include <threads/pool.h>
+#include <threads/spinlock.h>
+
+#include "deadline.h"
+
+/* Worker hooks and current worker, shared by thpool and lfthpool */
+
+struct pool_workers;
+
+typedef struct pool_worker_slot {
+	pool_worker_t w; /* returned by pool_current_worker */
+	void *pool;
+	struct pool_workers *ws;
+	int inited; /* worker_init succeed */
+	int live; /* worker thread is started and not exited (for on demand start) */
+	int notify_start; /* count down started latch */
+	arena_t arena; /* reset after each task */
+	uint64_t arena_used_at; /* last time, when arena grow beyond first chunk */
+} pool_worker_slot_t;
+
+typedef struct pool_workers {
+	pool_worker_slot_t *slots; /* passed to worker threads */
+	int slots_owned; /* slots are allocated by pool_workers_init */
+	size_t count;
+	pool_worker_init_t init;
+	pool_worker_fini_t fini;
+	latch_t started; /* worker_init done */
+	int err; /* first worker_init (or worker thread setup) error */
+	uint64_t arena_idle_usecs; /* shrink arena after idle interval */
+	/* thread attributes */
+	size_t stack_size;
+	size_t guard_size;
+	char name[16]; /* names prefix */
+	int nice;
+	int sched_policy;
+	int sched_priority;
+	int *cpus;
+	size_t cpus_count;
+	int cpus_pin;
+} pool_workers_t;
+
+/* returns 0 on success or error code, slots is attr->workers slots memory (NULL - allocated) */
+int pool_workers_init(pool_workers_t *ws, void *pool, const pool_attr_t *attr, const char *default_name, pool_worker_slot_t *slots);
+
+/* create worker thread with pool attributes, returns 0 on success or error code */
+int pool_worker_create(pool_workers_t *ws, size_t index, pthread_t *thread, void *(*worker)(void *));
+
+void pool_workers_destroy(pool_workers_t *ws);
+
+/* wait for worker_init in all workers, returns first error */
+int pool_workers_wait(pool_workers_t *ws);
+
+/* called in worker thread before first task, returns 0 or setup/worker_init error */
+int pool_worker_start(pool_worker_slot_t *slot);
+
+/* called in worker thread before exit */
+void pool_worker_stop(pool_worker_slot_t *slot);
+
+/* called in worker thread after each task */
+static inline void pool_worker_task_done(pool_worker_slot_t *slot) {
+	if (arena_grown(&slot->arena))
+		slot->arena_used_at = deadline_now();
+	arena_reset(&slot->arena);
+}
+
+/*
+ * called in worker thread before sleep, shrink arena after idle interval.
+ * returns sleep timeout (0 - arena is shrinked, wait without timeout)
+ */
+uint64_t pool_worker_idle(pool_worker_slot_t *slot);
+
+/* call wake for idle waiters list, except self, returns 1 if self is found in list */
+int pool_idle_wake(pool_idle_waiter_t *w, const pool_idle_waiter_t *self);
+
+/* pool memory (flags are POOL_MEM_*), anonymous mapping is used for huge pages, returns NULL on error (errno is set) */
+void *pool_mem_alloc(size_t size, int flags);
+
+void pool_mem_free(void *p, size_t size, int flags);
+
+/* apply flags to memory (huge pages advice, prefault, mlock), returns 0 on success or error code */
+int pool_mem_prepare(void *p, size_t size, int flags);
+
+/* unlock memory, locked by pool_mem_prepare */
+void pool_mem_release(void *p, size_t size, int flags);
+
+/*
+ * Wait queue for pool blocking paths, waiters are parked with scheduler adapter (see pool_sched_t).
+ * Protocol is like eventcount: prepare, recheck condition, commit or cancel.
+ */
+
+#define POOL_WAITER_QUEUED   0
+#define POOL_WAITER_DEQUEUED 1 /* dequeued by wake, unpark is in progress */
+#define POOL_WAITER_WOKEN    2 /* unpark is done, waiter can be released */
+
+typedef struct pool_waiter {
+	struct pool_waiter *next;
+	struct pool_waiter *prev;
+	const pool_sched_t *sched;
+	uintptr_t token;
+	int state; /* POOL_WAITER_* */
+} pool_waiter_t;
+
+typedef struct pool_waitq {
+	ticketlock_t lock;
+	pool_waiter_t *head;
+	pool_waiter_t *tail;
+	size_t waiters;
+} pool_waitq_t;
+
+void pool_waitq_init(pool_waitq_t *q);
+
+/* announce wait (condition must be rechecked after this) */
+void pool_waitq_prepare(pool_waitq_t *q, pool_waiter_t *w, const pool_sched_t *sched);
+
+/* cancel prepared wait (condition is satisfied) */
+void pool_waitq_cancel(pool_waitq_t *q, pool_waiter_t *w);
+
+/* park until wake or deadline (0 - without deadline), returns 0 on wake or -1 on timeout (errno is ETIMEDOUT) */
+int pool_waitq_commit(pool_waitq_t *q, pool_waiter_t *w, uint64_t deadline);
+
+/* wake count waiters (-1 - all) */
+void pool_waitq_wake(pool_waitq_t *q, int count);
+
+/* wake one waiter (call it after condition change) */
+static inline void pool_waitq_notify(pool_waitq_t *q) {
+	/* order condition change before waiters check (pair for pool_waitq_prepare) */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&q->waiters, __ATOMIC_RELAXED))
+		pool_waitq_wake(q, 1);
+}
+
+/* wake all waiters (call it after condition change) */
+static inline void pool_waitq_notify_all(pool_waitq_t *q) {
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&q->waiters, __ATOMIC_RELAXED))
+		pool_waitq_wake(q, -1);
+}
+
+static inline void pool_workers_set_arena_idle(pool_workers_t *ws, uint64_t usecs) {
+	__atomic_store_n(&ws->arena_idle_usecs, usecs, __ATOMIC_RELAXED);
+}
+
+#endif /* _THREADS_POOL_WORKER_H_ */
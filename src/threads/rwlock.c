@@ -0,0 +1,63 @@
+#include <limits.h>
+#include <sched.h>
+
+#include <threads/rwlock.h>
+#include <threads/futex.h>
+#include <threads/utils.h>
+
+void rwlock_rdlock_slow(rwlock_t *l) {
+	uint32_t s, seq;
+	int spin = l->max_spins;
+	while (1) {
+		s = __atomic_load_n(&l->state, __ATOMIC_RELAXED);
+		if ((s & (RWLOCK_WRITER | RWLOCK_WRITERS_MASK)) == 0) {
+			if (__atomic_compare_exchange_n(&l->state, &s, s + 1, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				return;
+			continue;
+		}
+		if (--spin >= 0) {
+			threads_cpu_relax();
+			continue;
+		}
+		seq = __atomic_load_n(&l->rseq, __ATOMIC_ACQUIRE);
+		__atomic_add_fetch(&l->rwait, 1, __ATOMIC_SEQ_CST);
+		s = __atomic_load_n(&l->state, __ATOMIC_SEQ_CST);
+		if ((s & (RWLOCK_WRITER | RWLOCK_WRITERS_MASK)) != 0)
+			futex_wait(&l->rseq, seq);
+		__atomic_sub_fetch(&l->rwait, 1, __ATOMIC_RELAXED);
+	}
+}
+
+void rwlock_wrlock_slow(rwlock_t *l) {
+	uint32_t s, seq;
+	int spin = l->max_spins;
+	/* register as waiting writer, so new readers can't acquire lock */
+	__atomic_add_fetch(&l->state, RWLOCK_WRITER_WAIT, __ATOMIC_RELAXED);
+	while (1) {
+		s = __atomic_load_n(&l->state, __ATOMIC_RELAXED);
+		if ((s & (RWLOCK_READERS_MASK | RWLOCK_WRITER)) == 0) {
+			if (__atomic_compare_exchange_n(&l->state, &s, s - RWLOCK_WRITER_WAIT + RWLOCK_WRITER, 1, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				return;
+			continue;
+		}
+		if (--spin >= 0) {
+			threads_cpu_relax();
+			continue;
+		}
+		seq = __atomic_load_n(&l->wseq, __ATOMIC_ACQUIRE);
+		s = __atomic_load_n(&l->state, __ATOMIC_SEQ_CST);
+		if ((s & (RWLOCK_READERS_MASK | RWLOCK_WRITER)) != 0)
+			futex_wait(&l->wseq, seq);
+	}
+}
+
+void rwlock_wake(rwlock_t *l, uint32_t state) {
+	if ((state & RWLOCK_WRITERS_MASK) != 0) {
+		/* writer preference */
+		__atomic_add_fetch(&l->wseq, 1, __ATOMIC_RELEASE);
+		futex_wake(&l->wseq, 1);
+	} else {
+		__atomic_add_fetch(&l->rseq, 1, __ATOMIC_RELEASE);
+		futex_wake(&l->rseq, INT_MAX);
+	}
+}
@@ -0,0 +1,68 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <threads/spsc_ring.h>
+
+#include "deadline.h"
+
+int spsc_ring_init(spsc_ring_t *r, size_t size, int flags) {
+	size_t n = 2;
+	while (n < size)
+		n <<= 1;
+	memset(r, 0, sizeof(spsc_ring_t));
+	if ((r->items = (void **) malloc(n * sizeof(void *))) == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	r->mask = n - 1;
+	r->flags = flags;
+	eventcount_init(&r->not_empty);
+	eventcount_init(&r->not_full);
+	return 0;
+}
+
+void spsc_ring_destroy(spsc_ring_t *r) {
+	free(r->items);
+	r->items = NULL;
+}
+
+void spsc_ring_push_wait(spsc_ring_t *r, void *item) {
+	uint32_t key;
+	while (spsc_ring_push(r, item) == -1) {
+		key = eventcount_prepare_wait(&r->not_full);
+		if (spsc_ring_push(r, item) == 0) {
+			eventcount_cancel_wait(&r->not_full);
+			break;
+		}
+		eventcount_commit_wait(&r->not_full, key);
+	}
+}
+
+size_t spsc_ring_pop_wait(spsc_ring_t *r, void **items, size_t n, uint64_t timeout_usecs) {
+	uint32_t key;
+	size_t popped;
+	uint64_t deadline = 0, remain;
+
+	if (timeout_usecs)
+		deadline = deadline_after(timeout_usecs);
+	while ((popped = spsc_ring_pop_batch(r, items, n)) == 0) {
+		key = eventcount_prepare_wait(&r->not_empty);
+		if ((popped = spsc_ring_pop_batch(r, items, n)) > 0) {
+			eventcount_cancel_wait(&r->not_empty);
+			break;
+		}
+		if (timeout_usecs == 0) {
+			eventcount_commit_wait(&r->not_empty, key);
+			continue;
+		}
+		if ((remain = deadline_remain(deadline)) == 0) {
+			eventcount_cancel_wait(&r->not_empty);
+			errno = ETIMEDOUT;
+			break;
+		}
+		if (eventcount_commit_timed_wait(&r->not_empty, key, remain) == -1)
+			break;
+	}
+	return popped;
+}
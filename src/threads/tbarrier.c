@@ -0,0 +1,64 @@
+#include <errno.h>
+#include <limits.h>
+
+#include <threads/tbarrier.h>
+#include <threads/futex.h>
+#include <threads/utils.h>
+
+#include "deadline.h"
+
+/* check clock once per spin iterations */
+#define TBARRIER_SPIN_CHECK 64
+
+int tbarrier_init(tbarrier_t *b, uint32_t count, uint32_t spin_usecs) {
+	if (count == 0) {
+		errno = EINVAL;
+		return -1;
+	}
+	b->count = count;
+	/* spinning waiters steal cpu from not arrived threads, when cpus are oversubscribed */
+	b->spin_usecs = count > (uint32_t) threads_cpu_count() ? 0 : spin_usecs;
+	b->arrived = 0;
+	b->round = 0;
+	b->waiters = 0;
+	return 0;
+}
+
+void tbarrier_destroy(tbarrier_t *b) {
+	(void) b;
+}
+
+int tbarrier_wait(tbarrier_t *b) {
+	uint32_t round = __atomic_load_n(&b->round, __ATOMIC_ACQUIRE);
+	uint64_t deadline;
+	unsigned i;
+
+	if (__atomic_add_fetch(&b->arrived, 1, __ATOMIC_ACQ_REL) == b->count) {
+		/* last arrived, reset counter (no one touch it until round changed) and reverse sense */
+		__atomic_store_n(&b->arrived, 0, __ATOMIC_RELAXED);
+		__atomic_store_n(&b->round, round + 1, __ATOMIC_SEQ_CST);
+		if (__atomic_exchange_n(&b->waiters, 0, __ATOMIC_SEQ_CST))
+			futex_wake(&b->round, INT_MAX);
+		return TBARRIER_SERIAL_THREAD;
+	}
+
+	if (b->spin_usecs) {
+		deadline = deadline_after(b->spin_usecs);
+		for (i = 1; ; i++) {
+			if (__atomic_load_n(&b->round, __ATOMIC_ACQUIRE) != round)
+				return 0;
+			if (i % TBARRIER_SPIN_CHECK == 0 && deadline_remain(deadline) == 0)
+				break;
+			threads_cpu_relax();
+		}
+	}
+
+	while (1) {
+		__atomic_store_n(&b->waiters, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&b->round, __ATOMIC_SEQ_CST) != round)
+			break;
+		futex_wait(&b->round, round);
+	}
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/arena.h>
+#include <threads/lfthpool.h>
+#include <threads/thpool.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define CHUNK 4096
+#define TASKS 1000
+
+CTEST(arena, alloc) {
+	arena_t a;
+	char *p[CHUNK], *first;
+	size_t i, size;
+
+	arena_init(&a, CHUNK);
+	ASSERT_EQUAL_U(0, arena_size(&a));
+	for (i = 0; i < 100; i++) {
+		p[i] = (char *) arena_alloc(&a, i);
+		ASSERT_NOT_NULL(p[i]);
+		ASSERT_EQUAL_U(0, (uintptr_t) p[i] % ARENA_ALIGN);
+		memset(p[i], (int) i, i);
+		if (i > 0)
+			ASSERT_TRUE(p[i] != p[i - 1]);
+	}
+	for (i = 0; i < 100; i++) {
+		if (i > 0) {
+			ASSERT_EQUAL((int) (char) i, p[i][0]);
+			ASSERT_EQUAL((int) (char) i, p[i][i - 1]);
+		}
+	}
+	/* grow */
+	ASSERT_TRUE(arena_grown(&a));
+	size = arena_size(&a);
+	ASSERT_TRUE(size > CHUNK);
+
+	/* reset: chunks are reused */
+	arena_reset(&a);
+	ASSERT_FALSE(arena_grown(&a));
+	first = (char *) arena_alloc(&a, 1);
+	ASSERT_TRUE(first == p[0]);
+	for (i = 1; i < 100; i++) {
+		ASSERT_NOT_NULL(arena_alloc(&a, i));
+	}
+	ASSERT_EQUAL_U(size, arena_size(&a));
+
+	/* large allocation */
+	ASSERT_NOT_NULL(arena_alloc(&a, CHUNK * 4));
+	ASSERT_TRUE(arena_size(&a) >= size + CHUNK * 4);
+
+	arena_shrink(&a);
+	ASSERT_EQUAL_U(CHUNK, arena_size(&a));
+	ASSERT_TRUE(first == (char *) arena_alloc(&a, 1));
+	arena_destroy(&a);
+	ASSERT_EQUAL_U(0, arena_size(&a));
+}
+
+CTEST(arena, overflow) {
+	arena_t a;
+	size_t i;
+
+	arena_init(&a, CHUNK);
+	ASSERT_NOT_NULL(arena_alloc(&a, 1));
+	for (i = 0; i < ARENA_ALIGN; i++) {
+		errno = 0;
+		ASSERT_NULL(arena_alloc(&a, SIZE_MAX - i));
+		ASSERT_EQUAL(ENOMEM, errno);
+	}
+	errno = 0;
+	ASSERT_NULL(arena_alloc_slow(&a, SIZE_MAX - ARENA_ALIGN + 1));
+	ASSERT_EQUAL(ENOMEM, errno);
+	/* arena is not changed */
+	ASSERT_EQUAL_U(CHUNK, arena_size(&a));
+	ASSERT_NOT_NULL(arena_alloc(&a, 1));
+	arena_destroy(&a);
+}
+
+CTEST(arena, oversized_first) {
+	arena_t a;
+
+	arena_init(&a, CHUNK);
+	ASSERT_NOT_NULL(arena_alloc(&a, CHUNK * 2));
+	ASSERT_TRUE(arena_grown(&a));
+	arena_shrink(&a);
+	ASSERT_EQUAL_U(0, arena_size(&a));
+	ASSERT_NOT_NULL(arena_alloc(&a, 1));
+	ASSERT_EQUAL_U(CHUNK, arena_size(&a));
+	ASSERT_FALSE(arena_grown(&a));
+	arena_destroy(&a);
+}
+
+struct arena_param {
+	void *first; /* first allocation in task */
+	size_t size; /* arena size at task start */
+	size_t errors;
+};
+
+static void arena_task(void *p) {
+	struct arena_param *param = (struct arena_param *) p;
+	arena_t *a = pool_current_arena();
+	void *ptr;
+	if (a == NULL) {
+		param->errors++;
+		return;
+	}
+	param->size = arena_size(a);
+	ptr = arena_alloc(a, 64);
+	/* arena is reset after previous task */
+	if (param->first && ptr != param->first)
+		param->errors++;
+	param->first = ptr;
+	/* temporaries */
+	if (arena_alloc(a, ARENA_CHUNK_SIZE * 2) == NULL)
+		param->errors++;
+}
+
+static void arena_size_task(void *p) {
+	struct arena_param *param = (struct arena_param *) p;
+	param->size = arena_size(pool_current_arena());
+}
+
+CTEST(arena, lfthpool) {
+	struct arena_param param;
+	lfthpool_t pool = lfthpool_create(1, 16);
+	size_t i;
+	int n;
+
+	ASSERT_NOT_NULL(pool);
+	ASSERT_NULL(pool_current_arena());
+	memset(&param, 0, sizeof(param));
+	lfthpool_set_arena_idle(pool, 10000);
+	for (i = 0; i < TASKS; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task_try(pool, arena_task, &param, 100, 1000000));
+	}
+	lfthpool_wait(pool);
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_TRUE(param.size > ARENA_CHUNK_SIZE);
+	/* shrinked after idle interval */
+	for (n = 0; n < 100; n++) {
+		usleep(20000);
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, arena_size_task, &param));
+		lfthpool_wait(pool);
+		if (param.size == ARENA_CHUNK_SIZE)
+			break;
+	}
+	ASSERT_EQUAL_U(ARENA_CHUNK_SIZE, param.size);
+	lfthpool_destroy(pool);
+}
+
+CTEST(arena, thpool) {
+	struct arena_param param;
+	thpool_t pool = thpool_create(1, 16);
+	size_t i;
+	int n;
+
+	ASSERT_NOT_NULL(pool);
+	memset(&param, 0, sizeof(param));
+	thpool_set_arena_idle(pool, 10000);
+	for (i = 0; i < TASKS; i++) {
+		ASSERT_EQUAL(0, thpool_add_task_try(pool, arena_task, &param, 100, 1000000));
+	}
+	thpool_wait(pool);
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_TRUE(param.size > ARENA_CHUNK_SIZE);
+	for (n = 0; n < 100; n++) {
+		usleep(20000);
+		ASSERT_EQUAL(0, thpool_add_task(pool, arena_size_task, &param));
+		thpool_wait(pool);
+		if (param.size == ARENA_CHUNK_SIZE)
+			break;
+	}
+	ASSERT_EQUAL_U(ARENA_CHUNK_SIZE, param.size);
+	thpool_destroy(pool);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
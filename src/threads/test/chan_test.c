@@ -0,0 +1,299 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/chan.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define PRODUCERS 2
+#define CONSUMERS 3
+#define LOOPS 20000
+
+struct chan_param {
+	chan_t ch;
+	chan_t ch2;
+	size_t sum;
+	size_t count;
+};
+
+static void *producer_thread(void *p) {
+	struct chan_param *param = (struct chan_param *) p;
+	size_t i;
+	for (i = 1; i <= LOOPS; i++) {
+		if (chan_send(param->ch, &i) != 0)
+			abort();
+	}
+	return NULL;
+}
+
+static void *consumer_thread(void *p) {
+	struct chan_param *param = (struct chan_param *) p;
+	size_t v;
+	while (chan_recv(param->ch, &v) == 0) {
+		__atomic_add_fetch(&param->sum, v, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&param->count, 1, __ATOMIC_RELAXED);
+	}
+	if (errno != EPIPE)
+		abort();
+	return NULL;
+}
+
+static void *select_thread(void *p) {
+	struct chan_param *param = (struct chan_param *) p;
+	size_t v1, v2;
+	int closed = 0, idx;
+	chan_case_t cases[2];
+
+	cases[0].ch = param->ch;
+	cases[0].op = CHAN_RECV;
+	cases[0].data = &v1;
+	cases[1].ch = param->ch2;
+	cases[1].op = CHAN_RECV;
+	cases[1].data = &v2;
+	/* until both channels are closed */
+	while (closed < 2) {
+		if ((idx = chan_select(cases, closed ? 1 : 2, 1)) < 0)
+			abort();
+		if (cases[idx].err == EPIPE) {
+			closed++;
+			/* move closed channel to end */
+			if (idx == 0) {
+				cases[0] = cases[1];
+			}
+			continue;
+		}
+		__atomic_add_fetch(&param->sum, *(size_t *) cases[idx].data, __ATOMIC_RELAXED);
+		__atomic_add_fetch(&param->count, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+CTEST(chan, buffered) {
+	chan_t ch = chan_create(sizeof(int), 3);
+	int i, v;
+	ASSERT_NOT_NULL(ch);
+	ASSERT_EQUAL_U(3, chan_cap(ch));
+	for (i = 0; i < 3; i++) {
+		ASSERT_EQUAL(0, chan_try_send(ch, &i));
+	}
+	ASSERT_EQUAL_U(3, chan_len(ch));
+	ASSERT_EQUAL(-1, chan_try_send(ch, &i));
+	ASSERT_EQUAL(EAGAIN, errno);
+	ASSERT_EQUAL(-1, chan_timed_send(ch, &i, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	for (i = 0; i < 3; i++) {
+		ASSERT_EQUAL(0, chan_recv(ch, &v));
+		ASSERT_EQUAL(i, v);
+	}
+	ASSERT_EQUAL(-1, chan_try_recv(ch, &v));
+	ASSERT_EQUAL(EAGAIN, errno);
+	ASSERT_EQUAL(-1, chan_timed_recv(ch, &v, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	chan_destroy(ch);
+}
+
+CTEST(chan, close) {
+	chan_t ch = chan_create(sizeof(int), 4);
+	int i = 1, v;
+	ASSERT_NOT_NULL(ch);
+	ASSERT_EQUAL(0, chan_send(ch, &i));
+	chan_close(ch);
+	ASSERT_EQUAL(1, chan_is_closed(ch));
+	ASSERT_EQUAL(-1, chan_send(ch, &i));
+	ASSERT_EQUAL(EPIPE, errno);
+	/* drain */
+	ASSERT_EQUAL(0, chan_recv(ch, &v));
+	ASSERT_EQUAL(1, v);
+	ASSERT_EQUAL(-1, chan_recv(ch, &v));
+	ASSERT_EQUAL(EPIPE, errno);
+	ASSERT_EQUAL(-1, chan_try_recv(ch, &v));
+	ASSERT_EQUAL(EPIPE, errno);
+	chan_destroy(ch);
+}
+
+CTEST(chan, unbuffered) {
+	struct chan_param param;
+	pthread_t t;
+	size_t v = 1;
+
+	memset(&param, 0, sizeof(param));
+	param.ch = chan_create(sizeof(size_t), 0);
+	ASSERT_NOT_NULL(param.ch);
+	ASSERT_EQUAL_U(0, chan_cap(param.ch));
+	/* no receiver */
+	ASSERT_EQUAL(-1, chan_try_send(param.ch, &v));
+	ASSERT_EQUAL(EAGAIN, errno);
+
+	pthread_create(&t, NULL, consumer_thread, &param);
+	for (v = 1; v <= LOOPS; v++) {
+		ASSERT_EQUAL(0, chan_send(param.ch, &v));
+		/* send return, when receiver got message */
+		ASSERT_EQUAL_U(0, chan_len(param.ch));
+	}
+	chan_close(param.ch);
+	pthread_join(t, NULL);
+	ASSERT_EQUAL_U(LOOPS, param.count);
+	ASSERT_EQUAL_U((size_t) LOOPS * (LOOPS + 1) / 2, param.sum);
+	chan_destroy(param.ch);
+}
+
+static void *send_thread(void *p) {
+	struct chan_param *param = (struct chan_param *) p;
+	size_t v = 1;
+	if (chan_send(param->ch, &v) == 0)
+		param->count = 0;
+	else
+		param->count = (size_t) errno;
+	return NULL;
+}
+
+CTEST(chan, unbuffered_withdraw) {
+	struct chan_param param;
+	pthread_t t;
+	size_t v = 1;
+
+	memset(&param, 0, sizeof(param));
+	param.ch = chan_create(sizeof(size_t), 0);
+	ASSERT_NOT_NULL(param.ch);
+
+	/* no receiver: message is withdrawn, not received later */
+	ASSERT_EQUAL(-1, chan_timed_send(param.ch, &v, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	ASSERT_EQUAL_U(0, chan_len(param.ch));
+	ASSERT_EQUAL(-1, chan_try_recv(param.ch, &v));
+	ASSERT_EQUAL(EAGAIN, errno);
+
+	/* receiver waits: message is delivered */
+	pthread_create(&t, NULL, consumer_thread, &param);
+	for (v = 1; v <= 100; v++) {
+		ASSERT_EQUAL(0, chan_timed_send(param.ch, &v, 10000000));
+	}
+	chan_close(param.ch);
+	pthread_join(t, NULL);
+	ASSERT_EQUAL_U(100, param.count);
+	ASSERT_EQUAL_U(100 * 101 / 2, param.sum);
+	chan_destroy(param.ch);
+
+	/* close before receiver got message: message is withdrawn */
+	param.ch = chan_create(sizeof(size_t), 0);
+	ASSERT_NOT_NULL(param.ch);
+	param.count = 1;
+	pthread_create(&t, NULL, send_thread, &param);
+	while (chan_len(param.ch) == 0)
+		usleep(100);
+	chan_close(param.ch);
+	pthread_join(t, NULL);
+	ASSERT_EQUAL_U(EPIPE, param.count);
+	ASSERT_EQUAL(-1, chan_recv(param.ch, &v));
+	ASSERT_EQUAL(EPIPE, errno);
+	chan_destroy(param.ch);
+}
+
+CTEST(chan, threads) {
+	struct chan_param param;
+	pthread_t p[PRODUCERS], c[CONSUMERS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	param.ch = chan_create(sizeof(size_t), 16);
+	ASSERT_NOT_NULL(param.ch);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_create(&c[i], NULL, consumer_thread, &param);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_create(&p[i], NULL, producer_thread, &param);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_join(p[i], NULL);
+	}
+	chan_close(param.ch);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_join(c[i], NULL);
+	}
+	ASSERT_EQUAL_U(PRODUCERS * LOOPS, param.count);
+	ASSERT_EQUAL_U((size_t) PRODUCERS * LOOPS * (LOOPS + 1) / 2, param.sum);
+	chan_destroy(param.ch);
+}
+
+CTEST(chan, select) {
+	chan_t ch1 = chan_create(sizeof(int), 1);
+	chan_t ch2 = chan_create(sizeof(int), 1);
+	int v1 = 1, v2 = 2, r1 = 0, r2 = 0;
+	chan_case_t cases[2];
+
+	ASSERT_NOT_NULL(ch1);
+	ASSERT_NOT_NULL(ch2);
+	cases[0].ch = ch1;
+	cases[0].op = CHAN_RECV;
+	cases[0].data = &r1;
+	cases[1].ch = ch2;
+	cases[1].op = CHAN_RECV;
+	cases[1].data = &r2;
+	ASSERT_EQUAL(-1, chan_select(cases, 2, 0));
+	ASSERT_EQUAL(EAGAIN, errno);
+	ASSERT_EQUAL(-1, chan_timed_select(cases, 2, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+
+	ASSERT_EQUAL(0, chan_send(ch2, &v2));
+	ASSERT_EQUAL(1, chan_select(cases, 2, 1));
+	ASSERT_EQUAL(0, cases[1].err);
+	ASSERT_EQUAL(2, r2);
+
+	/* send case */
+	cases[0].op = CHAN_SEND;
+	cases[0].data = &v1;
+	ASSERT_EQUAL(0, chan_select(cases, 2, 1));
+	ASSERT_EQUAL(0, chan_recv(ch1, &r1));
+	ASSERT_EQUAL(1, r1);
+
+	/* closed channel */
+	chan_close(ch2);
+	ASSERT_EQUAL(0, chan_send(ch1, &v1));
+	ASSERT_EQUAL(0, chan_select(&cases[1], 1, 1));
+	ASSERT_EQUAL(EPIPE, cases[1].err);
+
+	chan_destroy(ch1);
+	chan_destroy(ch2);
+}
+
+CTEST(chan, select_threads) {
+	struct chan_param param;
+	pthread_t p[PRODUCERS], s[CONSUMERS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	param.ch = chan_create(sizeof(size_t), 4);
+	param.ch2 = chan_create(sizeof(size_t), 0);
+	ASSERT_NOT_NULL(param.ch);
+	ASSERT_NOT_NULL(param.ch2);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_create(&s[i], NULL, select_thread, &param);
+	}
+	pthread_create(&p[0], NULL, producer_thread, &param);
+	/* second producer send to unbuffered channel */
+	for (i = 1; i <= LOOPS; i++) {
+		ASSERT_EQUAL(0, chan_send(param.ch2, &i));
+	}
+	pthread_join(p[0], NULL);
+	chan_close(param.ch);
+	chan_close(param.ch2);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_join(s[i], NULL);
+	}
+	ASSERT_EQUAL_U(2 * LOOPS, param.count);
+	ASSERT_EQUAL_U((size_t) 2 * LOOPS * (LOOPS + 1) / 2, param.sum);
+	chan_destroy(param.ch);
+	chan_destroy(param.ch2);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,147 @@
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/compq.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define TASKS 10000
+#define BATCH 16
+
+static intptr_t square_task(void *arg) {
+	intptr_t v = (intptr_t) arg;
+	return v * v;
+}
+
+/* event loop: wait fd readiness and collect completions in batches */
+static size_t compq_loop(compq_t cq, char *done, size_t *errors) {
+	compq_entry_t entries[BATCH];
+	struct pollfd pfd;
+	size_t i, n, count = 0;
+
+	pfd.fd = compq_fd(cq);
+	pfd.events = POLLIN;
+	while (compq_pending(cq) > 0) {
+		if (poll(&pfd, 1, 5000) != 1) {
+			(*errors)++;
+			break;
+		}
+		while ((n = compq_poll(cq, entries, BATCH)) > 0) {
+			for (i = 0; i < n; i++) {
+				if (entries[i].tag >= TASKS || done[entries[i].tag] ||
+						entries[i].result != (intptr_t) (entries[i].tag * entries[i].tag)) {
+					(*errors)++;
+				} else {
+					done[entries[i].tag] = 1;
+				}
+			}
+			count += n;
+		}
+	}
+	return count;
+}
+
+static void compq_run(executor_t ex) {
+	compq_t cq = compq_create(1024);
+	char *done = (char *) calloc(TASKS, 1);
+	size_t i, errors = 0, count = 0;
+	compq_entry_t entries[BATCH];
+
+	ASSERT_NOT_NULL(cq);
+	ASSERT_NOT_NULL(done);
+	ASSERT_NOT_NULL(ex);
+	for (i = 0; i < TASKS; i++) {
+		while (compq_submit(cq, ex, square_task, (void *) (intptr_t) i, i) != 0) {
+			ASSERT_EQUAL(EAGAIN, errno);
+			/* loop offload work and collect completions */
+			count += compq_poll(cq, entries, BATCH);
+			usleep(100);
+		}
+	}
+	/* completions, polled in submit loop, aren't checked */
+	memset(done, 0, TASKS);
+	count += compq_loop(cq, done, &errors);
+	ASSERT_EQUAL_U(0, errors);
+	ASSERT_EQUAL_U(TASKS, count);
+	ASSERT_EQUAL_U(0, compq_pending(cq));
+	ASSERT_EQUAL_U(0, compq_poll(cq, entries, BATCH));
+
+	executor_destroy(ex);
+	compq_destroy(cq);
+	free(done);
+}
+
+CTEST(compq, thpool) {
+	compq_run(executor_thpool(thpool_create(2, 256), 1));
+}
+
+CTEST(compq, lfthpool) {
+	compq_run(executor_lfthpool(lfthpool_create(2, 256), 1));
+}
+
+CTEST(compq, caller_runs) {
+	compq_run(executor_caller_runs(executor_thpool(thpool_create(2, 16), 1)));
+}
+
+CTEST(compq, coalesce) {
+	compq_t cq = compq_create(16);
+	executor_t ex = executor_lfthpool(lfthpool_create(2, 256), 1);
+	compq_entry_t entries[BATCH];
+	struct pollfd pfd;
+	size_t i, n;
+
+	ASSERT_NOT_NULL(cq);
+	ASSERT_NOT_NULL(ex);
+	pfd.fd = compq_fd(cq);
+	pfd.events = POLLIN;
+	ASSERT_EQUAL(0, poll(&pfd, 1, 0));
+
+	executor_pause(ex);
+	for (i = 0; i < 100; i++) {
+		ASSERT_EQUAL(0, compq_submit(cq, ex, square_task, (void *) (intptr_t) i, i));
+	}
+	ASSERT_EQUAL_U(100, compq_pending(cq));
+	executor_resume(ex);
+	executor_wait(ex);
+	ASSERT_EQUAL(1, poll(&pfd, 1, 0));
+#if defined(__linux__)
+	{
+		/* one eventfd write for all completions */
+		uint64_t v = 0;
+		ASSERT_EQUAL((int) sizeof(v), (int) read(pfd.fd, &v, sizeof(v)));
+		ASSERT_EQUAL_U(1, v);
+	}
+#endif
+
+	/* fd is left readable, while completions remain */
+	n = compq_poll(cq, entries, BATCH);
+	ASSERT_EQUAL_U(BATCH, n);
+	ASSERT_EQUAL(1, poll(&pfd, 1, 0));
+	for (i = BATCH; i < 100; i += n) {
+		n = compq_poll(cq, entries, BATCH);
+		ASSERT_TRUE(n > 0);
+	}
+	ASSERT_EQUAL_U(0, compq_pending(cq));
+	ASSERT_EQUAL_U(0, compq_poll(cq, entries, BATCH));
+	ASSERT_EQUAL(0, poll(&pfd, 1, 0));
+
+	executor_destroy(ex);
+	compq_destroy(cq);
+}
+
+CTEST(compq, invalid) {
+	ASSERT_NULL(compq_create(0));
+	ASSERT_EQUAL(EINVAL, errno);
+}
+
+int main(int argc, const char *argv[]) {
+	return ctest_main(argc, argv);
+}
@@ -0,0 +1,147 @@
+/*
+ * Ping-pong through pool: coroutine (co_await pool.schedule()) vs callback style (task resubmit itself)
+ */
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+
+#include <sys/time.h>
+
+#include <threads/thread_pool.hpp>
+
+size_t LOOP_COUNT = 1000000;
+
+int ret = 0;
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+/* fire and forget coroutine */
+struct detached {
+	struct promise_type {
+		detached get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+template <class Pool>
+static detached coro_pingpong(Pool &pool, size_t loop_count, size_t *n) {
+	size_t i;
+	for (i = 0; i < loop_count; i++) {
+		co_await pool.schedule();
+		(*n)++;
+	}
+}
+
+/* callback style: state is passed as task argument, task resubmit itself */
+struct chain {
+	size_t n;
+	size_t loop_count;
+	thpool_t pool;
+	lfthpool_t lfpool;
+};
+
+static void thpool_step(void *p) {
+	chain *c = static_cast<chain *>(p);
+	if (++c->n < c->loop_count) {
+		while (thpool_add_task(c->pool, thpool_step, c) != 0) {
+		}
+	}
+}
+
+static void lfthpool_step(void *p) {
+	chain *c = static_cast<chain *>(p);
+	if (++c->n < c->loop_count) {
+		while (lfthpool_add_task(c->lfpool, lfthpool_step, c) != 0) {
+		}
+	}
+}
+
+static void report(const char *name, uint64_t start, uint64_t end, size_t n, size_t loop_count) {
+	uint64_t duration = end - start;
+	if (duration == 0)
+		duration = 1;
+	printf("%-24s (%f ms, %lu iterations, %llu ns/op, %llu op/s) ",
+		name,
+		(double) duration / 1000,
+		(unsigned long) loop_count,
+		(unsigned long long) duration * 1000 / loop_count,
+		(unsigned long long) 1000000 * loop_count / duration
+	);
+	if (n != loop_count) {
+		ret++;
+		printf("[ERR]: %llu != %llu\n", (unsigned long long) n, (unsigned long long) loop_count);
+	} else {
+		printf("[OK]\n");
+	}
+}
+
+template <class Pool>
+static void bench_coro(const char *name, size_t workers, size_t loop_count) {
+	Pool pool(workers, 1024);
+	uint64_t start, end;
+	size_t n = 0;
+
+	start = getCurrentTime();
+	coro_pingpong(pool, loop_count, &n);
+	/* coroutine is done, when pool is idle */
+	pool.wait();
+	end = getCurrentTime();
+	report(name, start, end, n, loop_count);
+}
+
+static void bench_thpool_callback(size_t workers, size_t loop_count) {
+	chain c = { 0, loop_count, thpool_create(workers, 1024), NULL };
+	uint64_t start, end;
+
+	start = getCurrentTime();
+	thpool_add_task(c.pool, thpool_step, &c);
+	thpool_wait(c.pool);
+	end = getCurrentTime();
+	thpool_destroy(c.pool);
+	report("thpool callback", start, end, c.n, loop_count);
+}
+
+static void bench_lfthpool_callback(size_t workers, size_t loop_count) {
+	chain c = { 0, loop_count, NULL, lfthpool_create(workers, 1024) };
+	uint64_t start, end;
+
+	start = getCurrentTime();
+	lfthpool_add_task(c.lfpool, lfthpool_step, &c);
+	lfthpool_wait(c.lfpool);
+	end = getCurrentTime();
+	lfthpool_destroy(c.lfpool);
+	report("lfthpool callback", start, end, c.n, loop_count);
+}
+
+int main() {
+	char *COUNT_STR = getenv("LOOP_COUNT");
+	size_t workers;
+	if (COUNT_STR) {
+		unsigned long c = strtoul(COUNT_STR, NULL, 10);
+		if (c > 0) {
+			LOOP_COUNT = c;
+		}
+	}
+	for (workers = 1; workers <= 4; workers *= 4) {
+		printf("%lu workers\n", (unsigned long) workers);
+		bench_thpool_callback(workers, LOOP_COUNT);
+		bench_coro<threads::thread_pool>("thpool coroutine", workers, LOOP_COUNT);
+		bench_lfthpool_callback(workers, LOOP_COUNT);
+		bench_coro<threads::lf_thread_pool>("lfthpool coroutine", workers, LOOP_COUNT);
+	}
+	return ret;
+}
@@ -0,0 +1,193 @@
+#include <atomic>
+#include <coroutine>
+#include <cstdlib>
+#include <exception>
+#include <new>
+#include <system_error>
+
+#include <threads/thread_pool.hpp>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define HOPS 1000
+#define TASKS 100
+
+/* count operator new calls */
+static std::atomic<size_t> allocs(0);
+
+void *operator new(std::size_t size) {
+	void *p;
+	allocs.fetch_add(1, std::memory_order_relaxed);
+	if ((p = std::malloc(size ? size : 1)) == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+/* fire and forget coroutine */
+struct detached {
+	struct promise_type {
+		detached get_return_object() noexcept { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() noexcept {}
+		void unhandled_exception() noexcept { std::terminate(); }
+	};
+};
+
+struct result {
+	std::atomic<int> done{0};
+	size_t errors = 0;
+	size_t allocs = 0;
+	int value = 0;
+};
+
+static void wait_done(result &r) {
+	int n;
+	for (n = 0; n < 10000 && r.done.load() == 0; n++)
+		usleep(1000);
+}
+
+template <class Pool>
+static detached hops(Pool &pool, result &r) {
+	size_t i, before;
+	co_await pool.schedule();
+	before = allocs.load();
+	for (i = 0; i < HOPS; i++) {
+		co_await pool.schedule();
+		if (pool_current_worker() == nullptr)
+			r.errors++;
+	}
+	r.allocs = allocs.load() - before;
+	r.done = 1;
+}
+
+CTEST(coro, schedule) {
+	threads::thread_pool pool(2, 1024);
+	threads::lf_thread_pool lfpool(2, 1024);
+	result r1, r2;
+
+	hops(pool, r1);
+	hops(lfpool, r2);
+	wait_done(r1);
+	wait_done(r2);
+	ASSERT_EQUAL(1, r1.done.load());
+	ASSERT_EQUAL_U(0, r1.errors);
+	/* resume don't allocate */
+	ASSERT_EQUAL_U(0, r1.allocs);
+	ASSERT_EQUAL(1, r2.done.load());
+	ASSERT_EQUAL_U(0, r2.errors);
+	ASSERT_EQUAL_U(0, r2.allocs);
+}
+
+static detached await_future(threads::thread_pool &pool, result &r) {
+	threads::future<int> f = pool.submit([] { usleep(10000); return 42; });
+	r.value = co_await f;
+	/* resumed in worker, which complete task */
+	if (pool_current_worker() == nullptr)
+		r.errors++;
+	r.value += co_await pool.submit([] { return 1; });
+	try {
+		co_await pool.submit([]() -> int { throw std::runtime_error("error"); });
+		r.errors++;
+	} catch (const std::runtime_error &) {
+	}
+	r.done = 1;
+}
+
+CTEST(coro, future) {
+	threads::thread_pool pool(2, 1024);
+	result r;
+
+	await_future(pool, r);
+	wait_done(r);
+	ASSERT_EQUAL(1, r.done.load());
+	ASSERT_EQUAL(43, r.value);
+	ASSERT_EQUAL_U(0, r.errors);
+}
+
+template <class Pool>
+static detached await_idle(Pool &pool, std::atomic<int> &count, result &r) {
+	int i;
+	for (i = 0; i < TASKS; i++) {
+		pool.post([&count] { usleep(100); count++; });
+	}
+	co_await pool.wait_async();
+	r.value = count.load();
+	r.done = 1;
+}
+
+CTEST(coro, wait_async) {
+	threads::thread_pool pool(2, 1024);
+	threads::lf_thread_pool lfpool(2, 1024);
+	std::atomic<int> count1(0), count2(0);
+	result r1, r2;
+
+	await_idle(pool, count1, r1);
+	await_idle(lfpool, count2, r2);
+	wait_done(r1);
+	wait_done(r2);
+	ASSERT_EQUAL(TASKS, r1.value);
+	ASSERT_EQUAL(TASKS, r2.value);
+
+	/* idle pool */
+	r1.done = 0;
+	await_idle(pool, count1, r1);
+	wait_done(r1);
+	ASSERT_EQUAL(TASKS * 2, r1.value);
+}
+
+static detached await_sem(lusem_t &sem, result &r) {
+	co_await threads::wait(sem);
+	r.value++;
+	co_await threads::wait(sem);
+	r.value++;
+	r.done = 1;
+}
+
+static detached await_sem_unfair(lusem_t &sem, result &r) {
+	try {
+		co_await threads::wait(sem);
+	} catch (const std::system_error &e) {
+		r.value = e.code().value();
+	}
+	r.done = 1;
+}
+
+CTEST(coro, lusem) {
+	lusem_t sem;
+	result r;
+
+	ASSERT_EQUAL(0, lusem_init_fair(&sem, 1, 0));
+	await_sem(sem, r);
+	/* first permit is taken without suspend */
+	ASSERT_EQUAL(1, r.value);
+	ASSERT_EQUAL(0, r.done.load());
+	/* resumed in signaling thread */
+	lusem_signal(&sem);
+	ASSERT_EQUAL(2, r.value);
+	ASSERT_EQUAL(1, r.done.load());
+	lusem_destroy(&sem);
+
+	r.done = 0;
+	r.value = 0;
+	ASSERT_EQUAL(0, lusem_init(&sem, 0, 0));
+	await_sem_unfair(sem, r);
+	ASSERT_EQUAL(1, r.done.load());
+	ASSERT_EQUAL(EINVAL, r.value);
+	lusem_destroy(&sem);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,169 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/disruptor.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define PRODUCERS 2
+#define LOOPS 50000
+
+struct entry {
+	uint64_t value;
+	uint64_t a; /* written by consumer A */
+	uint64_t b; /* written by consumer B */
+};
+
+struct consumer_param {
+	disruptor_t d;
+	int id;
+	int stage; /* 0 - A, 1 - B, 2 - C (depend on A and B) */
+	uint64_t sum;
+	uint64_t count;
+	uint64_t batches;
+	uint64_t errors;
+};
+
+static void *consumer_thread(void *p) {
+	struct consumer_param *param = (struct consumer_param *) p;
+	struct entry *e;
+	uint64_t seq;
+	size_t i, n;
+	while ((n = disruptor_consume_wait(param->d, param->id, &seq)) > 0) {
+		for (i = 0; i < n; i++) {
+			e = (struct entry *) disruptor_entry(param->d, seq + i);
+			switch (param->stage) {
+			case 0:
+				e->a = e->value * 2;
+				break;
+			case 1:
+				e->b = e->value * 3;
+				break;
+			default:
+				/* gated by A and B */
+				if (e->a != e->value * 2 || e->b != e->value * 3)
+					param->errors++;
+			}
+			param->sum += e->value;
+		}
+		param->count += n;
+		param->batches++;
+		disruptor_release(param->d, param->id, n);
+	}
+	return NULL;
+}
+
+static void *producer_thread(void *p) {
+	disruptor_t d = (disruptor_t) p;
+	struct entry *e;
+	uint64_t seq, i;
+	for (i = 1; i <= LOOPS; i++) {
+		seq = disruptor_claim(d, 1);
+		e = (struct entry *) disruptor_entry(d, seq);
+		e->value = i;
+		disruptor_publish(d, seq, 1);
+	}
+	return NULL;
+}
+
+static void run(int flags, size_t producers) {
+	struct consumer_param c[3];
+	pthread_t t[3], p[PRODUCERS];
+	int deps[2];
+	disruptor_t d = disruptor_create(sizeof(struct entry), 64, 3, flags);
+	size_t i;
+
+	ASSERT_NOT_NULL(d);
+	memset(c, 0, sizeof(c));
+	for (i = 0; i < 3; i++) {
+		c[i].d = d;
+		c[i].stage = (int) i;
+	}
+	c[0].id = disruptor_consumer_add(d, NULL, 0);
+	c[1].id = disruptor_consumer_add(d, NULL, 0);
+	deps[0] = c[0].id;
+	deps[1] = c[1].id;
+	c[2].id = disruptor_consumer_add(d, deps, 2);
+	ASSERT_EQUAL(2, c[2].id);
+	ASSERT_EQUAL(-1, disruptor_consumer_add(d, NULL, 0));
+	ASSERT_EQUAL(ENOSPC, errno);
+
+	for (i = 0; i < 3; i++) {
+		pthread_create(&t[i], NULL, consumer_thread, &c[i]);
+	}
+	for (i = 0; i < producers; i++) {
+		pthread_create(&p[i], NULL, producer_thread, d);
+	}
+	for (i = 0; i < producers; i++) {
+		pthread_join(p[i], NULL);
+	}
+	disruptor_close(d);
+	for (i = 0; i < 3; i++) {
+		pthread_join(t[i], NULL);
+		ASSERT_EQUAL_U(producers * LOOPS, c[i].count);
+		ASSERT_EQUAL_U((uint64_t) producers * LOOPS * (LOOPS + 1) / 2, c[i].sum);
+		ASSERT_EQUAL_U(0, c[i].errors);
+	}
+	disruptor_destroy(d);
+}
+
+CTEST(disruptor, basic) {
+	disruptor_t d = disruptor_create(sizeof(uint64_t), 3, 1, 0);
+	uint64_t seq, i;
+	int c;
+
+	ASSERT_NOT_NULL(d);
+	ASSERT_EQUAL_U(4, disruptor_size(d));
+	c = disruptor_consumer_add(d, NULL, 0);
+	ASSERT_EQUAL(0, c);
+	ASSERT_EQUAL_U(0, disruptor_consume_try(d, c, &seq));
+	ASSERT_EQUAL_U(0, disruptor_consume_timed_wait(d, c, &seq, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+
+	ASSERT_EQUAL(0, disruptor_try_claim(d, 4, &seq));
+	ASSERT_EQUAL_U(0, seq);
+	for (i = 0; i < 4; i++) {
+		*(uint64_t *) disruptor_entry(d, seq + i) = i;
+	}
+	/* ring is full */
+	ASSERT_EQUAL(-1, disruptor_try_claim(d, 1, &seq));
+	ASSERT_EQUAL(EAGAIN, errno);
+	disruptor_publish(d, 0, 4);
+
+	/* batch read */
+	ASSERT_EQUAL_U(4, disruptor_consume_wait(d, c, &seq));
+	ASSERT_EQUAL_U(0, seq);
+	ASSERT_EQUAL_U(3, *(uint64_t *) disruptor_entry(d, seq + 3));
+	disruptor_release(d, c, 2);
+	ASSERT_EQUAL(0, disruptor_try_claim(d, 2, &seq));
+	ASSERT_EQUAL_U(4, seq);
+	disruptor_publish(d, seq, 2);
+	ASSERT_EQUAL_U(4, disruptor_consume_try(d, c, &seq));
+	ASSERT_EQUAL_U(2, seq);
+	disruptor_release(d, c, 4);
+
+	disruptor_close(d);
+	ASSERT_EQUAL_U(0, disruptor_consume_wait(d, c, &seq));
+	ASSERT_EQUAL(EPIPE, errno);
+	disruptor_destroy(d);
+}
+
+CTEST(disruptor, single_writer) {
+	run(0, 1);
+}
+
+CTEST(disruptor, multi_writer) {
+	run(DISRUPTOR_MULTI_WRITER, PRODUCERS);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,214 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/ebr.h>
+#include <threads/event.h>
+#include <threads/lfthpool.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define READERS 3
+#define LOOPS 20000
+#define TASKS 2000
+
+#define NODE_LIVE 0x5AFE
+#define NODE_DEAD 0xDEAD
+
+struct node {
+	size_t magic;
+	size_t value;
+};
+
+static size_t freed;
+
+/* nodes memory is freed at test end, so use after reclaim is detected by magic */
+static void node_free(void *p) {
+	struct node *n = (struct node *) p;
+	n->magic = NODE_DEAD;
+	__atomic_add_fetch(&freed, 1, __ATOMIC_RELAXED);
+}
+
+struct shared {
+	ebr_t d;
+	struct node *head;
+	struct node *nodes;
+	int stop;
+	size_t errors;
+	event_t entered;
+	event_t leave;
+};
+
+static void shared_init(struct shared *s, ebr_t d) {
+	memset(s, 0, sizeof(struct shared));
+	s->d = d;
+	s->nodes = (struct node *) calloc(LOOPS + 1, sizeof(struct node));
+	s->nodes[0].magic = NODE_LIVE;
+	s->head = &s->nodes[0];
+	freed = 0;
+}
+
+/* replace head and retire old node */
+static void shared_update(struct shared *s, size_t i) {
+	struct node *n = &s->nodes[i], *old;
+	n->magic = NODE_LIVE;
+	n->value = i;
+	old = __atomic_exchange_n(&s->head, n, __ATOMIC_ACQ_REL);
+	ebr_retire(s->d, old, node_free);
+}
+
+static void shared_read(struct shared *s) {
+	struct node *n = __atomic_load_n(&s->head, __ATOMIC_ACQUIRE);
+	if (__atomic_load_n(&n->magic, __ATOMIC_RELAXED) != NODE_LIVE)
+		__atomic_add_fetch(&s->errors, 1, __ATOMIC_RELAXED);
+}
+
+static void *reader_thread(void *p) {
+	struct shared *s = (struct shared *) p;
+	int i;
+	while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+		ebr_enter(s->d);
+		for (i = 0; i < 16; i++) {
+			shared_read(s);
+		}
+		ebr_exit(s->d);
+	}
+	return NULL;
+}
+
+static void *stalled_reader_thread(void *p) {
+	struct shared *s = (struct shared *) p;
+	ebr_enter(s->d);
+	event_set(&s->entered);
+	event_wait(&s->leave);
+	shared_read(s);
+	ebr_exit(s->d);
+	return NULL;
+}
+
+CTEST(ebr, single) {
+	struct shared s;
+	ebr_t d = ebr_create();
+	size_t i;
+
+	ASSERT_NOT_NULL(d);
+	shared_init(&s, d);
+	for (i = 1; i <= 10; i++) {
+		shared_update(&s, i);
+	}
+	/* no active readers */
+	ASSERT_EQUAL_U(0, ebr_reclaim(d));
+	ASSERT_EQUAL_U(10, freed);
+
+	/* retire in critical section, reclaimed after exit */
+	ebr_enter(d);
+	shared_update(&s, 11);
+	ASSERT_EQUAL_U(1, ebr_reclaim(d));
+	ebr_exit(d);
+	ASSERT_EQUAL_U(0, ebr_reclaim(d));
+	ASSERT_EQUAL_U(11, freed);
+
+	ebr_destroy(d);
+	free(s.nodes);
+}
+
+CTEST(ebr, stalled_reader) {
+	struct shared s;
+	ebr_t d = ebr_create();
+	pthread_t t;
+	size_t i;
+
+	ASSERT_NOT_NULL(d);
+	shared_init(&s, d);
+	event_init(&s.entered, 1, 0);
+	event_init(&s.leave, 1, 0);
+	pthread_create(&t, NULL, stalled_reader_thread, &s);
+	event_wait(&s.entered);
+	for (i = 1; i <= EBR_BATCH * 4; i++) {
+		shared_update(&s, i);
+	}
+	/* old head can be read by stalled reader */
+	ASSERT_NOT_EQUAL_U(0, ebr_reclaim(d));
+	ASSERT_EQUAL_U(NODE_LIVE, s.nodes[0].magic);
+	event_set(&s.leave);
+	pthread_join(t, NULL);
+	ASSERT_EQUAL_U(0, s.errors);
+	ASSERT_EQUAL_U(0, ebr_reclaim(d));
+	ASSERT_EQUAL_U(EBR_BATCH * 4, freed);
+
+	event_destroy(&s.entered);
+	event_destroy(&s.leave);
+	ebr_destroy(d);
+	free(s.nodes);
+}
+
+CTEST(ebr, readers) {
+	struct shared s;
+	ebr_t d = ebr_create();
+	pthread_t t[READERS];
+	size_t i;
+
+	ASSERT_NOT_NULL(d);
+	shared_init(&s, d);
+	for (i = 0; i < READERS; i++) {
+		pthread_create(&t[i], NULL, reader_thread, &s);
+	}
+	for (i = 1; i <= LOOPS; i++) {
+		shared_update(&s, i);
+	}
+	__atomic_store_n(&s.stop, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < READERS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, s.errors);
+	ASSERT_EQUAL_U(0, ebr_reclaim(d));
+	ASSERT_EQUAL_U(LOOPS, freed);
+
+	ebr_destroy(d);
+	free(s.nodes);
+}
+
+static void read_task(void *p) {
+	struct shared *s = (struct shared *) p;
+	int i;
+	/* pool worker is online in default domain, no critical section */
+	for (i = 0; i < 64; i++) {
+		shared_read(s);
+	}
+}
+
+CTEST(ebr, pool_quiescent) {
+	struct shared s;
+	lfthpool_t pool = lfthpool_create(READERS, TASKS);
+	size_t i;
+	int n;
+
+	ASSERT_NOT_NULL(pool);
+	shared_init(&s, ebr_default());
+	for (i = 1; i <= TASKS; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, read_task, &s));
+		shared_update(&s, i);
+	}
+	lfthpool_wait(pool);
+	ASSERT_EQUAL_U(0, s.errors);
+	/* idle workers go offline before sleep */
+	for (n = 0; n < 1000 && ebr_reclaim(ebr_default()) != 0; n++) {
+		usleep(1000);
+	}
+	ASSERT_EQUAL_U(0, ebr_reclaim(ebr_default()));
+	ASSERT_EQUAL_U(TASKS, freed);
+
+	lfthpool_destroy(pool);
+	free(s.nodes);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
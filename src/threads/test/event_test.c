@@ -0,0 +1,203 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/event.h>
+#include <threads/latch.h>
+#include <threads/waitgroup.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define THREADS 4
+#define LOOPS 10000
+
+struct event_param {
+	event_t e;
+	latch_t l;
+	waitgroup_t wg;
+	size_t n;
+};
+
+static void *event_auto_thread(void *p) {
+	struct event_param *param = (struct event_param *) p;
+	event_wait(&param->e);
+	__atomic_add_fetch(&param->n, 1, __ATOMIC_RELAXED);
+	return NULL;
+}
+
+static void *latch_thread(void *p) {
+	struct event_param *param = (struct event_param *) p;
+	__atomic_add_fetch(&param->n, 1, __ATOMIC_RELAXED);
+	latch_arrive_and_wait(&param->l);
+	/* all threads are arrived */
+	if (__atomic_load_n(&param->n, __ATOMIC_RELAXED) != THREADS)
+		abort();
+	return NULL;
+}
+
+static void *waitgroup_thread(void *p) {
+	struct event_param *param = (struct event_param *) p;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		__atomic_add_fetch(&param->n, 1, __ATOMIC_RELAXED);
+	}
+	waitgroup_done(&param->wg);
+	return NULL;
+}
+
+CTEST(event, auto_reset) {
+	event_t e;
+	event_init(&e, 0, 1);
+	ASSERT_EQUAL(0, event_try_wait(&e));
+	ASSERT_EQUAL(-1, event_try_wait(&e));
+	event_set(&e);
+	event_set(&e);
+	ASSERT_EQUAL(0, event_timed_wait(&e, 1000));
+	ASSERT_EQUAL(-1, event_timed_wait(&e, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	event_set(&e);
+	event_reset(&e);
+	ASSERT_EQUAL(-1, event_try_wait(&e));
+	event_destroy(&e);
+}
+
+CTEST(event, manual_reset) {
+	event_t e;
+	event_init(&e, 1, 0);
+	ASSERT_EQUAL(-1, event_try_wait(&e));
+	ASSERT_EQUAL(-1, event_timed_wait(&e, 1000));
+	event_set(&e);
+	ASSERT_EQUAL(0, event_try_wait(&e));
+	ASSERT_EQUAL(0, event_timed_wait(&e, 1000));
+	event_wait(&e);
+	event_reset(&e);
+	ASSERT_EQUAL(-1, event_try_wait(&e));
+	event_destroy(&e);
+}
+
+CTEST(event, auto_reset_threads) {
+	struct event_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	event_init(&param.e, 0, 0);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, event_auto_thread, &param);
+	}
+	/* each set release one waiter */
+	for (i = 0; i < THREADS; i++) {
+		while (__atomic_load_n(&param.n, __ATOMIC_RELAXED) != i)
+			usleep(100);
+		event_set(&param.e);
+		while (__atomic_load_n(&param.n, __ATOMIC_RELAXED) == i)
+			usleep(100);
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(THREADS, param.n);
+	ASSERT_EQUAL(-1, event_try_wait(&param.e));
+	event_destroy(&param.e);
+}
+
+CTEST(event, manual_reset_threads) {
+	struct event_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	event_init(&param.e, 1, 0);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, event_auto_thread, &param);
+	}
+	usleep(1000);
+	ASSERT_EQUAL_U(0, __atomic_load_n(&param.n, __ATOMIC_RELAXED));
+	/* one set release all waiters */
+	event_set(&param.e);
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(THREADS, param.n);
+	event_destroy(&param.e);
+}
+
+CTEST(latch, basic) {
+	latch_t l;
+	latch_init(&l, 2);
+	ASSERT_EQUAL(-1, latch_try_wait(&l));
+	latch_count_down(&l, 1);
+	ASSERT_EQUAL(-1, latch_timed_wait(&l, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	latch_count_down(&l, 1);
+	ASSERT_EQUAL(0, latch_try_wait(&l));
+	ASSERT_EQUAL(0, latch_timed_wait(&l, 1000));
+	latch_wait(&l);
+	latch_destroy(&l);
+}
+
+CTEST(latch, threads) {
+	struct event_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	latch_init(&param.l, THREADS);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, latch_thread, &param);
+	}
+	latch_wait(&param.l);
+	ASSERT_EQUAL_U(THREADS, param.n);
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	latch_destroy(&param.l);
+}
+
+CTEST(waitgroup, basic) {
+	waitgroup_t wg;
+	waitgroup_init(&wg);
+	ASSERT_EQUAL(0, waitgroup_try_wait(&wg));
+	waitgroup_add(&wg, 2);
+	ASSERT_EQUAL(-1, waitgroup_try_wait(&wg));
+	waitgroup_done(&wg);
+	ASSERT_EQUAL(-1, waitgroup_timed_wait(&wg, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	waitgroup_done(&wg);
+	ASSERT_EQUAL(0, waitgroup_timed_wait(&wg, 1000));
+	ASSERT_EQUAL_U(0, wg.state);
+	waitgroup_destroy(&wg);
+}
+
+CTEST(waitgroup, threads) {
+	struct event_param param;
+	pthread_t t[THREADS];
+	size_t i, round;
+
+	memset(&param, 0, sizeof(param));
+	waitgroup_init(&param.wg);
+	/* wait group is reusable */
+	for (round = 1; round <= 3; round++) {
+		waitgroup_add(&param.wg, THREADS);
+		for (i = 0; i < THREADS; i++) {
+			pthread_create(&t[i], NULL, waitgroup_thread, &param);
+		}
+		waitgroup_wait(&param.wg);
+		ASSERT_EQUAL_U(round * THREADS * LOOPS, __atomic_load_n(&param.n, __ATOMIC_RELAXED));
+		for (i = 0; i < THREADS; i++) {
+			pthread_join(t[i], NULL);
+		}
+	}
+	waitgroup_destroy(&param.wg);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
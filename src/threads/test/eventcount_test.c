@@ -0,0 +1,125 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/eventcount.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define PRODUCERS 2
+#define CONSUMERS 4
+#define LOOPS 20000
+
+/* lock-free counter of available items (as queue) */
+struct ec_param {
+	eventcount_t ec;
+	size_t items;
+	size_t consumed;
+	int shutdown;
+};
+
+static int try_pop(struct ec_param *param) {
+	size_t n = __atomic_load_n(&param->items, __ATOMIC_ACQUIRE);
+	while (n > 0) {
+		if (__atomic_compare_exchange_n(&param->items, &n, n - 1, 1, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+			return 0;
+	}
+	return -1;
+}
+
+static void *producer_thread(void *p) {
+	struct ec_param *param = (struct ec_param *) p;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		__atomic_add_fetch(&param->items, 1, __ATOMIC_RELEASE);
+		eventcount_notify(&param->ec);
+	}
+	return NULL;
+}
+
+static void *consumer_thread(void *p) {
+	struct ec_param *param = (struct ec_param *) p;
+	uint32_t key;
+	while (1) {
+		if (try_pop(param) == 0) {
+			__atomic_add_fetch(&param->consumed, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		key = eventcount_prepare_wait(&param->ec);
+		if (try_pop(param) == 0) {
+			eventcount_cancel_wait(&param->ec);
+			__atomic_add_fetch(&param->consumed, 1, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_load_n(&param->shutdown, __ATOMIC_ACQUIRE)) {
+			eventcount_cancel_wait(&param->ec);
+			break;
+		}
+		eventcount_commit_wait(&param->ec, key);
+	}
+	return NULL;
+}
+
+CTEST(eventcount, timeout) {
+	eventcount_t ec;
+	uint32_t key;
+	eventcount_init(&ec);
+	/* nobody wait */
+	eventcount_notify(&ec);
+	ASSERT_EQUAL_U(0, ec.epoch);
+
+	key = eventcount_prepare_wait(&ec);
+	ASSERT_EQUAL_U(1, ec.waiters);
+	ASSERT_EQUAL(-1, eventcount_commit_timed_wait(&ec, key, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	ASSERT_EQUAL_U(0, ec.waiters);
+
+	/* notify between prepare and commit is not missed */
+	key = eventcount_prepare_wait(&ec);
+	eventcount_notify(&ec);
+	ASSERT_EQUAL(0, eventcount_commit_timed_wait(&ec, key, 1000000));
+	ASSERT_EQUAL_U(0, ec.waiters);
+
+	key = eventcount_prepare_wait(&ec);
+	eventcount_cancel_wait(&ec);
+	ASSERT_EQUAL_U(0, ec.waiters);
+	eventcount_destroy(&ec);
+}
+
+CTEST(eventcount, threads) {
+	struct ec_param param;
+	pthread_t p[PRODUCERS], c[CONSUMERS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	eventcount_init(&param.ec);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_create(&c[i], NULL, consumer_thread, &param);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_create(&p[i], NULL, producer_thread, &param);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_join(p[i], NULL);
+	}
+	__atomic_store_n(&param.shutdown, 1, __ATOMIC_RELEASE);
+	eventcount_notify_all(&param.ec);
+	for (i = 0; i < CONSUMERS; i++) {
+		pthread_join(c[i], NULL);
+	}
+	ASSERT_EQUAL_U(PRODUCERS * LOOPS, param.consumed);
+	ASSERT_EQUAL_U(0, param.items);
+	ASSERT_EQUAL_U(0, param.ec.waiters);
+	eventcount_destroy(&param.ec);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,175 @@
+/*
+ * Run same workload against each executor (thpool, lfthpool, inline, caller-runs)
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <threads/executor.h>
+
+#include <pthread.h>
+#if NO_PTHREAD_BARRIER
+#include "pthread_barrier.h"
+#endif
+
+size_t LOOP_COUNT = 1000000;
+size_t WORKERS = 4;
+size_t QUEUE_SIZE = 1024;
+
+int ret = 0;
+
+struct task_param {
+	size_t n;
+	size_t loop_count;
+	size_t work; /* task spin iterations */
+	executor_t ex;
+	pthread_barrier_t start_barrier;
+};
+
+static void task(void *arg) {
+	struct task_param *param = (struct task_param *) arg;
+	volatile size_t i;
+	for (i = 0; i < param->work; i++) {
+	}
+	__atomic_add_fetch(&param->n, 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+static void *add_task_thread(void *p){
+	size_t i;
+	struct task_param *param = (struct task_param *) p;
+	pthread_barrier_wait(&param->start_barrier);
+	for (i = 0; i < param->loop_count; i++) {
+		while (executor_submit(param->ex, task, param) != 0) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static executor_t executor_new(const char *name) {
+	if (strcmp(name, "thpool") == 0)
+		return executor_thpool(thpool_create(WORKERS, QUEUE_SIZE), 1);
+	if (strcmp(name, "lfthpool") == 0)
+		return executor_lfthpool(lfthpool_create(WORKERS, QUEUE_SIZE), 1);
+	if (strcmp(name, "inline") == 0)
+		return executor_inline();
+	if (strcmp(name, "caller_runs") == 0)
+		return executor_caller_runs(executor_thpool(thpool_create(WORKERS, QUEUE_SIZE), 1));
+	return NULL;
+}
+
+static void bench(const char *name, size_t writers, size_t work, size_t loop_count) {
+	size_t i;
+	uint64_t start, end, duration;
+	struct task_param param;
+	executor_stats_t stats;
+	int perr;
+	pthread_t *t_handles;
+
+	param.n = 0;
+	param.loop_count = loop_count;
+	param.work = work;
+	if ((param.ex = executor_new(name)) == NULL) {
+		fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	pthread_barrier_init(&param.start_barrier, NULL, (unsigned int) writers + 1);
+
+	t_handles = (pthread_t *) malloc(writers * sizeof(pthread_t));
+	for (i = 0; i < writers; i++) {
+		perr = pthread_create(&t_handles[i], NULL, add_task_thread, &param);
+		if (perr) {
+			fprintf(stderr, "%s\n", strerror(perr));
+			exit(1);
+		}
+	}
+
+	pthread_barrier_wait(&param.start_barrier);
+	start = getCurrentTime();
+
+	for (i = 0; i < writers; i++) {
+		pthread_join(t_handles[i], NULL);
+	}
+
+	executor_wait(param.ex);
+
+	end = getCurrentTime();
+
+	executor_stats(param.ex, &stats);
+	executor_destroy(param.ex);
+	pthread_barrier_destroy(&param.start_barrier);
+	free(t_handles);
+	duration = end - start;
+	if (duration == 0)
+		duration = 1;
+	printf("%-12s %llu workers, %llu writers, work %llu (%f ms, %lu iterations, %llu ns/op, %llu op/s, %llu caller runs) ",
+		name,
+		(unsigned long long) stats.workers, (unsigned long long) writers, (unsigned long long) work,
+		(double) duration / 1000,
+		(unsigned long) loop_count,
+		(unsigned long long) duration * 1000 / (loop_count * writers),
+		(unsigned long long) 1000000 * loop_count * writers / duration,
+		(unsigned long long) stats.caller_runs
+	);
+	if (param.n != loop_count * writers) {
+		ret++;
+		printf("[ERR]: %llu != %llu\n", (unsigned long long) param.n, (unsigned long long) loop_count * writers);
+	} else {
+		printf("[OK]\n");
+	}
+}
+
+static size_t env_size(const char *name, size_t def) {
+	char *s = getenv(name);
+	unsigned long c;
+	if (s) {
+		c = strtoul(s, NULL, 10);
+		if (c > 0)
+			return (size_t) c;
+	}
+	return def;
+}
+
+int main(int argc, char *argv[]) {
+	const char *executors[] = { "thpool", "lfthpool", "inline", "caller_runs" };
+	size_t writers[] = { 1, 4 };
+	size_t works[] = { 0, 1000 };
+	size_t e, w, k;
+	int i;
+
+	LOOP_COUNT = env_size("LOOP_COUNT", LOOP_COUNT);
+	WORKERS = env_size("WORKERS", WORKERS);
+	QUEUE_SIZE = env_size("QUEUE_SIZE", QUEUE_SIZE);
+
+	for (k = 0; k < sizeof(works) / sizeof(works[0]); k++) {
+		for (w = 0; w < sizeof(writers) / sizeof(writers[0]); w++) {
+			if (argc > 1) {
+				/* executors from command line */
+				for (i = 1; i < argc; i++) {
+					bench(argv[i], writers[w], works[k], LOOP_COUNT);
+				}
+			} else {
+				for (e = 0; e < sizeof(executors) / sizeof(executors[0]); e++) {
+					bench(executors[e], writers[w], works[k], LOOP_COUNT);
+				}
+			}
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,174 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/executor.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define TASKS 10000
+#define BATCH 16
+
+static void count_task(void *p) {
+	__atomic_add_fetch((size_t *) p, 1, __ATOMIC_RELAXED);
+}
+
+static void executor_run(executor_t ex, size_t *count) {
+	executor_task_t batch[BATCH];
+	size_t i, n, m;
+
+	for (i = 0; i < BATCH; i++) {
+		batch[i].function = count_task;
+		batch[i].arg = count;
+	}
+	for (i = 0; i < TASKS; i++) {
+		while (executor_submit(ex, count_task, count) != 0) {
+			ASSERT_EQUAL(EAGAIN, errno);
+			usleep(100);
+		}
+	}
+	for (i = 0; i < TASKS; i += n) {
+		/* tasks are same, so batch is resubmitted from start */
+		m = TASKS - i < BATCH ? TASKS - i : BATCH;
+		n = executor_submit_batch(ex, batch, m);
+		if (n < m) {
+			ASSERT_EQUAL(EAGAIN, errno);
+			usleep(100);
+		}
+	}
+	executor_wait(ex);
+}
+
+CTEST(executor, thpool) {
+	executor_t ex = executor_thpool(thpool_create(2, 1024), 1);
+	executor_stats_t stats;
+	size_t count = 0;
+
+	ASSERT_NOT_NULL(ex);
+	ASSERT_STR("thpool", executor_name(ex));
+	executor_run(ex, &count);
+	ASSERT_EQUAL_U(TASKS * 2, count);
+	executor_stats(ex, &stats);
+	ASSERT_EQUAL_U(2, stats.workers);
+	ASSERT_EQUAL_U(0, stats.total);
+	ASSERT_EQUAL_U(TASKS * 2, stats.submitted);
+	ASSERT_EQUAL_U(0, stats.caller_runs);
+	executor_destroy(ex);
+}
+
+CTEST(executor, lfthpool) {
+	lfthpool_t pool = lfthpool_create(2, 1024);
+	executor_t ex = executor_lfthpool(pool, 0);
+	executor_stats_t stats;
+	size_t count = 0;
+
+	ASSERT_NOT_NULL(ex);
+	ASSERT_STR("lfthpool", executor_name(ex));
+	executor_run(ex, &count);
+	ASSERT_EQUAL_U(TASKS * 2, count);
+	executor_stats(ex, &stats);
+	ASSERT_EQUAL_U(2, stats.workers);
+	ASSERT_EQUAL_U(TASKS * 2, stats.submitted);
+	executor_destroy(ex);
+	/* pool is not owned */
+	ASSERT_EQUAL(0, lfthpool_add_task(pool, count_task, &count));
+	lfthpool_wait(pool);
+	lfthpool_destroy(pool);
+	ASSERT_EQUAL_U(TASKS * 2 + 1, count);
+}
+
+CTEST(executor, inline) {
+	executor_t ex = executor_inline();
+	executor_stats_t stats;
+	size_t count = 0;
+
+	ASSERT_NOT_NULL(ex);
+	ASSERT_EQUAL(0, executor_submit(ex, count_task, &count));
+	/* already done */
+	ASSERT_EQUAL_U(1, count);
+	executor_run(ex, &count);
+	ASSERT_EQUAL_U(TASKS * 2 + 1, count);
+	executor_stats(ex, &stats);
+	ASSERT_EQUAL_U(0, stats.workers);
+	ASSERT_EQUAL_U(TASKS * 2 + 1, stats.submitted);
+	ASSERT_EQUAL_U(TASKS * 2 + 1, stats.caller_runs);
+	executor_destroy(ex);
+}
+
+CTEST(executor, caller_runs) {
+	executor_t ex = executor_caller_runs(executor_thpool(thpool_create(1, 1), 1));
+	executor_stats_t stats;
+	size_t i, count = 0;
+
+	ASSERT_NOT_NULL(ex);
+	ASSERT_STR("caller_runs", executor_name(ex));
+	/* queue is full after first task */
+	executor_pause(ex);
+	for (i = 0; i < 10; i++) {
+		ASSERT_EQUAL(0, executor_submit(ex, count_task, &count));
+	}
+	ASSERT_EQUAL_U(9, count);
+	executor_stats(ex, &stats);
+	ASSERT_EQUAL_U(1, stats.total);
+	ASSERT_EQUAL_U(10, stats.submitted);
+	ASSERT_EQUAL_U(0, stats.rejected);
+	ASSERT_EQUAL_U(9, stats.caller_runs);
+	executor_resume(ex);
+	executor_run(ex, &count);
+	ASSERT_EQUAL_U(TASKS * 2 + 10, count);
+	executor_destroy(ex);
+}
+
+static int custom_submit(void *impl, void (*function)(void *), void *arg) {
+	(void) function;
+	(void) arg;
+	if (*(size_t *) impl == 0) {
+		errno = EAGAIN;
+		return -1;
+	}
+	(*(size_t *) impl)--;
+	return 0;
+}
+
+static void custom_wait(void *impl) {
+	(void) impl;
+}
+
+CTEST(executor, custom) {
+	executor_ops_t ops;
+	executor_stats_t stats;
+	executor_task_t batch[BATCH];
+	size_t capacity = 10, count = 0, i;
+	executor_t ex;
+
+	memset(&ops, 0, sizeof(ops));
+	ops.name = "custom";
+	ops.submit = custom_submit;
+	errno = 0;
+	ASSERT_NULL(executor_create(&ops, &capacity));
+	ASSERT_EQUAL(EINVAL, errno);
+	ops.wait = custom_wait;
+	ex = executor_create(&ops, &capacity);
+	ASSERT_NOT_NULL(ex);
+	for (i = 0; i < BATCH; i++) {
+		batch[i].function = count_task;
+		batch[i].arg = &count;
+	}
+	ASSERT_EQUAL_U(10, executor_submit_batch(ex, batch, BATCH));
+	ASSERT_EQUAL(-1, executor_submit(ex, count_task, &count));
+	executor_stats(ex, &stats);
+	ASSERT_EQUAL_U(10, stats.submitted);
+	ASSERT_EQUAL_U(2, stats.rejected);
+	executor_destroy(ex);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
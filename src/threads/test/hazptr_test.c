@@ -0,0 +1,126 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/hazptr.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define READERS 3
+#define LOOPS 20000
+
+#define NODE_LIVE 0x5AFE
+#define NODE_DEAD 0xDEAD
+
+struct node {
+	size_t magic;
+	size_t value;
+};
+
+static size_t freed;
+
+/* nodes memory is freed at test end, so use after reclaim is detected by magic */
+static void node_free(void *p) {
+	struct node *n = (struct node *) p;
+	n->magic = NODE_DEAD;
+	__atomic_add_fetch(&freed, 1, __ATOMIC_RELAXED);
+}
+
+struct shared {
+	hazptr_t h;
+	struct node *head;
+	struct node *nodes;
+	int stop;
+	size_t errors;
+};
+
+static void shared_init(struct shared *s) {
+	memset(s, 0, sizeof(struct shared));
+	s->h = hazptr_create();
+	s->nodes = (struct node *) calloc(LOOPS + 1, sizeof(struct node));
+	s->nodes[0].magic = NODE_LIVE;
+	s->head = &s->nodes[0];
+	freed = 0;
+}
+
+static void shared_update(struct shared *s, size_t i) {
+	struct node *n = &s->nodes[i], *old;
+	n->magic = NODE_LIVE;
+	n->value = i;
+	old = __atomic_exchange_n(&s->head, n, __ATOMIC_ACQ_REL);
+	hazptr_retire(s->h, old, node_free);
+}
+
+static void *reader_thread(void *p) {
+	struct shared *s = (struct shared *) p;
+	struct node *n;
+	int i;
+	while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+		n = (struct node *) hazptr_protect(s->h, 1, (void *const *) &s->head);
+		for (i = 0; i < 16; i++) {
+			if (__atomic_load_n(&n->magic, __ATOMIC_RELAXED) != NODE_LIVE)
+				__atomic_add_fetch(&s->errors, 1, __ATOMIC_RELAXED);
+		}
+		hazptr_clear(s->h, 1);
+	}
+	return NULL;
+}
+
+CTEST(hazptr, protect) {
+	struct shared s;
+	struct node *n;
+	size_t i;
+
+	shared_init(&s);
+	ASSERT_NOT_NULL(s.h);
+	n = (struct node *) hazptr_protect(s.h, 0, (void *const *) &s.head);
+	ASSERT_TRUE(n == &s.nodes[0]);
+	for (i = 1; i <= HAZPTR_BATCH * 2; i++) {
+		shared_update(&s, i);
+	}
+	/* protected node is not freed */
+	ASSERT_EQUAL_U(1, hazptr_reclaim(s.h));
+	ASSERT_EQUAL_U(NODE_LIVE, n->magic);
+	hazptr_clear(s.h, 0);
+	ASSERT_EQUAL_U(0, hazptr_reclaim(s.h));
+	ASSERT_EQUAL_U(HAZPTR_BATCH * 2, freed);
+
+	hazptr_destroy(s.h);
+	free(s.nodes);
+}
+
+CTEST(hazptr, readers) {
+	struct shared s;
+	pthread_t t[READERS];
+	size_t i;
+
+	shared_init(&s);
+	ASSERT_NOT_NULL(s.h);
+	for (i = 0; i < READERS; i++) {
+		pthread_create(&t[i], NULL, reader_thread, &s);
+	}
+	for (i = 1; i <= LOOPS; i++) {
+		shared_update(&s, i);
+	}
+	__atomic_store_n(&s.stop, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < READERS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, s.errors);
+	ASSERT_EQUAL_U(0, hazptr_reclaim(s.h));
+	ASSERT_EQUAL_U(LOOPS, freed);
+
+	hazptr_destroy(s.h);
+	free(s.nodes);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
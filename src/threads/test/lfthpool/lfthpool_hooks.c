@@ -0,0 +1,153 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#if defined(__linux__)
+#include <sys/prctl.h>
+#endif
+
+#include <threads/lfthpool.h>
+
+#include <ctest.h>
+
+#define HOOKS_WORKERS 4
+#define HOOKS_TASKS 10000
+
+struct hooks_ctx {
+	size_t index;
+	size_t tasks;
+};
+
+static size_t hooks_inits;
+static size_t hooks_finis;
+static size_t hooks_tasks;
+static size_t hooks_errors;
+
+static int hooks_init(size_t index, void **ctx) {
+	struct hooks_ctx *c = (struct hooks_ctx *) calloc(1, sizeof(struct hooks_ctx));
+	if (c == NULL)
+		return ENOMEM;
+	c->index = index;
+	*ctx = c;
+	__atomic_add_fetch(&hooks_inits, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static int hooks_init_fail(size_t index, void **ctx) {
+	if (index == 1)
+		return EPERM;
+	return hooks_init(index, ctx);
+}
+
+static void hooks_fini(void *ctx) {
+	struct hooks_ctx *c = (struct hooks_ctx *) ctx;
+	__atomic_add_fetch(&hooks_tasks, c->tasks, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&hooks_finis, 1, __ATOMIC_RELAXED);
+	free(c);
+}
+
+static void hooks_job(void *p) {
+	const pool_worker_t *w = pool_current_worker();
+	struct hooks_ctx *c;
+	(void) p;
+	if (w == NULL || w->index >= HOOKS_WORKERS || (c = (struct hooks_ctx *) w->ctx) == NULL || c->index != w->index) {
+		__atomic_add_fetch(&hooks_errors, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	/* worker-local, no synchronization */
+	c->tasks++;
+}
+
+CTEST(lfthpool_hooks, test) {
+	lfthpool_t pool;
+	size_t i;
+
+	hooks_inits = hooks_finis = hooks_tasks = hooks_errors = 0;
+	ASSERT_NULL(pool_current_worker());
+	pool = lfthpool_create_hooks(HOOKS_WORKERS, 1024, NULL, hooks_init, hooks_fini);
+	ASSERT_NOT_NULL(pool);
+	/* all workers are inited before create return */
+	ASSERT_EQUAL_U(HOOKS_WORKERS, hooks_inits);
+	for (i = 0; i < HOOKS_TASKS; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task_try(pool, hooks_job, NULL, 100, 1000000));
+	}
+	lfthpool_wait(pool);
+	lfthpool_destroy(pool);
+	ASSERT_EQUAL_U(0, hooks_errors);
+	ASSERT_EQUAL_U(HOOKS_WORKERS, hooks_finis);
+	ASSERT_EQUAL_U(HOOKS_TASKS, hooks_tasks);
+}
+
+CTEST(lfthpool_hooks, init_fail) {
+	lfthpool_t pool;
+
+	hooks_inits = hooks_finis = 0;
+	errno = 0;
+	pool = lfthpool_create_hooks(HOOKS_WORKERS, 1024, NULL, hooks_init_fail, hooks_fini);
+	ASSERT_NULL(pool);
+	ASSERT_EQUAL(EPERM, errno);
+	/* fini is called only for inited workers */
+	ASSERT_EQUAL_U(HOOKS_WORKERS - 1, hooks_inits);
+	ASSERT_EQUAL_U(HOOKS_WORKERS - 1, hooks_finis);
+}
+
+static void attr_job(void *p) {
+	size_t *errors = (size_t *) p;
+#if defined(__linux__)
+	char name[16];
+	prctl(PR_GET_NAME, name, 0, 0, 0);
+	if (strcmp(name, "attr-0") != 0)
+		__atomic_add_fetch(errors, 1, __ATOMIC_RELAXED);
+	/* pinned */
+	if (sched_getcpu() != 0)
+		__atomic_add_fetch(errors, 1, __ATOMIC_RELAXED);
+#else
+	(void) errors;
+#endif
+}
+
+CTEST(lfthpool_hooks, attr) {
+	lfthpool_t pool;
+	pool_attr_t attr;
+	int cpus[] = { 0 };
+	size_t errors = 0;
+
+	pool_attr_init(&attr, 1, 16);
+	attr.stack_size = 128 * 1024;
+	attr.guard_size = 8192;
+	attr.name = "attr";
+#if defined(__linux__)
+	attr.cpus = cpus;
+	attr.cpus_count = 1;
+	attr.cpus_pin = 1;
+#else
+	(void) cpus;
+#endif
+	pool = lfthpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+	ASSERT_EQUAL(0, lfthpool_add_task(pool, attr_job, &errors));
+	lfthpool_wait(pool);
+	lfthpool_destroy(pool);
+	ASSERT_EQUAL_U(0, errors);
+
+	/* stack is too small */
+	attr.stack_size = 1;
+	errno = 0;
+	ASSERT_NULL(lfthpool_create_ex(&attr));
+	ASSERT_EQUAL(EINVAL, errno);
+
+	/* nice is out of range */
+	attr.stack_size = 0;
+	attr.nice = -100;
+	errno = 0;
+	ASSERT_NULL(lfthpool_create_ex(&attr));
+	ASSERT_EQUAL(EINVAL, errno);
+}
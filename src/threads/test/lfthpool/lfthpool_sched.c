@@ -0,0 +1,147 @@
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <pthread.h>
+
+#include <threads/lfthpool.h>
+
+#include <ctest.h>
+
+#define SCHED_PARK_USECS 5000000
+
+/* scheduler adapter, wrapped OS threads adapter with counters */
+struct sched_counters {
+	const pool_sched_t *os;
+	size_t self;
+	size_t park;
+	size_t unpark;
+	size_t yield;
+};
+
+static uintptr_t sched_self(void *ctx) {
+	struct sched_counters *c = (struct sched_counters *) ctx;
+	__atomic_add_fetch(&c->self, 1, __ATOMIC_RELAXED);
+	return c->os->self(c->os->ctx);
+}
+
+static void sched_park(void *ctx, uint64_t deadline) {
+	struct sched_counters *c = (struct sched_counters *) ctx;
+	__atomic_add_fetch(&c->park, 1, __ATOMIC_RELAXED);
+	c->os->park(c->os->ctx, deadline);
+}
+
+static void sched_unpark(void *ctx, uintptr_t token) {
+	struct sched_counters *c = (struct sched_counters *) ctx;
+	__atomic_add_fetch(&c->unpark, 1, __ATOMIC_RELAXED);
+	c->os->unpark(c->os->ctx, token);
+}
+
+static void sched_yield_func(void *ctx) {
+	struct sched_counters *c = (struct sched_counters *) ctx;
+	__atomic_add_fetch(&c->yield, 1, __ATOMIC_RELAXED);
+	c->os->yield(c->os->ctx);
+}
+
+static void sched_init(pool_sched_t *sched, struct sched_counters *c) {
+	memset(c, 0, sizeof(struct sched_counters));
+	c->os = pool_sched_thread();
+	sched->ctx = c;
+	sched->self = sched_self;
+	sched->park = sched_park;
+	sched->unpark = sched_unpark;
+	sched->yield = sched_yield_func;
+}
+
+static uint64_t sched_now_usecs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static void sched_block_job(void *p) {
+	int *release = (int *) p;
+	while (__atomic_load_n(release, __ATOMIC_ACQUIRE) == 0)
+		usleep(100);
+}
+
+static void sched_sleep_job(void *p) {
+	(void) p;
+	usleep(20000);
+}
+
+static void *sched_release_thread(void *p) {
+	usleep(20000);
+	__atomic_store_n((int *) p, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+CTEST(lfthpool_sched, add_task_try_unpark) {
+	struct sched_counters c;
+	pool_sched_t sched;
+	pool_attr_t attr;
+	lfthpool_t pool;
+	pthread_t t;
+	int release = 0, i;
+	uint64_t start, elapsed;
+
+	sched_init(&sched, &c);
+	pool_attr_init(&attr, 1, 2);
+	attr.sched = &sched;
+	pool = lfthpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+
+	/* worker is busy, queue is full */
+	ASSERT_EQUAL(0, lfthpool_add_task(pool, sched_block_job, &release));
+	while (lfthpool_active_tasks(pool) == 0)
+		usleep(100);
+	for (i = 0; i < 2; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, sched_block_job, &release));
+	}
+	ASSERT_EQUAL(-1, lfthpool_add_task(pool, sched_block_job, &release));
+
+	/* caller is parked and woken, when worker take task (not after timeout) */
+	ASSERT_EQUAL(0, pthread_create(&t, NULL, sched_release_thread, &release));
+	start = sched_now_usecs();
+	ASSERT_EQUAL(0, lfthpool_add_task_try(pool, sched_block_job, &release, SCHED_PARK_USECS, 1));
+	elapsed = sched_now_usecs() - start;
+	pthread_join(t, NULL);
+	ASSERT_TRUE(elapsed < SCHED_PARK_USECS / 2);
+	ASSERT_TRUE(__atomic_load_n(&c.park, __ATOMIC_RELAXED) > 0);
+	ASSERT_TRUE(__atomic_load_n(&c.unpark, __ATOMIC_RELAXED) > 0);
+
+	lfthpool_wait(pool);
+	ASSERT_EQUAL_U(0, lfthpool_total_tasks(pool));
+
+	/* zero timeout - yield */
+	ASSERT_EQUAL(0, lfthpool_add_task_try(pool, sched_block_job, &release, 0, 10));
+	lfthpool_destroy(pool);
+}
+
+CTEST(lfthpool_sched, wait_unpark) {
+	struct sched_counters c;
+	pool_sched_t sched;
+	pool_attr_t attr;
+	lfthpool_t pool;
+	int i;
+
+	sched_init(&sched, &c);
+	pool_attr_init(&attr, 2, 16);
+	attr.sched = &sched;
+	pool = lfthpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+
+	for (i = 0; i < 4; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, sched_sleep_job, NULL));
+	}
+	lfthpool_wait(pool);
+	ASSERT_EQUAL_U(0, lfthpool_total_tasks(pool));
+	ASSERT_TRUE(__atomic_load_n(&c.self, __ATOMIC_RELAXED) > 0);
+	ASSERT_TRUE(__atomic_load_n(&c.park, __ATOMIC_RELAXED) > 0);
+	ASSERT_TRUE(__atomic_load_n(&c.unpark, __ATOMIC_RELAXED) > 0);
+
+	lfthpool_destroy(pool);
+}
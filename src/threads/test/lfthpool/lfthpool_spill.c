@@ -0,0 +1,159 @@
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#include <pthread.h>
+
+#include <threads/lfthpool.h>
+
+#include <ctest.h>
+
+#define SPILL_TASKS 1000
+#define SPILL_WRITERS 4
+#define SPILL_LOOP_COUNT 50000
+
+struct spill_param {
+	int n;
+	lfthpool_t pool;
+};
+
+static void spill_job(void *p){
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-value"
+	int *i = (int *) p;
+	__atomic_add_fetch(i, 1, __ATOMIC_RELEASE);
+#pragma GCC diagnostic pop
+}
+
+static void *spill_add_task_thread(void *p){
+	size_t i;
+	struct spill_param *param = (struct spill_param *) p;
+	for (i = 0; i < SPILL_LOOP_COUNT; i++) {
+		if (lfthpool_add_task(param->pool, spill_job, &param->n) != 0)
+			abort();
+	}
+	return NULL;
+}
+
+CTEST(lfthpool_spill, test) {
+	lfthpool_t pool;
+	int n = 0, i;
+
+	pool = lfthpool_create(2, 4);
+	ASSERT_NOT_NULL(pool);
+	lfthpool_pause(pool);
+	usleep(1000);
+
+	/* queue is full without spill */
+	for (i = 0; i < 4; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, spill_job, &n));
+	}
+	ASSERT_EQUAL(-1, lfthpool_add_task(pool, spill_job, &n));
+	ASSERT_EQUAL(EAGAIN, errno);
+
+	lfthpool_set_spill(pool, 1);
+	for (i = 4; i < SPILL_TASKS; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, spill_job, &n));
+	}
+	ASSERT_EQUAL_U(SPILL_TASKS, lfthpool_total_tasks(pool));
+
+	lfthpool_resume(pool);
+	lfthpool_wait(pool);
+	sched_yield();
+	usleep(500);
+	lfthpool_wait(pool);
+
+	ASSERT_EQUAL_U(0, lfthpool_total_tasks(pool));
+	ASSERT_EQUAL(SPILL_TASKS, __atomic_add_fetch(&n, 0, __ATOMIC_RELEASE));
+
+	/* spilled tasks are freed on destroy */
+	lfthpool_pause(pool);
+	usleep(1000);
+	for (i = 0; i < SPILL_TASKS; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(pool, spill_job, &n));
+	}
+	lfthpool_destroy(pool);
+}
+
+CTEST(lfthpool_spill, threads_test) {
+	struct spill_param param;
+	size_t i;
+	pthread_t t_handles[SPILL_WRITERS];
+
+	param.n = 0;
+	param.pool = lfthpool_create(4, 16);
+	ASSERT_NOT_NULL(param.pool);
+	lfthpool_set_spill(param.pool, 1);
+
+	for (i = 0; i < SPILL_WRITERS; i++) {
+		ASSERT_EQUAL(0, pthread_create(&t_handles[i], NULL, spill_add_task_thread, &param));
+	}
+	for (i = 0; i < SPILL_WRITERS; i++) {
+		pthread_join(t_handles[i], NULL);
+	}
+
+	lfthpool_wait(param.pool);
+	sched_yield();
+	usleep(300);
+	lfthpool_wait(param.pool);
+
+	ASSERT_EQUAL_U(0, lfthpool_total_tasks(param.pool));
+	ASSERT_EQUAL(SPILL_WRITERS * SPILL_LOOP_COUNT, __atomic_add_fetch(&param.n, 0, __ATOMIC_RELEASE));
+
+	lfthpool_destroy(param.pool);
+}
+
+#define SPILL_FILLERS_MAX 100000
+
+struct spill_full_param {
+	lfthpool_t pool;
+	int marker; /* spilled task is run */
+	size_t fillers; /* filler tasks runs */
+	size_t errors;
+};
+
+static void spill_marker_job(void *p) {
+	struct spill_full_param *param = (struct spill_full_param *) p;
+	__atomic_store_n(&param->marker, 1, __ATOMIC_RELEASE);
+}
+
+/* filler resubmit itself, so queue is kept full, until spilled task is run */
+static void spill_filler_job(void *p) {
+	struct spill_full_param *param = (struct spill_full_param *) p;
+	if (__atomic_load_n(&param->marker, __ATOMIC_ACQUIRE) ||
+			__atomic_add_fetch(&param->fillers, 1, __ATOMIC_RELAXED) >= SPILL_FILLERS_MAX)
+		return;
+	if (lfthpool_add_task(param->pool, spill_filler_job, param) != 0)
+		__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+}
+
+CTEST(lfthpool_spill, full_queue) {
+	struct spill_full_param param;
+	int i;
+
+	memset(&param, 0, sizeof(param));
+	/* one worker: queue is never empty, while fillers run */
+	param.pool = lfthpool_create(1, 8);
+	ASSERT_NOT_NULL(param.pool);
+	lfthpool_set_spill(param.pool, 1);
+	lfthpool_pause(param.pool);
+	usleep(1000);
+
+	for (i = 0; i < 8; i++) {
+		ASSERT_EQUAL(0, lfthpool_add_task(param.pool, spill_filler_job, &param));
+	}
+	ASSERT_EQUAL(0, lfthpool_add_task(param.pool, spill_marker_job, &param));
+	ASSERT_EQUAL_U(9, lfthpool_total_tasks(param.pool));
+
+	lfthpool_resume(param.pool);
+	lfthpool_wait(param.pool);
+
+	ASSERT_EQUAL(1, param.marker);
+	ASSERT_TRUE(param.fillers < SPILL_FILLERS_MAX);
+	ASSERT_EQUAL_U(0, param.errors);
+
+	lfthpool_destroy(param.pool);
+}
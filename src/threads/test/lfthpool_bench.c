@@ -2,6 +2,7 @@
  * Try to run lfthpool with a non-zero heap and stack
  */
 #include <pthread.h>
+#include <sched.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,6 +10,9 @@
 #include <sys/time.h>
 
 #include <threads/lfthpool.h>
+#include <threads/spsc_ring.h>
+
+#include <concurrent/mpmc_ring_queue.h>
 
 #include <pthread.h>
 #if NO_PTHREAD_BARRIER
@@ -57,7 +61,8 @@ static void *add_task_thread(void *p){
 	return NULL;
 }
 
-void bench(size_t writers, size_t readers, size_t loop_count) {
+/* spill - small queue with overflow list for bursts */
+void bench(size_t writers, size_t readers, size_t loop_count, int spill) {
 	size_t i;
 	uint64_t start, end, duration;
 	struct task_param param;
@@ -66,7 +71,9 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
     pthread_t *t_handles;
 	size_t queue_size;
 
-	if (loop_count > 40000000) {
+	if (spill) {
+		queue_size = 1024;
+	} else if (loop_count > 40000000) {
 		queue_size = 40000000;
 	} else {
 		queue_size = loop_count;
@@ -76,6 +83,7 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	param.w = 0;
 	param.loop_count = loop_count;
 	param.pool = lfthpool_create(readers, queue_size);
+	lfthpool_set_spill(param.pool, spill);
 
 	pthread_barrier_init(&param.start_barrier, NULL, (unsigned int) writers + 1);
 
@@ -107,8 +115,8 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	if (param.n != loop_count * (size_t) writers) {
 		ret++;	
 	}
-	printf("lfthpool, %llu threads pool, %llu writers (%f ms, %lu iterations, %llu ns/op, %llu op/s) ",
-		(unsigned long long) readers, (unsigned long long) writers,
+	printf("lfthpool%s, %llu threads pool, %llu writers (%f ms, %lu iterations, %llu ns/op, %llu op/s) ",
+		spill ? " (spill)" : "", (unsigned long long) readers, (unsigned long long) writers,
 		((double) end - (double) start) / 1000,
 		(unsigned long) loop_count,
 		(unsigned long long) duration * 1000 / loop_count,
@@ -124,6 +132,137 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	}
 }
 
+/* one producer to one consumer edge: MPMC queue (used by lfthpool) vs SPSC ring */
+
+#define QUEUE_SIZE 1024
+#define QUEUE_BATCH 32
+
+enum queue_type {
+	QUEUE_MPMC,
+	QUEUE_SPSC,
+	QUEUE_SPSC_BATCH
+};
+
+static const char *queue_names[] = { "mpmc_ring_queue", "spsc_ring", "spsc_ring (batch)" };
+
+struct queue_param {
+	enum queue_type type;
+	size_t loop_count;
+	size_t sum;
+	mpmc_ring_queue *mpmc;
+	spsc_ring_t spsc;
+};
+
+static void *queue_producer_thread(void *p) {
+	struct queue_param *param = (struct queue_param *) p;
+	void *items[QUEUE_BATCH];
+	size_t i = 1, j, n;
+	while (i <= param->loop_count) {
+		switch (param->type) {
+		case QUEUE_MPMC:
+			if (mpmc_ring_queue_enqueue(param->mpmc, (void *) (uintptr_t) i) == QERR_OK) {
+				i++;
+				continue;
+			}
+			break;
+		case QUEUE_SPSC:
+			if (spsc_ring_push(&param->spsc, (void *) (uintptr_t) i) == 0) {
+				i++;
+				continue;
+			}
+			break;
+		default:
+			n = param->loop_count + 1 - i < QUEUE_BATCH ? param->loop_count + 1 - i : QUEUE_BATCH;
+			for (j = 0; j < n; j++) {
+				items[j] = (void *) (uintptr_t) (i + j);
+			}
+			if ((n = spsc_ring_push_batch(&param->spsc, items, n)) > 0) {
+				i += n;
+				continue;
+			}
+		}
+		sched_yield();
+	}
+	return NULL;
+}
+
+static void *queue_consumer_thread(void *p) {
+	struct queue_param *param = (struct queue_param *) p;
+	void *items[QUEUE_BATCH];
+	void *item;
+	size_t count = 0, j, n;
+	while (count < param->loop_count) {
+		switch (param->type) {
+		case QUEUE_MPMC:
+			if ((item = mpmc_ring_queue_dequeue(param->mpmc)) != NULL) {
+				param->sum += (uintptr_t) item;
+				count++;
+				continue;
+			}
+			break;
+		case QUEUE_SPSC:
+			if ((item = spsc_ring_pop(&param->spsc)) != NULL) {
+				param->sum += (uintptr_t) item;
+				count++;
+				continue;
+			}
+			break;
+		default:
+			if ((n = spsc_ring_pop_batch(&param->spsc, items, QUEUE_BATCH)) > 0) {
+				for (j = 0; j < n; j++) {
+					param->sum += (uintptr_t) items[j];
+				}
+				count += n;
+				continue;
+			}
+		}
+		sched_yield();
+	}
+	return NULL;
+}
+
+void bench_queue(enum queue_type type, size_t loop_count) {
+	uint64_t start, end, duration;
+	struct queue_param param;
+	pthread_t producer, consumer;
+
+	memset(&param, 0, sizeof(param));
+	param.type = type;
+	param.loop_count = loop_count;
+	if (type == QUEUE_MPMC) {
+		param.mpmc = mpmc_ring_queue_new(QUEUE_SIZE, NULL);
+	} else {
+		spsc_ring_init(&param.spsc, QUEUE_SIZE, 0);
+	}
+
+	start = getCurrentTime();
+	pthread_create(&consumer, NULL, queue_consumer_thread, &param);
+	pthread_create(&producer, NULL, queue_producer_thread, &param);
+	pthread_join(producer, NULL);
+	pthread_join(consumer, NULL);
+	end = getCurrentTime();
+
+	if (type == QUEUE_MPMC) {
+		mpmc_ring_queue_delete(param.mpmc, NULL);
+	} else {
+		spsc_ring_destroy(&param.spsc);
+	}
+	duration = end - start;
+	if (duration == 0) {
+		duration = 1;
+	}
+	if (param.sum != loop_count * (loop_count + 1) / 2) {
+		ret++;
+	}
+	printf("%s, 1 producer, 1 consumer (%f ms, %lu iterations, %llu ns/op, %llu op/s) [%s]\n",
+		queue_names[type],
+		((double) end - (double) start) / 1000,
+		(unsigned long) loop_count,
+		(unsigned long long) duration * 1000 / loop_count,
+		(unsigned long long) 1000000 * loop_count / duration,
+		param.sum == loop_count * (loop_count + 1) / 2 ? "OK" : "ERR");
+}
+
 int main() {
 	char *COUNT_STR = getenv("LOOP_COUNT");
 	if (COUNT_STR) {
@@ -132,7 +271,12 @@ int main() {
 			LOOP_COUNT = c;
 		}
 	}
-	bench(1, 4, LOOP_COUNT);
-	bench(4, 4, LOOP_COUNT);
+	bench(1, 4, LOOP_COUNT, 0);
+	bench(4, 4, LOOP_COUNT, 0);
+	bench(1, 4, LOOP_COUNT, 1);
+	bench(4, 4, LOOP_COUNT, 1);
+	bench_queue(QUEUE_MPMC, LOOP_COUNT);
+	bench_queue(QUEUE_SPSC, LOOP_COUNT);
+	bench_queue(QUEUE_SPSC_BATCH, LOOP_COUNT);
 	return ret;
 }
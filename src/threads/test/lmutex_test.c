@@ -0,0 +1,125 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/lmutex.h>
+#include <threads/spinlock.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define THREADS 4
+#define LOOPS 20000
+
+struct lock_param {
+	lmutex_t m;
+	ticketlock_t t;
+	mcslock_t mcs;
+	size_t n;
+};
+
+static void *lmutex_thread(void *p) {
+	struct lock_param *param = (struct lock_param *) p;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		lmutex_lock(&param->m);
+		param->n++;
+		lmutex_unlock(&param->m);
+	}
+	return NULL;
+}
+
+static void *ticketlock_thread(void *p) {
+	struct lock_param *param = (struct lock_param *) p;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		ticketlock_lock(&param->t);
+		param->n++;
+		ticketlock_unlock(&param->t);
+	}
+	return NULL;
+}
+
+static void *mcslock_thread(void *p) {
+	struct lock_param *param = (struct lock_param *) p;
+	mcs_node_t node;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		mcslock_lock(&param->mcs, &node);
+		param->n++;
+		mcslock_unlock(&param->mcs, &node);
+	}
+	return NULL;
+}
+
+static size_t run_threads(void *(*thread)(void *)) {
+	struct lock_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	lmutex_init(&param.m);
+	ticketlock_init(&param.t);
+	mcslock_init(&param.mcs);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, thread, &param);
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	lmutex_destroy(&param.m);
+	return param.n;
+}
+
+CTEST(lmutex, try) {
+	lmutex_t m;
+	lmutex_init(&m);
+	ASSERT_EQUAL(0, lmutex_trylock(&m));
+	ASSERT_EQUAL(-1, lmutex_trylock(&m));
+	lmutex_unlock(&m);
+	ASSERT_EQUAL(0, lmutex_trylock(&m));
+	lmutex_unlock(&m);
+	ASSERT_EQUAL_U(0, m.state);
+	lmutex_destroy(&m);
+}
+
+CTEST(lmutex, threads) {
+	ASSERT_EQUAL_U(THREADS * LOOPS, run_threads(lmutex_thread));
+}
+
+CTEST(ticketlock, try) {
+	ticketlock_t l;
+	ticketlock_init(&l);
+	ASSERT_EQUAL(0, ticketlock_trylock(&l));
+	ASSERT_EQUAL(-1, ticketlock_trylock(&l));
+	ticketlock_unlock(&l);
+	ASSERT_EQUAL(0, ticketlock_trylock(&l));
+	ticketlock_unlock(&l);
+}
+
+CTEST(ticketlock, threads) {
+	ASSERT_EQUAL_U(THREADS * LOOPS, run_threads(ticketlock_thread));
+}
+
+CTEST(mcslock, try) {
+	mcslock_t l;
+	mcs_node_t n1, n2;
+	mcslock_init(&l);
+	ASSERT_EQUAL(0, mcslock_trylock(&l, &n1));
+	ASSERT_EQUAL(-1, mcslock_trylock(&l, &n2));
+	mcslock_unlock(&l, &n1);
+	ASSERT_NULL(l.tail);
+}
+
+CTEST(mcslock, threads) {
+	ASSERT_EQUAL_U(THREADS * LOOPS, run_threads(mcslock_thread));
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -29,9 +29,21 @@ struct task_param {
 	size_t w;
 	size_t loop_count;
 	lusem_t lsem;
+	uint64_t *latency; /* per-wait latency (ns) */
 	pthread_barrier_t start_barrier;
 };
 
+static uint64_t getCurrentTimeNs(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000 + (uint64_t) ts.tv_nsec;
+}
+
+static int cmp_uint64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
 static void *notify_thread(void *p){
 	struct task_param *param = (struct task_param *) p;
 	pthread_barrier_wait(&param->start_barrier);
@@ -42,15 +54,19 @@ static void *notify_thread(void *p){
 }
 
 static void *wait_thread(void *p){
+	size_t i;
+	uint64_t start;
 	struct task_param *param = (struct task_param *) p;
-	while (__atomic_fetch_add(&param->w, 1, __ATOMIC_RELAXED) < param->loop_count) {
+	while ((i = __atomic_fetch_add(&param->w, 1, __ATOMIC_RELAXED)) < param->loop_count) {
+		start = getCurrentTimeNs();
 		lusem_wait(&param->lsem);
+		param->latency[i] = getCurrentTimeNs() - start;
 	}
 	__atomic_fetch_sub(&param->n, 1, __ATOMIC_RELAXED);
 	return NULL;
 }
 
-void bench(size_t writers, size_t readers, size_t loop_count) {
+void bench(size_t writers, size_t readers, size_t loop_count, int fair) {
 	size_t i;
 	uint64_t start, end, duration;
 	struct task_param param;
@@ -61,7 +77,12 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	param.n = readers;
 	param.w = 0;
 	param.loop_count = loop_count;
-	lusem_init(&param.lsem, 0, 2);
+	param.latency = (uint64_t *) calloc(loop_count, sizeof(uint64_t));
+	if (fair) {
+		lusem_init_fair(&param.lsem, 0, 2);
+	} else {
+		lusem_init(&param.lsem, 0, 2);
+	}
 
 	pthread_barrier_init(&param.start_barrier, NULL, (unsigned int) writers + 1);
 
@@ -106,13 +127,24 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	} else {
 		perr = 0;
 	}
-	printf("%llu writers, %llu readers (%f ms, %lu iterations, %llu ns/op, %llu op/s) [%s]\n",
+	printf("%s, %llu writers, %llu readers (%f ms, %lu iterations, %llu ns/op, %llu op/s) [%s]\n",
+		fair ? "fair" : "barging",
 		(unsigned long long) writers, (unsigned long long) readers,
 		((double) end - (double) start) / 1000,
 		(unsigned long) loop_count,
 		(unsigned long long) duration * 1000 / loop_count,
 		(unsigned long long) 1000000 * loop_count / duration,			
 		perr == 0 ? "OK" : "ERR");
+
+	qsort(param.latency, loop_count, sizeof(uint64_t), cmp_uint64);
+	printf("  wait latency: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, max %llu ns\n",
+		(unsigned long long) param.latency[loop_count / 2],
+		(unsigned long long) param.latency[loop_count * 99 / 100],
+		(unsigned long long) param.latency[loop_count * 999 / 1000],
+		(unsigned long long) param.latency[loop_count - 1]);
+
+	free(param.latency);
+	lusem_destroy(&param.lsem);
 }
 
 static void *signal_thread(void *p){
@@ -176,6 +208,88 @@ CTEST2(lusem, timed_wait) {
 	ASSERT_EQUAL(0, rc);
 }
 
+CTEST_DATA(lusem_fair) {
+    lusem_t lsem;
+    pthread_t tid;
+};
+
+CTEST_SETUP(lusem_fair) {
+    lusem_init_fair(&data->lsem, 0, 2);
+    data->tid = 0;
+}
+
+CTEST_TEARDOWN(lusem_fair) {
+    if (data->tid != 0) {
+		pthread_join(data->tid, NULL);
+	}
+	lusem_destroy(&data->lsem);
+}
+
+CTEST2(lusem_fair, wait) {
+	int rc;
+    int perr = signal_post(&data->tid, &data->lsem);
+	ASSERT_EQUAL_D(0, perr, strerror(perr));
+	lusem_signal(&data->lsem);
+	rc = lusem_wait(&data->lsem);
+	ASSERT_EQUAL_D(0, rc, strerror(errno));
+	rc = lusem_wait(&data->lsem);
+	ASSERT_EQUAL_D(0, rc, strerror(errno));
+}
+
+CTEST2(lusem_fair, timed_wait_timeout) {
+	int rc;
+	rc = lusem_timed_wait(&data->lsem, 20000);
+	ASSERT_TRUE_D(rc != 0, strerror(errno));
+	ASSERT_EQUAL(0, (int) __atomic_load_n(&data->lsem.m_count, __ATOMIC_RELAXED));
+	ASSERT_NULL(data->lsem.head);
+}
+
+#define FAIR_WAITERS 4
+
+struct fair_order {
+	lusem_t *lsem;
+	size_t id;
+	size_t *pos;
+	size_t *order;
+};
+
+static void *fair_wait_thread(void *p){
+	struct fair_order *o = (struct fair_order *) p;
+	lusem_wait(o->lsem);
+	o->order[__atomic_fetch_add(o->pos, 1, __ATOMIC_RELAXED)] = o->id;
+	return NULL;
+}
+
+CTEST2(lusem_fair, fifo) {
+	size_t i, pos = 0;
+	size_t order[FAIR_WAITERS];
+	struct fair_order o[FAIR_WAITERS];
+	pthread_t t[FAIR_WAITERS];
+
+	/* park waiters one by one */
+	for (i = 0; i < FAIR_WAITERS; i++) {
+		o[i].lsem = &data->lsem;
+		o[i].id = i;
+		o[i].pos = &pos;
+		o[i].order = order;
+		ASSERT_EQUAL(0, pthread_create(&t[i], NULL, fair_wait_thread, &o[i]));
+		while (__atomic_load_n(&data->lsem.m_count, __ATOMIC_ACQUIRE) != -(ssize_t) i - 1 || data->lsem.tail == NULL) {
+			usleep(1000);
+		}
+		usleep(10000);
+	}
+	for (i = 0; i < FAIR_WAITERS; i++) {
+		lusem_signal(&data->lsem);
+		while (__atomic_load_n(&pos, __ATOMIC_ACQUIRE) != i + 1) {
+			usleep(100);
+		}
+	}
+	for (i = 0; i < FAIR_WAITERS; i++) {
+		pthread_join(t[i], NULL);
+		ASSERT_EQUAL_U(i, order[i]);
+	}
+}
+
 int main(int argc, const char *argv[]) {
 	char *COUNT_STR = getenv("LOOP_COUNT");
 	if (COUNT_STR) {
@@ -187,7 +301,9 @@ int main(int argc, const char *argv[]) {
 
     ret += ctest_main(argc, argv);
 
-	bench(1, 4, LOOP_COUNT);
-	bench(4, 4, LOOP_COUNT);
+	bench(1, 4, LOOP_COUNT, 0);
+	bench(1, 4, LOOP_COUNT, 1);
+	bench(4, 4, LOOP_COUNT, 0);
+	bench(4, 4, LOOP_COUNT, 1);
 	return ret;
 }
@@ -0,0 +1,163 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/mpsc_queue.h>
+#include <threads/mpsc_executor.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define PRODUCERS 4
+#define LOOPS 20000
+
+struct item {
+	mpsc_node_t node;
+	size_t producer;
+	size_t value;
+};
+
+struct queue_param {
+	mpsc_queue_t q;
+	struct item *items;
+	size_t producer;
+};
+
+struct exec_item {
+	mpsc_task_t task;
+	size_t *sum;
+	size_t value;
+};
+
+struct exec_param {
+	mpsc_executor_t ex;
+	struct exec_item *items;
+	size_t sum;
+};
+
+static void *producer_thread(void *p) {
+	struct queue_param *param = (struct queue_param *) p;
+	size_t i, producer = __atomic_fetch_add(&param->producer, 1, __ATOMIC_RELAXED);
+	struct item *items = param->items + producer * LOOPS;
+	for (i = 0; i < LOOPS; i++) {
+		items[i].producer = producer;
+		items[i].value = i;
+		mpsc_queue_push(&param->q, &items[i].node);
+	}
+	return NULL;
+}
+
+static void exec_task(mpsc_task_t *task) {
+	struct exec_item *item = (struct exec_item *) task;
+	/* single consumer, no atomic required */
+	*item->sum += item->value;
+}
+
+static void *submit_thread(void *p) {
+	struct exec_param *param = (struct exec_param *) p;
+	struct exec_item *items = param->items;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		items[i].sum = &param->sum;
+		items[i].value = i + 1;
+		mpsc_executor_submit(param->ex, &items[i].task, exec_task);
+	}
+	return NULL;
+}
+
+CTEST(mpsc_queue, basic) {
+	mpsc_queue_t q;
+	struct item items[3];
+	size_t i;
+
+	mpsc_queue_init(&q);
+	ASSERT_TRUE(mpsc_queue_is_empty(&q));
+	ASSERT_NULL(mpsc_queue_pop(&q));
+	for (i = 0; i < 3; i++) {
+		items[i].value = i;
+		mpsc_queue_push(&q, &items[i].node);
+	}
+	ASSERT_FALSE(mpsc_queue_is_empty(&q));
+	for (i = 0; i < 3; i++) {
+		ASSERT_TRUE(mpsc_queue_pop(&q) == &items[i].node);
+	}
+	ASSERT_NULL(mpsc_queue_pop(&q));
+	ASSERT_TRUE(mpsc_queue_is_empty(&q));
+	/* reuse after drain */
+	mpsc_queue_push(&q, &items[1].node);
+	ASSERT_TRUE(mpsc_queue_pop(&q) == &items[1].node);
+	ASSERT_TRUE(mpsc_queue_is_empty(&q));
+}
+
+CTEST(mpsc_queue, threads) {
+	struct queue_param param;
+	pthread_t t[PRODUCERS];
+	size_t i, count = 0, next[PRODUCERS];
+	struct item *item;
+
+	memset(&param, 0, sizeof(param));
+	memset(next, 0, sizeof(next));
+	mpsc_queue_init(&param.q);
+	param.items = (struct item *) malloc(PRODUCERS * LOOPS * sizeof(struct item));
+	ASSERT_NOT_NULL(param.items);
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_create(&t[i], NULL, producer_thread, &param);
+	}
+	while (count < PRODUCERS * LOOPS) {
+		if ((item = (struct item *) mpsc_queue_pop(&param.q)) == NULL) {
+			continue;
+		}
+		/* FIFO order per producer */
+		ASSERT_EQUAL_U(next[item->producer], item->value);
+		next[item->producer]++;
+		count++;
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_TRUE(mpsc_queue_is_empty(&param.q));
+	free(param.items);
+}
+
+CTEST(mpsc_executor, threads) {
+	struct exec_param param[PRODUCERS];
+	pthread_t t[PRODUCERS];
+	mpsc_executor_t ex = mpsc_executor_create();
+	struct exec_item *items;
+	size_t i, sum = 0;
+
+	ASSERT_NOT_NULL(ex);
+	items = (struct exec_item *) malloc(PRODUCERS * LOOPS * sizeof(struct exec_item));
+	ASSERT_NOT_NULL(items);
+	memset(param, 0, sizeof(param));
+	for (i = 0; i < PRODUCERS; i++) {
+		param[i].ex = ex;
+		param[i].items = items + i * LOOPS;
+		pthread_create(&t[i], NULL, submit_thread, &param[i]);
+	}
+	for (i = 0; i < PRODUCERS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	mpsc_executor_wait(ex);
+	for (i = 0; i < PRODUCERS; i++) {
+		sum += param[i].sum;
+	}
+	ASSERT_EQUAL_U((size_t) PRODUCERS * LOOPS * (LOOPS + 1) / 2, sum);
+
+	/* destroy execute submitted tasks */
+	param[0].sum = 0;
+	submit_thread(&param[0]);
+	mpsc_executor_destroy(ex);
+	ASSERT_EQUAL_U((size_t) LOOPS * (LOOPS + 1) / 2, param[0].sum);
+	free(items);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
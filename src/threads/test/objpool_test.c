@@ -0,0 +1,167 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/objpool.h>
+#include <threads/spsc_ring.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define THREADS 4
+#define CAPACITY 1024
+#define HOLD 100
+#define LOOPS 2000
+
+struct obj {
+	size_t owner;
+	size_t value;
+};
+
+struct pool_param {
+	objpool_t pool;
+	spsc_ring_t r;
+	size_t errors;
+};
+
+/* hold objects, check nobody else got them */
+static void *get_put_thread(void *p) {
+	struct pool_param *param = (struct pool_param *) p;
+	struct obj *objs[HOLD];
+	size_t i, j, n, owner = (size_t) pthread_self();
+	for (i = 0; i < LOOPS; i++) {
+		n = i % HOLD + 1;
+		for (j = 0; j < n; j++) {
+			if ((objs[j] = (struct obj *) objpool_get(param->pool)) == NULL) {
+				__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+				n = j;
+				break;
+			}
+			objs[j]->owner = owner;
+			objs[j]->value = j;
+		}
+		for (j = 0; j < n; j++) {
+			if (objs[j]->owner != owner || objs[j]->value != j)
+				__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+			objpool_put(param->pool, objs[j]);
+		}
+	}
+	return NULL;
+}
+
+/* objects are allocated in producer and freed in consumer thread */
+static void *producer_thread(void *p) {
+	struct pool_param *param = (struct pool_param *) p;
+	struct obj *o;
+	size_t i;
+	for (i = 1; i <= LOOPS * HOLD; i++) {
+		while ((o = (struct obj *) objpool_get(param->pool)) == NULL) {
+			/* consumer magazine hold objects */
+			usleep(10);
+		}
+		o->value = i;
+		spsc_ring_push_wait(&param->r, o);
+	}
+	return NULL;
+}
+
+static void *consumer_thread(void *p) {
+	struct pool_param *param = (struct pool_param *) p;
+	struct obj *o;
+	size_t i;
+	for (i = 1; i <= LOOPS * HOLD; i++) {
+		spsc_ring_pop_wait(&param->r, (void **) &o, 1, 0);
+		if (o->value != i)
+			param->errors++;
+		objpool_put(param->pool, o);
+	}
+	return NULL;
+}
+
+CTEST(objpool, basic) {
+	objpool_t pool = objpool_create(sizeof(struct obj), CAPACITY);
+	struct obj **objs = (struct obj **) malloc(CAPACITY * sizeof(struct obj *));
+	size_t i, j;
+
+	ASSERT_NOT_NULL(pool);
+	ASSERT_NOT_NULL(objs);
+	ASSERT_EQUAL_U(CAPACITY, objpool_capacity(pool));
+	for (i = 0; i < CAPACITY; i++) {
+		objs[i] = (struct obj *) objpool_get(pool);
+		ASSERT_NOT_NULL(objs[i]);
+		ASSERT_TRUE(objpool_owns(pool, objs[i]));
+		objs[i]->value = i;
+	}
+	/* exhausted */
+	ASSERT_NULL(objpool_get(pool));
+	ASSERT_EQUAL(ENOMEM, errno);
+	ASSERT_FALSE(objpool_owns(pool, &i));
+	for (i = 0; i < CAPACITY; i++) {
+		/* all objects are different */
+		ASSERT_EQUAL_U(i, objs[i]->value);
+		objpool_put(pool, objs[i]);
+	}
+	/* again, from magazine and global stack */
+	for (i = 0; i < CAPACITY; i++) {
+		objs[i] = (struct obj *) objpool_get(pool);
+		ASSERT_NOT_NULL(objs[i]);
+		objs[i]->value = i;
+	}
+	ASSERT_NULL(objpool_get(pool));
+	for (i = 0; i < CAPACITY; i++) {
+		for (j = i + 1; j < CAPACITY && j < i + 8; j++) {
+			ASSERT_TRUE(objs[i] != objs[j]);
+		}
+		ASSERT_EQUAL_U(i, objs[i]->value);
+		objpool_put(pool, objs[i]);
+	}
+	objpool_thread_flush(pool);
+	free(objs);
+	objpool_destroy(pool);
+}
+
+CTEST(objpool, threads) {
+	struct pool_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	/* enough for all threads (with magazines) */
+	param.pool = objpool_create(sizeof(struct obj), THREADS * (HOLD + OBJPOOL_MAGAZINE));
+	ASSERT_NOT_NULL(param.pool);
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, get_put_thread, &param);
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, param.errors);
+	objpool_destroy(param.pool);
+}
+
+CTEST(objpool, cross_thread) {
+	struct pool_param param;
+	pthread_t p, c;
+
+	memset(&param, 0, sizeof(param));
+	param.pool = objpool_create(sizeof(struct obj), 256);
+	ASSERT_NOT_NULL(param.pool);
+	ASSERT_EQUAL(0, spsc_ring_init(&param.r, 64, SPSC_RING_BLOCKING));
+	pthread_create(&c, NULL, consumer_thread, &param);
+	pthread_create(&p, NULL, producer_thread, &param);
+	pthread_join(p, NULL);
+	pthread_join(c, NULL);
+	ASSERT_EQUAL_U(0, param.errors);
+	spsc_ring_destroy(&param.r);
+	objpool_destroy(param.pool);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
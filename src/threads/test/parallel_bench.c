@@ -0,0 +1,170 @@
+/*
+ * parallel_for (guided self-scheduling, caller participate) vs manual chunked loop
+ * (task per chunk and executor_wait) for uniform and skewed iterations
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <threads/parallel.h>
+
+size_t ITERATIONS = 100000;
+size_t WORKERS = 4;
+size_t QUEUE_SIZE = 1024;
+size_t WORK = 200; /* spin iterations per loop iteration (uniform) */
+size_t REPEAT = 10;
+
+int ret = 0;
+
+struct loop_param {
+	int skewed;
+	size_t n; /* processed iterations */
+};
+
+/* skewed: last 1/16 of range is 32 times heavier */
+static size_t iteration_work(const struct loop_param *p, size_t i) {
+	if (p->skewed && i >= ITERATIONS - ITERATIONS / 16)
+		return WORK * 32;
+	return WORK;
+}
+
+static void loop_body(void *ctx, size_t begin, size_t end) {
+	struct loop_param *p = (struct loop_param *) ctx;
+	size_t i, k, work;
+	volatile size_t v = 0;
+	for (i = begin; i < end; i++) {
+		work = iteration_work(p, i);
+		for (k = 0; k < work; k++)
+			v = v + k;
+	}
+	__atomic_add_fetch(&p->n, end - begin, __ATOMIC_RELAXED);
+}
+
+struct chunk_task {
+	struct loop_param *p;
+	size_t begin;
+	size_t end;
+};
+
+static void chunk_run(void *arg) {
+	struct chunk_task *t = (struct chunk_task *) arg;
+	loop_body(t->p, t->begin, t->end);
+}
+
+/* hand-written chunking: one task per chunk, global wait */
+static void manual_for(executor_t ex, struct loop_param *p, struct chunk_task *tasks, size_t chunks) {
+	size_t i, chunk = (ITERATIONS + chunks - 1) / chunks;
+	for (i = 0; i < chunks; i++) {
+		tasks[i].p = p;
+		tasks[i].begin = i * chunk;
+		tasks[i].end = tasks[i].begin + chunk < ITERATIONS ? tasks[i].begin + chunk : ITERATIONS;
+		while (executor_submit(ex, chunk_run, &tasks[i]) != 0) {
+		}
+	}
+	executor_wait(ex);
+}
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+static executor_t executor_new(const char *name) {
+	if (strcmp(name, "thpool") == 0)
+		return executor_thpool(thpool_create(WORKERS, QUEUE_SIZE), 1);
+	if (strcmp(name, "lfthpool") == 0)
+		return executor_lfthpool(lfthpool_create(WORKERS, QUEUE_SIZE), 1);
+	return NULL;
+}
+
+static void bench(const char *name, const char *mode, int skewed) {
+	executor_t ex;
+	struct loop_param p;
+	struct chunk_task *tasks;
+	uint64_t start, duration;
+	size_t r, chunks = WORKERS;
+
+	if ((ex = executor_new(name)) == NULL) {
+		fprintf(stderr, "%s: %s\n", name, strerror(errno));
+		exit(1);
+	}
+	tasks = (struct chunk_task *) malloc(chunks * sizeof(struct chunk_task));
+	p.skewed = skewed;
+	p.n = 0;
+
+	start = getCurrentTime();
+	for (r = 0; r < REPEAT; r++) {
+		if (strcmp(mode, "manual") == 0) {
+			manual_for(ex, &p, tasks, chunks);
+		} else if (parallel_for(ex, 0, ITERATIONS, 16, loop_body, &p) != 0) {
+			fprintf(stderr, "parallel_for: %s\n", strerror(errno));
+			exit(1);
+		}
+	}
+	duration = getCurrentTime() - start;
+	if (duration == 0)
+		duration = 1;
+
+	executor_destroy(ex);
+	free(tasks);
+	printf("%-10s %-12s %-8s %llu workers, %llu iterations, work %llu (%f ms, %llu ns/iteration) ",
+		name, mode, skewed ? "skewed" : "uniform",
+		(unsigned long long) WORKERS, (unsigned long long) ITERATIONS, (unsigned long long) WORK,
+		(double) duration / 1000 / (double) REPEAT,
+		(unsigned long long) duration * 1000 / (ITERATIONS * REPEAT)
+	);
+	if (p.n != ITERATIONS * REPEAT) {
+		ret++;
+		printf("[ERR]: %llu != %llu\n", (unsigned long long) p.n, (unsigned long long) ITERATIONS * REPEAT);
+	} else {
+		printf("[OK]\n");
+	}
+}
+
+static size_t env_size(const char *name, size_t def) {
+	char *s = getenv(name);
+	unsigned long c;
+	if (s) {
+		c = strtoul(s, NULL, 10);
+		if (c > 0)
+			return (size_t) c;
+	}
+	return def;
+}
+
+int main(int argc, char *argv[]) {
+	const char *executors[] = { "thpool", "lfthpool" };
+	const char *modes[] = { "manual", "parallel_for" };
+	size_t e, m;
+	int skewed, i;
+
+	ITERATIONS = env_size("ITERATIONS", ITERATIONS);
+	WORKERS = env_size("WORKERS", WORKERS);
+	QUEUE_SIZE = env_size("QUEUE_SIZE", QUEUE_SIZE);
+	WORK = env_size("WORK", WORK);
+	REPEAT = env_size("REPEAT", REPEAT);
+
+	for (skewed = 0; skewed < 2; skewed++) {
+		for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+			if (argc > 1) {
+				/* executors from command line */
+				for (i = 1; i < argc; i++) {
+					bench(argv[i], modes[m], skewed);
+				}
+			} else {
+				for (e = 0; e < sizeof(executors) / sizeof(executors[0]); e++) {
+					bench(executors[e], modes[m], skewed);
+				}
+			}
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,189 @@
+/*
+ * parallel_sort, parallel_exclusive_scan, parallel_memcpy, parallel_memset
+ * vs serial (qsort, loop, memcpy, memset) with 1, 2, 4, 8, 16 workers
+ */
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <threads/parallel.h>
+
+size_t SORT_SIZE = 1000000; /* ints */
+size_t SCAN_SIZE = 4000000; /* size_t */
+size_t MEM_SIZE = 64 * 1024 * 1024; /* bytes */
+size_t QUEUE_SIZE = 1024;
+size_t REPEAT = 5;
+
+int ret = 0;
+
+static int *sort_src, *sort_buf;
+static size_t *scan_in, *scan_out;
+static char *mem_src, *mem_dst;
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+static int int_cmp(const void *a, const void *b) {
+	int x = *(const int *) a, y = *(const int *) b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static executor_t executor_new(const char *name, size_t workers) {
+	if (strcmp(name, "thpool") == 0)
+		return executor_thpool(thpool_create(workers, QUEUE_SIZE), 1);
+	if (strcmp(name, "lfthpool") == 0)
+		return executor_lfthpool(lfthpool_create(workers, QUEUE_SIZE), 1);
+	return NULL;
+}
+
+/* run kernel once, ex NULL - serial baseline */
+static int kernel_run(const char *kernel, executor_t ex) {
+	size_t total, i;
+	if (strcmp(kernel, "sort") == 0) {
+		memcpy(sort_buf, sort_src, SORT_SIZE * sizeof(int));
+		if (ex == NULL) {
+			qsort(sort_buf, SORT_SIZE, sizeof(int), int_cmp);
+		} else if (parallel_sort(ex, sort_buf, SORT_SIZE, sizeof(int), int_cmp) != 0) {
+			return -1;
+		}
+		for (i = 1; i < SORT_SIZE; i++) {
+			if (sort_buf[i - 1] > sort_buf[i])
+				return -1;
+		}
+	} else if (strcmp(kernel, "scan") == 0) {
+		if (ex == NULL) {
+			for (i = 0, total = 0; i < SCAN_SIZE; i++) {
+				scan_out[i] = total;
+				total += scan_in[i];
+			}
+		} else if (parallel_exclusive_scan(ex, scan_in, scan_out, SCAN_SIZE, 0, &total) != 0) {
+			return -1;
+		}
+		if (SCAN_SIZE > 0 && scan_out[SCAN_SIZE - 1] + scan_in[SCAN_SIZE - 1] != total)
+			return -1;
+	} else if (strcmp(kernel, "memcpy") == 0) {
+		if (ex == NULL)
+			memcpy(mem_dst, mem_src, MEM_SIZE);
+		else
+			parallel_memcpy(ex, mem_dst, mem_src, MEM_SIZE);
+	} else if (strcmp(kernel, "memset") == 0) {
+		if (ex == NULL)
+			memset(mem_dst, 1, MEM_SIZE);
+		else
+			parallel_memset(ex, mem_dst, 1, MEM_SIZE);
+	}
+	return 0;
+}
+
+/* time of kernel (us), sort time include copy of unsorted array */
+static uint64_t kernel_time(const char *kernel, executor_t ex) {
+	uint64_t start, duration;
+	size_t r;
+	start = getCurrentTime();
+	for (r = 0; r < REPEAT; r++) {
+		if (kernel_run(kernel, ex) != 0) {
+			ret++;
+			printf("%s: [ERR]: %s\n", kernel, errno ? strerror(errno) : "invalid result");
+			break;
+		}
+	}
+	duration = (getCurrentTime() - start) / REPEAT;
+	return duration == 0 ? 1 : duration;
+}
+
+static void bench(const char *name, const char *kernel, uint64_t serial) {
+	const size_t workers[] = { 1, 2, 4, 8, 16 };
+	executor_t ex;
+	uint64_t duration;
+	size_t w;
+
+	for (w = 0; w < sizeof(workers) / sizeof(workers[0]); w++) {
+		if ((ex = executor_new(name, workers[w])) == NULL) {
+			fprintf(stderr, "%s: %s\n", name, strerror(errno));
+			exit(1);
+		}
+		duration = kernel_time(kernel, ex);
+		executor_destroy(ex);
+		printf("%-10s %-8s %2llu workers (%f ms, speedup %.2f)\n",
+			name, kernel, (unsigned long long) workers[w],
+			(double) duration / 1000, (double) serial / (double) duration
+		);
+	}
+}
+
+static size_t env_size(const char *name, size_t def) {
+	char *s = getenv(name);
+	unsigned long c;
+	if (s) {
+		c = strtoul(s, NULL, 10);
+		if (c > 0)
+			return (size_t) c;
+	}
+	return def;
+}
+
+int main(int argc, char *argv[]) {
+	const char *executors[] = { "thpool", "lfthpool" };
+	const char *kernels[] = { "sort", "scan", "memcpy", "memset" };
+	uint64_t serial;
+	size_t e, k, i;
+	int a;
+
+	SORT_SIZE = env_size("SORT_SIZE", SORT_SIZE);
+	SCAN_SIZE = env_size("SCAN_SIZE", SCAN_SIZE);
+	MEM_SIZE = env_size("MEM_SIZE", MEM_SIZE);
+	QUEUE_SIZE = env_size("QUEUE_SIZE", QUEUE_SIZE);
+	REPEAT = env_size("REPEAT", REPEAT);
+
+	sort_src = (int *) malloc(SORT_SIZE * sizeof(int));
+	sort_buf = (int *) malloc(SORT_SIZE * sizeof(int));
+	scan_in = (size_t *) malloc(SCAN_SIZE * sizeof(size_t));
+	scan_out = (size_t *) malloc(SCAN_SIZE * sizeof(size_t));
+	mem_src = (char *) malloc(MEM_SIZE);
+	mem_dst = (char *) malloc(MEM_SIZE);
+	if (sort_src == NULL || sort_buf == NULL || scan_in == NULL || scan_out == NULL ||
+			mem_src == NULL || mem_dst == NULL) {
+		fprintf(stderr, "malloc: %s\n", strerror(errno));
+		return 1;
+	}
+	srand(1);
+	for (i = 0; i < SORT_SIZE; i++)
+		sort_src[i] = rand();
+	for (i = 0; i < SCAN_SIZE; i++)
+		scan_in[i] = i % 13;
+	memset(mem_src, 2, MEM_SIZE);
+	memset(mem_dst, 0, MEM_SIZE);
+
+	for (k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+		serial = kernel_time(kernels[k], NULL);
+		printf("%-10s %-8s (%f ms)\n", "serial", kernels[k], (double) serial / 1000);
+		if (argc > 1) {
+			/* executors from command line */
+			for (a = 1; a < argc; a++) {
+				bench(argv[a], kernels[k], serial);
+			}
+		} else {
+			for (e = 0; e < sizeof(executors) / sizeof(executors[0]); e++) {
+				bench(executors[e], kernels[k], serial);
+			}
+		}
+	}
+
+	free(sort_src);
+	free(sort_buf);
+	free(scan_in);
+	free(scan_out);
+	free(mem_src);
+	free(mem_dst);
+	return ret;
+}
@@ -0,0 +1,286 @@
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/parallel.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define N 100000
+
+struct for_param {
+	unsigned char *marks;
+	size_t chunks;
+	size_t errors;
+};
+
+static void mark_fn(void *ctx, size_t begin, size_t end) {
+	struct for_param *p = (struct for_param *) ctx;
+	size_t i;
+	__atomic_add_fetch(&p->chunks, 1, __ATOMIC_RELAXED);
+	for (i = begin; i < end; i++) {
+		if (__atomic_add_fetch(&p->marks[i], 1, __ATOMIC_RELAXED) != 1)
+			__atomic_add_fetch(&p->errors, 1, __ATOMIC_RELAXED);
+	}
+}
+
+static void sum_fn(void *ctx, size_t begin, size_t end, void *acc) {
+	uint64_t *sum = (uint64_t *) acc;
+	size_t i;
+	(void) ctx;
+	for (i = begin; i < end; i++)
+		*sum += i;
+}
+
+static void sum_join(void *ctx, void *result, const void *acc) {
+	(void) ctx;
+	*(uint64_t *) result += *(const uint64_t *) acc;
+}
+
+static void check_for(executor_t ex, size_t begin, size_t end, size_t grain) {
+	struct for_param p;
+	size_t i, bad = 0;
+
+	memset(&p, 0, sizeof(p));
+	p.marks = (unsigned char *) calloc(N, 1);
+	ASSERT_NOT_NULL(p.marks);
+	ASSERT_EQUAL(0, parallel_for(ex, begin, end, grain, mark_fn, &p));
+	ASSERT_EQUAL_U(0, p.errors);
+	for (i = 0; i < N; i++) {
+		if (p.marks[i] != (i >= begin && i < end ? 1 : 0))
+			bad++;
+	}
+	ASSERT_EQUAL_U(0, bad);
+	if (grain > 0 && end > begin)
+		ASSERT_TRUE(p.chunks <= (end - begin + grain - 1) / grain);
+	free(p.marks);
+}
+
+static void check_reduce(executor_t ex, size_t begin, size_t end, size_t grain) {
+	uint64_t sum = 0, expected = 0;
+	size_t i;
+	for (i = begin; i < end; i++)
+		expected += i;
+	ASSERT_EQUAL(0, parallel_reduce(ex, begin, end, grain, sum_fn, sum_join, NULL, &sum, sizeof(sum)));
+	ASSERT_EQUAL_U(expected, sum);
+}
+
+static void check_executor(executor_t ex) {
+	ASSERT_NOT_NULL(ex);
+	check_for(ex, 0, N, 0);
+	check_for(ex, 0, N, 1000);
+	check_for(ex, 10, N - 10, 7);
+	check_for(ex, 5, 5, 1);
+	check_for(ex, 0, 1, 1);
+	check_for(ex, 0, 100, 1000);
+	check_reduce(ex, 0, N, 0);
+	check_reduce(ex, 1, N, 100);
+	check_reduce(ex, 3, 3, 1);
+	executor_destroy(ex);
+}
+
+CTEST(parallel, thpool) {
+	check_executor(executor_thpool(thpool_create(4, 16), 1));
+}
+
+CTEST(parallel, lfthpool) {
+	check_executor(executor_lfthpool(lfthpool_create(4, 16), 1));
+}
+
+CTEST(parallel, inline) {
+	check_executor(executor_inline());
+}
+
+CTEST(parallel, caller_runs) {
+	/* queue is too small for all helpers */
+	check_executor(executor_caller_runs(executor_thpool(thpool_create(4, 2), 1)));
+}
+
+CTEST(parallel, caller) {
+	check_for(NULL, 0, N, 0);
+	check_reduce(NULL, 0, N, 0);
+}
+
+struct nested_param {
+	executor_t ex;
+	uint64_t sums[8];
+};
+
+static void nested_fn(void *ctx, size_t begin, size_t end) {
+	struct nested_param *p = (struct nested_param *) ctx;
+	size_t i;
+	/* nested loop in pool worker: worker participate, so all workers can be busy */
+	for (i = begin; i < end; i++) {
+		p->sums[i] = 0;
+		if (parallel_reduce(p->ex, 0, N, 100, sum_fn, sum_join, NULL, &p->sums[i], sizeof(uint64_t)) != 0)
+			p->sums[i] = 0;
+	}
+}
+
+CTEST(parallel, nested) {
+	struct nested_param p;
+	uint64_t expected = (uint64_t) N * (N - 1) / 2;
+	size_t i;
+
+	p.ex = executor_lfthpool(lfthpool_create(2, 16), 1);
+	ASSERT_NOT_NULL(p.ex);
+	ASSERT_EQUAL(0, parallel_for(p.ex, 0, 8, 1, nested_fn, &p));
+	for (i = 0; i < 8; i++) {
+		ASSERT_EQUAL_U(expected, p.sums[i]);
+	}
+	executor_destroy(p.ex);
+}
+
+struct rec {
+	uint32_t key;
+	uint32_t v[2];
+};
+
+static int int_cmp(const void *a, const void *b) {
+	int x = *(const int *) a, y = *(const int *) b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static int rec_cmp(const void *a, const void *b) {
+	uint32_t x = ((const struct rec *) a)->key, y = ((const struct rec *) b)->key;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void check_sort(executor_t ex, size_t n, int mod) {
+	static int empty[1];
+	int *a;
+	long long sum = 0, sorted_sum = 0;
+	size_t i, bad = 0;
+
+	if (n == 0) {
+		/* malloc(0) may return NULL */
+		ASSERT_EQUAL(0, parallel_sort(ex, empty, 0, sizeof(int), int_cmp));
+		return;
+	}
+	a = (int *) calloc(n, sizeof(int));
+	ASSERT_NOT_NULL(a);
+	srand((unsigned int) n);
+	for (i = 0; i < n; i++) {
+		a[i] = mod ? rand() % mod : (int) (n - i);
+		sum += a[i];
+	}
+	ASSERT_EQUAL(0, parallel_sort(ex, a, n, sizeof(int), int_cmp));
+	for (i = 0; i < n; i++) {
+		if (i > 0 && a[i - 1] > a[i])
+			bad++;
+		sorted_sum += a[i];
+	}
+	ASSERT_EQUAL_U(0, bad);
+	ASSERT_TRUE(sum == sorted_sum);
+	free(a);
+}
+
+static void check_kernels(executor_t ex) {
+	size_t n = 3 * 256 * 1024 + 17, i, total, bad = 0;
+	struct rec *r;
+	size_t *in, *out;
+	char *src, *dst;
+
+	check_sort(ex, 0, 10);
+	check_sort(ex, 100, 10);
+	check_sort(ex, N, 0);
+	check_sort(ex, N + 13, 100);
+	check_sort(ex, 3 * N + 1, 1000000);
+
+	/* 12 bytes elements */
+	r = (struct rec *) malloc(N * sizeof(struct rec));
+	ASSERT_NOT_NULL(r);
+	for (i = 0; i < N; i++) {
+		r[i].key = (uint32_t) ((i * 2654435761U) % 1000);
+		r[i].v[0] = r[i].key;
+		r[i].v[1] = (uint32_t) i;
+	}
+	ASSERT_EQUAL(0, parallel_sort(ex, r, N, sizeof(struct rec), rec_cmp));
+	for (i = 0; i < N; i++) {
+		if ((i > 0 && r[i - 1].key > r[i].key) || r[i].v[0] != r[i].key)
+			bad++;
+	}
+	ASSERT_EQUAL_U(0, bad);
+	free(r);
+
+	/* scan (also in place) */
+	in = (size_t *) malloc(N * sizeof(size_t));
+	out = (size_t *) malloc(N * sizeof(size_t));
+	ASSERT_NOT_NULL(in);
+	ASSERT_NOT_NULL(out);
+	for (i = 0; i < N; i++)
+		in[i] = i % 7;
+	ASSERT_EQUAL(0, parallel_exclusive_scan(ex, in, out, N, 5, &total));
+	for (i = 0, total = 5; i < N; i++) {
+		if (out[i] != total)
+			bad++;
+		total += in[i];
+	}
+	ASSERT_EQUAL_U(0, bad);
+	ASSERT_EQUAL(0, parallel_exclusive_scan(ex, in, in, N, 0, &i));
+	ASSERT_EQUAL_U(total - 5, i);
+	for (i = 0; i < N; i++) {
+		if (in[i] != out[i] - 5)
+			bad++;
+	}
+	ASSERT_EQUAL_U(0, bad);
+	ASSERT_EQUAL(0, parallel_exclusive_scan(ex, in, out, 0, 3, &total));
+	ASSERT_EQUAL_U(3, total);
+	free(in);
+	free(out);
+
+	/* copy, fill */
+	src = (char *) malloc(n);
+	dst = (char *) malloc(n);
+	ASSERT_NOT_NULL(src);
+	ASSERT_NOT_NULL(dst);
+	parallel_memset(ex, src, 0x5a, n);
+	for (i = 0; i < n; i++) {
+		if (src[i] != 0x5a)
+			bad++;
+		src[i] = (char) i;
+	}
+	ASSERT_EQUAL_U(0, bad);
+	parallel_memcpy(ex, dst, src, n);
+	ASSERT_EQUAL(0, memcmp(src, dst, n));
+	parallel_memcpy(ex, dst, src + 1, 100);
+	ASSERT_EQUAL(0, memcmp(src + 1, dst, 100));
+	free(src);
+	free(dst);
+}
+
+CTEST(parallel, kernels_thpool) {
+	executor_t ex = executor_thpool(thpool_create(4, 16), 1);
+	ASSERT_NOT_NULL(ex);
+	check_kernels(ex);
+	executor_destroy(ex);
+}
+
+CTEST(parallel, kernels_lfthpool) {
+	executor_t ex = executor_lfthpool(lfthpool_create(3, 16), 1);
+	ASSERT_NOT_NULL(ex);
+	check_kernels(ex);
+	executor_destroy(ex);
+}
+
+CTEST(parallel, kernels_caller) {
+	check_kernels(NULL);
+}
+
+CTEST(parallel, invalid) {
+	uint64_t sum = 0;
+	ASSERT_EQUAL(-1, parallel_for(NULL, 0, 10, 1, NULL, NULL));
+	ASSERT_EQUAL(EINVAL, errno);
+	ASSERT_EQUAL(-1, parallel_reduce(NULL, 0, 10, 1, sum_fn, NULL, NULL, &sum, sizeof(sum)));
+	ASSERT_EQUAL(EINVAL, errno);
+}
+
+int main(int argc, const char *argv[]) {
+	return ctest_main(argc, argv);
+}
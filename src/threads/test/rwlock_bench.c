@@ -0,0 +1,171 @@
+/*
+ * Read-side scaling of read-write locks (read-mostly config lookup)
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <threads/rwlock.h>
+#include <threads/brlock.h>
+#include <threads/seqlock.h>
+
+#include <pthread.h>
+#if NO_PTHREAD_BARRIER
+#include "pthread_barrier.h"
+#endif
+
+size_t LOOP_COUNT = 10000000;
+
+int ret = 0;
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+enum lock_type {
+	LOCK_PTHREAD_RWLOCK,
+	LOCK_RWLOCK,
+	LOCK_BRLOCK,
+	LOCK_SEQLOCK
+};
+
+static const char *lock_names[] = { "pthread_rwlock", "rwlock", "brlock", "seqlock" };
+
+struct config {
+	size_t a;
+	size_t b;
+	size_t c;
+	size_t d;
+};
+
+struct task_param {
+	enum lock_type type;
+	size_t loop_count;
+	size_t errors;
+	pthread_rwlock_t prw;
+	rwlock_t rw;
+	brlock_t br;
+	seqlock_t seq;
+	struct config cfg;
+	pthread_barrier_t start_barrier;
+};
+
+static void *read_thread(void *p){
+	size_t i, slot;
+	struct config c;
+	struct task_param *param = (struct task_param *) p;
+	pthread_barrier_wait(&param->start_barrier);
+	for (i = 0; i < param->loop_count; i++) {
+		switch (param->type) {
+		case LOCK_PTHREAD_RWLOCK:
+			pthread_rwlock_rdlock(&param->prw);
+			c = param->cfg;
+			pthread_rwlock_unlock(&param->prw);
+			break;
+		case LOCK_RWLOCK:
+			rwlock_rdlock(&param->rw);
+			c = param->cfg;
+			rwlock_rdunlock(&param->rw);
+			break;
+		case LOCK_BRLOCK:
+			slot = brlock_rdlock(&param->br);
+			c = param->cfg;
+			brlock_rdunlock(&param->br, slot);
+			break;
+		default:
+			seqlock_read(&param->seq, &c, &param->cfg, sizeof(c));
+		}
+		if (c.a != c.d) {
+			__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+		}
+	}
+	return NULL;
+}
+
+void bench(enum lock_type type, size_t readers, size_t loop_count) {
+	size_t i;
+	uint64_t start, end, duration;
+	struct task_param param;
+	int perr;
+	pthread_attr_t thr_attr;
+	pthread_t *t_handles;
+
+	memset(&param, 0, sizeof(param));
+	param.type = type;
+	param.loop_count = loop_count / readers;
+	param.cfg.a = param.cfg.d = 1;
+	pthread_rwlock_init(&param.prw, NULL);
+	rwlock_init(&param.rw, 100);
+	brlock_init(&param.br, 0);
+	seqlock_init(&param.seq);
+
+	pthread_barrier_init(&param.start_barrier, NULL, (unsigned int) readers + 1);
+
+	pthread_attr_init(&thr_attr);
+	pthread_attr_setdetachstate(&thr_attr, PTHREAD_CREATE_JOINABLE);
+	t_handles = (pthread_t *) malloc(readers * sizeof(pthread_t));
+	for (i = 0; i < readers; i++) {
+		perr = pthread_create(&t_handles[i], &thr_attr, read_thread, &param);
+        if (perr) {
+			fprintf(stderr, "%s\n", strerror(perr));
+			exit(1);
+		}
+	}
+
+	pthread_barrier_wait(&param.start_barrier);
+	start = getCurrentTime();
+
+	for (i = 0; i < readers; i++) {
+		pthread_join(t_handles[i], NULL);
+	}
+
+	end = getCurrentTime();
+
+	free(t_handles);
+	pthread_barrier_destroy(&param.start_barrier);
+	pthread_rwlock_destroy(&param.prw);
+	rwlock_destroy(&param.rw);
+	brlock_destroy(&param.br);
+
+	duration = end - start;
+	if (duration == 0) {
+		duration = 1;
+	}
+	if (param.errors) {
+		ret++;
+	}
+	printf("%s, %llu readers (%f ms, %lu iterations, %llu ns/op, %llu op/s) [%s]\n",
+		lock_names[type], (unsigned long long) readers,
+		((double) end - (double) start) / 1000,
+		(unsigned long) loop_count,
+		(unsigned long long) duration * 1000 / loop_count,
+		(unsigned long long) 1000000 * loop_count / duration,
+		param.errors == 0 ? "OK" : "ERR");
+}
+
+int main() {
+	size_t readers;
+	int type;
+	char *COUNT_STR = getenv("LOOP_COUNT");
+	if (COUNT_STR) {
+		unsigned long c = strtoul(COUNT_STR, NULL, 10);
+		if (c > 0) {
+			LOOP_COUNT = c;
+		}
+	}
+	for (type = LOCK_PTHREAD_RWLOCK; type <= LOCK_SEQLOCK; type++) {
+		for (readers = 1; readers <= 64; readers *= 2) {
+			bench((enum lock_type) type, readers, LOOP_COUNT);
+		}
+	}
+	return ret;
+}
@@ -0,0 +1,172 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/rwlock.h>
+#include <threads/brlock.h>
+#include <threads/seqlock.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define THREADS 4
+#define LOOPS 20000
+
+struct lock_param {
+	rwlock_t rw;
+	brlock_t br;
+	size_t a;
+	size_t b;
+	size_t errors;
+};
+
+static void *rwlock_thread(void *p) {
+	struct lock_param *param = (struct lock_param *) p;
+	size_t i;
+	for (i = 0; i < LOOPS; i++) {
+		if (i % 8 == 0) {
+			rwlock_wrlock(&param->rw);
+			param->a++;
+			param->b++;
+			rwlock_wrunlock(&param->rw);
+		} else {
+			rwlock_rdlock(&param->rw);
+			if (param->a != param->b)
+				__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+			rwlock_rdunlock(&param->rw);
+		}
+	}
+	return NULL;
+}
+
+CTEST(rwlock, try) {
+	rwlock_t l;
+	rwlock_init(&l, 10);
+	ASSERT_EQUAL(0, rwlock_tryrdlock(&l));
+	ASSERT_EQUAL(0, rwlock_tryrdlock(&l));
+	ASSERT_EQUAL(-1, rwlock_trywrlock(&l));
+	rwlock_rdunlock(&l);
+	rwlock_rdunlock(&l);
+	ASSERT_EQUAL(0, rwlock_trywrlock(&l));
+	ASSERT_EQUAL(-1, rwlock_tryrdlock(&l));
+	ASSERT_EQUAL(-1, rwlock_trywrlock(&l));
+	rwlock_wrunlock(&l);
+	ASSERT_EQUAL_U(0, l.state);
+	rwlock_destroy(&l);
+}
+
+CTEST(rwlock, threads) {
+	struct lock_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	rwlock_init(&param.rw, 100);
+	for (i = 0; i < THREADS; i++) {
+		ASSERT_EQUAL(0, pthread_create(&t[i], NULL, rwlock_thread, &param));
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_EQUAL_U(THREADS * LOOPS / 8, param.a);
+	ASSERT_EQUAL_U(0, param.rw.state);
+	rwlock_destroy(&param.rw);
+}
+
+static void *brlock_thread(void *p) {
+	struct lock_param *param = (struct lock_param *) p;
+	size_t i, slot;
+	for (i = 0; i < LOOPS; i++) {
+		if (i % 64 == 0) {
+			brlock_wrlock(&param->br);
+			param->a++;
+			param->b++;
+			brlock_wrunlock(&param->br);
+		} else {
+			slot = brlock_rdlock(&param->br);
+			if (param->a != param->b)
+				__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+			brlock_rdunlock(&param->br, slot);
+		}
+	}
+	return NULL;
+}
+
+CTEST(brlock, threads) {
+	struct lock_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	ASSERT_EQUAL(0, brlock_init(&param.br, 0));
+	for (i = 0; i < THREADS; i++) {
+		ASSERT_EQUAL(0, pthread_create(&t[i], NULL, brlock_thread, &param));
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_EQUAL_U(THREADS * ((LOOPS + 63) / 64), param.a);
+	brlock_destroy(&param.br);
+}
+
+struct snapshot {
+	size_t a;
+	size_t b;
+	char s[13];
+};
+
+struct seq_param {
+	seqlock_t l;
+	struct snapshot data;
+	int stop;
+	size_t errors;
+};
+
+static void *seqlock_reader(void *p) {
+	struct seq_param *param = (struct seq_param *) p;
+	struct snapshot snap;
+	while (!__atomic_load_n(&param->stop, __ATOMIC_ACQUIRE)) {
+		seqlock_read(&param->l, &snap, &param->data, sizeof(snap));
+		if (snap.a != snap.b || (size_t) snap.s[0] != snap.a % 128)
+			__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+	}
+	return NULL;
+}
+
+CTEST(seqlock, threads) {
+	struct seq_param param;
+	struct snapshot snap;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	seqlock_init(&param.l);
+	for (i = 0; i < THREADS; i++) {
+		ASSERT_EQUAL(0, pthread_create(&t[i], NULL, seqlock_reader, &param));
+	}
+	memset(&snap, 0, sizeof(snap));
+	for (i = 1; i <= LOOPS; i++) {
+		snap.a = i;
+		snap.b = i;
+		memset(snap.s, (int) (i % 128), sizeof(snap.s));
+		seqlock_write(&param.l, &param.data, &snap, sizeof(snap));
+	}
+	__atomic_store_n(&param.stop, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_EQUAL_U(LOOPS, param.data.a);
+	ASSERT_EQUAL_U(2 * LOOPS, param.l.seq);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,119 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/spsc_ring.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define LOOPS 100000
+#define BATCH 7
+
+struct ring_param {
+	spsc_ring_t r;
+	size_t sum;
+	size_t count;
+};
+
+static void *producer_thread(void *p) {
+	struct ring_param *param = (struct ring_param *) p;
+	void *items[BATCH];
+	size_t i = 1, j, n, pushed;
+	while (i <= LOOPS) {
+		n = LOOPS + 1 - i < BATCH ? LOOPS + 1 - i : BATCH;
+		for (j = 0; j < n; j++) {
+			items[j] = (void *) (uintptr_t) (i + j);
+		}
+		if ((pushed = spsc_ring_push_batch(&param->r, items, n)) == 0) {
+			/* wait for free slot */
+			spsc_ring_push_wait(&param->r, items[0]);
+			pushed = 1;
+		}
+		i += pushed;
+	}
+	return NULL;
+}
+
+static void *consumer_thread(void *p) {
+	struct ring_param *param = (struct ring_param *) p;
+	void *items[BATCH];
+	size_t i, n, expected = 1;
+	while (param->count < LOOPS) {
+		n = spsc_ring_pop_wait(&param->r, items, BATCH, 0);
+		for (i = 0; i < n; i++) {
+			/* FIFO order */
+			if ((uintptr_t) items[i] != expected)
+				abort();
+			expected++;
+			param->sum += (uintptr_t) items[i];
+		}
+		param->count += n;
+	}
+	return NULL;
+}
+
+CTEST(spsc_ring, basic) {
+	spsc_ring_t r;
+	void *items[4] = { (void *) 1, (void *) 2, (void *) 3, (void *) 4 };
+	void *out[4];
+
+	ASSERT_EQUAL(0, spsc_ring_init(&r, 3, 0));
+	ASSERT_EQUAL_U(4, spsc_ring_size(&r));
+	ASSERT_NULL(spsc_ring_pop(&r));
+	ASSERT_EQUAL(0, spsc_ring_push(&r, items[0]));
+	ASSERT_EQUAL_U(3, spsc_ring_push_batch(&r, &items[1], 3));
+	ASSERT_EQUAL_U(4, spsc_ring_len(&r));
+	/* full */
+	ASSERT_EQUAL(-1, spsc_ring_push(&r, items[0]));
+	ASSERT_EQUAL_U(0, spsc_ring_push_batch(&r, items, 2));
+
+	ASSERT_TRUE(spsc_ring_pop(&r) == items[0]);
+	ASSERT_EQUAL_U(3, spsc_ring_pop_batch(&r, out, 4));
+	ASSERT_TRUE(out[0] == items[1]);
+	ASSERT_TRUE(out[2] == items[3]);
+	ASSERT_EQUAL_U(0, spsc_ring_len(&r));
+
+	/* wrap */
+	ASSERT_EQUAL_U(4, spsc_ring_push_batch(&r, items, 4));
+	ASSERT_EQUAL_U(2, spsc_ring_pop_batch(&r, out, 2));
+	ASSERT_EQUAL_U(2, spsc_ring_push_batch(&r, items, 4));
+	ASSERT_EQUAL_U(4, spsc_ring_pop_batch(&r, out, 4));
+	ASSERT_TRUE(out[0] == items[2]);
+	ASSERT_TRUE(out[3] == items[1]);
+	spsc_ring_destroy(&r);
+}
+
+CTEST(spsc_ring, timeout) {
+	spsc_ring_t r;
+	void *out;
+	ASSERT_EQUAL(0, spsc_ring_init(&r, 2, SPSC_RING_BLOCKING));
+	ASSERT_EQUAL_U(0, spsc_ring_pop_wait(&r, &out, 1, 1000));
+	ASSERT_EQUAL(ETIMEDOUT, errno);
+	spsc_ring_destroy(&r);
+}
+
+CTEST(spsc_ring, threads) {
+	struct ring_param param;
+	pthread_t p, c;
+
+	memset(&param, 0, sizeof(param));
+	ASSERT_EQUAL(0, spsc_ring_init(&param.r, 16, SPSC_RING_BLOCKING));
+	pthread_create(&c, NULL, consumer_thread, &param);
+	pthread_create(&p, NULL, producer_thread, &param);
+	pthread_join(p, NULL);
+	pthread_join(c, NULL);
+	ASSERT_EQUAL_U(LOOPS, param.count);
+	ASSERT_EQUAL_U((size_t) LOOPS * (LOOPS + 1) / 2, param.sum);
+	spsc_ring_destroy(&param.r);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
@@ -0,0 +1,121 @@
+/*
+ * Cost of barrier round (bulk-synchronous compute loop)
+ */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include <threads/tbarrier.h>
+
+#include <pthread.h>
+#if NO_PTHREAD_BARRIER
+#include "pthread_barrier.h"
+#endif
+
+size_t LOOP_COUNT = 100000;
+
+static uint64_t getCurrentTime(void) {
+    struct timeval now;
+    uint64_t now64;
+    gettimeofday(&now, NULL);
+    now64 = (uint64_t) now.tv_sec;
+    now64 *= 1000000;
+    now64 += ((uint64_t) now.tv_usec);
+    return now64;
+}
+
+enum barrier_type {
+	BARRIER_PTHREAD,
+	BARRIER_TBARRIER_SLEEP,
+	BARRIER_TBARRIER
+};
+
+static const char *barrier_names[] = { "pthread_barrier", "tbarrier (no spin)", "tbarrier" };
+
+struct task_param {
+	enum barrier_type type;
+	size_t loop_count;
+	pthread_barrier_t pb;
+	tbarrier_t tb;
+};
+
+static void *barrier_thread(void *p){
+	size_t i;
+	struct task_param *param = (struct task_param *) p;
+	for (i = 0; i < param->loop_count; i++) {
+		if (param->type == BARRIER_PTHREAD) {
+			pthread_barrier_wait(&param->pb);
+		} else {
+			tbarrier_wait(&param->tb);
+		}
+	}
+	return NULL;
+}
+
+void bench(enum barrier_type type, size_t threads, size_t loop_count) {
+	size_t i;
+	uint64_t start, end, duration;
+	struct task_param param;
+	int perr;
+	pthread_attr_t thr_attr;
+	pthread_t *t_handles;
+
+	memset(&param, 0, sizeof(param));
+	param.type = type;
+	param.loop_count = loop_count;
+	pthread_barrier_init(&param.pb, NULL, (unsigned int) threads);
+	tbarrier_init(&param.tb, (uint32_t) threads, type == BARRIER_TBARRIER ? TBARRIER_SPIN_USECS : 0);
+
+	pthread_attr_init(&thr_attr);
+	pthread_attr_setdetachstate(&thr_attr, PTHREAD_CREATE_JOINABLE);
+	t_handles = (pthread_t *) malloc(threads * sizeof(pthread_t));
+
+	start = getCurrentTime();
+	for (i = 0; i < threads; i++) {
+		perr = pthread_create(&t_handles[i], &thr_attr, barrier_thread, &param);
+        if (perr) {
+			fprintf(stderr, "%s\n", strerror(perr));
+			exit(1);
+		}
+	}
+	for (i = 0; i < threads; i++) {
+		pthread_join(t_handles[i], NULL);
+	}
+	end = getCurrentTime();
+
+	free(t_handles);
+	pthread_barrier_destroy(&param.pb);
+	tbarrier_destroy(&param.tb);
+
+	duration = end - start;
+	if (duration == 0) {
+		duration = 1;
+	}
+	printf("%s, %llu threads (%f ms, %lu rounds, %llu ns/round, %llu rounds/s)\n",
+		barrier_names[type], (unsigned long long) threads,
+		((double) end - (double) start) / 1000,
+		(unsigned long) loop_count,
+		(unsigned long long) duration * 1000 / loop_count,
+		(unsigned long long) 1000000 * loop_count / duration);
+}
+
+int main() {
+	size_t threads;
+	int type;
+	char *COUNT_STR = getenv("LOOP_COUNT");
+	if (COUNT_STR) {
+		unsigned long c = strtoul(COUNT_STR, NULL, 10);
+		if (c > 0) {
+			LOOP_COUNT = c;
+		}
+	}
+	for (type = BARRIER_PTHREAD; type <= BARRIER_TBARRIER; type++) {
+		for (threads = 2; threads <= 32; threads *= 2) {
+			bench((enum barrier_type) type, threads, LOOP_COUNT);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <threads/tbarrier.h>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define THREADS 4
+#define ROUNDS 2000
+
+struct barrier_param {
+	tbarrier_t b;
+	size_t n;
+	size_t serial;
+	size_t errors;
+};
+
+static void *barrier_thread(void *p) {
+	struct barrier_param *param = (struct barrier_param *) p;
+	size_t i;
+	for (i = 0; i < ROUNDS; i++) {
+		__atomic_add_fetch(&param->n, 1, __ATOMIC_RELAXED);
+		if (tbarrier_wait(&param->b) == TBARRIER_SERIAL_THREAD)
+			param->serial++;
+		/* all threads are arrived in this round */
+		if (__atomic_load_n(&param->n, __ATOMIC_RELAXED) < (i + 1) * THREADS)
+			__atomic_add_fetch(&param->errors, 1, __ATOMIC_RELAXED);
+		/* nobody leave next round before we arrive */
+		tbarrier_wait(&param->b);
+	}
+	return NULL;
+}
+
+static void run_threads(uint32_t spin_usecs) {
+	struct barrier_param param;
+	pthread_t t[THREADS];
+	size_t i;
+
+	memset(&param, 0, sizeof(param));
+	ASSERT_EQUAL(0, tbarrier_init(&param.b, THREADS, spin_usecs));
+	for (i = 0; i < THREADS; i++) {
+		pthread_create(&t[i], NULL, barrier_thread, &param);
+	}
+	for (i = 0; i < THREADS; i++) {
+		pthread_join(t[i], NULL);
+	}
+	tbarrier_destroy(&param.b);
+	ASSERT_EQUAL_U(THREADS * ROUNDS, param.n);
+	ASSERT_EQUAL_U(ROUNDS, param.serial);
+	ASSERT_EQUAL_U(0, param.errors);
+	ASSERT_EQUAL_U(0, param.b.arrived);
+	ASSERT_EQUAL_U(2 * ROUNDS, param.b.round);
+}
+
+CTEST(tbarrier, init) {
+	tbarrier_t b;
+	ASSERT_EQUAL(-1, tbarrier_init(&b, 0, 0));
+	ASSERT_EQUAL(EINVAL, errno);
+	ASSERT_EQUAL(0, tbarrier_init(&b, 1, TBARRIER_SPIN_USECS));
+	ASSERT_EQUAL(TBARRIER_SERIAL_THREAD, tbarrier_wait(&b));
+	ASSERT_EQUAL(TBARRIER_SERIAL_THREAD, tbarrier_wait(&b));
+	tbarrier_destroy(&b);
+}
+
+CTEST(tbarrier, spin) {
+	run_threads(TBARRIER_SPIN_USECS);
+}
+
+CTEST(tbarrier, sleep) {
+	run_threads(0);
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
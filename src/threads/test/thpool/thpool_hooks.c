@@ -0,0 +1,288 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <pthread.h>
+#if defined(__linux__)
+#include <linux/capability.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include <threads/thpool.h>
+
+#include <ctest.h>
+
+#define HOOKS_WORKERS 4
+#define HOOKS_TASKS 10000
+
+struct hooks_ctx {
+	size_t index;
+	size_t tasks;
+};
+
+static size_t hooks_inits;
+static size_t hooks_finis;
+static size_t hooks_tasks;
+static size_t hooks_errors;
+
+static int hooks_init(size_t index, void **ctx) {
+	struct hooks_ctx *c = (struct hooks_ctx *) calloc(1, sizeof(struct hooks_ctx));
+	if (c == NULL)
+		return ENOMEM;
+	c->index = index;
+	*ctx = c;
+	__atomic_add_fetch(&hooks_inits, 1, __ATOMIC_RELAXED);
+	return 0;
+}
+
+static int hooks_init_fail(size_t index, void **ctx) {
+	if (index == 1)
+		return EPERM;
+	return hooks_init(index, ctx);
+}
+
+static void hooks_fini(void *ctx) {
+	struct hooks_ctx *c = (struct hooks_ctx *) ctx;
+	__atomic_add_fetch(&hooks_tasks, c->tasks, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&hooks_finis, 1, __ATOMIC_RELAXED);
+	free(c);
+}
+
+static void hooks_job(void *p) {
+	const pool_worker_t *w = pool_current_worker();
+	struct hooks_ctx *c;
+	(void) p;
+	if (w == NULL || w->index >= HOOKS_WORKERS || (c = (struct hooks_ctx *) w->ctx) == NULL || c->index != w->index) {
+		__atomic_add_fetch(&hooks_errors, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	/* worker-local, no synchronization */
+	c->tasks++;
+}
+
+CTEST(thpool_hooks, test) {
+	thpool_t pool;
+	size_t i;
+
+	hooks_inits = hooks_finis = hooks_tasks = hooks_errors = 0;
+	ASSERT_NULL(pool_current_worker());
+	pool = thpool_create_hooks(HOOKS_WORKERS, 1024, hooks_init, hooks_fini);
+	ASSERT_NOT_NULL(pool);
+	/* all workers are inited before create return */
+	ASSERT_EQUAL_U(HOOKS_WORKERS, hooks_inits);
+	for (i = 0; i < HOOKS_TASKS; i++) {
+		ASSERT_EQUAL(0, thpool_add_task_try(pool, hooks_job, NULL, 100, 1000000));
+	}
+	thpool_wait(pool);
+	thpool_destroy(pool);
+	ASSERT_EQUAL_U(0, hooks_errors);
+	ASSERT_EQUAL_U(HOOKS_WORKERS, hooks_finis);
+	ASSERT_EQUAL_U(HOOKS_TASKS, hooks_tasks);
+}
+
+CTEST(thpool_hooks, init_fail) {
+	thpool_t pool;
+
+	hooks_inits = hooks_finis = 0;
+	errno = 0;
+	pool = thpool_create_hooks(HOOKS_WORKERS, 1024, hooks_init_fail, hooks_fini);
+	ASSERT_NULL(pool);
+	ASSERT_EQUAL(EPERM, errno);
+	/* fini is called only for inited workers */
+	ASSERT_EQUAL_U(HOOKS_WORKERS - 1, hooks_inits);
+	ASSERT_EQUAL_U(HOOKS_WORKERS - 1, hooks_finis);
+}
+
+static void attr_job(void *p) {
+	size_t *errors = (size_t *) p;
+#if defined(__linux__)
+	char name[16];
+	prctl(PR_GET_NAME, name, 0, 0, 0);
+	if (strcmp(name, "attr-0") != 0)
+		__atomic_add_fetch(errors, 1, __ATOMIC_RELAXED);
+	/* pinned */
+	if (sched_getcpu() != 0)
+		__atomic_add_fetch(errors, 1, __ATOMIC_RELAXED);
+#else
+	(void) errors;
+#endif
+}
+
+CTEST(thpool_hooks, attr) {
+	thpool_t pool;
+	pool_attr_t attr;
+	int cpus[] = { 0 };
+	size_t errors = 0;
+
+	pool_attr_init(&attr, 1, 16);
+	attr.stack_size = 128 * 1024;
+	attr.guard_size = 8192;
+	attr.name = "attr";
+#if defined(__linux__)
+	attr.cpus = cpus;
+	attr.cpus_count = 1;
+	attr.cpus_pin = 1;
+#else
+	(void) cpus;
+#endif
+	pool = thpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+	ASSERT_EQUAL(0, thpool_add_task(pool, attr_job, &errors));
+	thpool_wait(pool);
+	thpool_destroy(pool);
+	ASSERT_EQUAL_U(0, errors);
+
+	/* stack is too small */
+	attr.stack_size = 1;
+	errno = 0;
+	ASSERT_NULL(thpool_create_ex(&attr));
+	ASSERT_EQUAL(EINVAL, errno);
+}
+
+#if defined(__linux__)
+/* drop (or restore) CAP_SYS_NICE in calling thread (workers inherit it), returns 0 on success */
+static int cap_sys_nice(int enable) {
+	struct __user_cap_header_struct hdr;
+	struct __user_cap_data_struct data[2];
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.version = _LINUX_CAPABILITY_VERSION_3;
+	if (syscall(SYS_capget, &hdr, data) == -1)
+		return -1;
+	if (enable)
+		data[CAP_SYS_NICE / 32].effective |= data[CAP_SYS_NICE / 32].permitted & (1U << (CAP_SYS_NICE % 32));
+	else
+		data[CAP_SYS_NICE / 32].effective &= ~(1U << (CAP_SYS_NICE % 32));
+	return (int) syscall(SYS_capset, &hdr, data);
+}
+#endif
+
+CTEST(thpool_hooks, nice) {
+	thpool_t pool;
+	pool_attr_t attr;
+
+	pool_attr_init(&attr, 2, 16);
+	attr.nice = 100;
+	errno = 0;
+	ASSERT_NULL(thpool_create_ex(&attr));
+	ASSERT_EQUAL(EINVAL, errno);
+
+	/* lower priority is allowed */
+	attr.nice = 1;
+	pool = thpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+	thpool_destroy(pool);
+
+#if defined(__linux__)
+	/* raise priority without CAP_SYS_NICE: setpriority error in worker is reported */
+	ASSERT_EQUAL(0, cap_sys_nice(0));
+	attr.nice = -20;
+	errno = 0;
+	pool = thpool_create_ex(&attr);
+	ASSERT_EQUAL(0, cap_sys_nice(1));
+	ASSERT_NULL(pool);
+	ASSERT_TRUE(errno == EACCES || errno == EPERM);
+#endif
+}
+
+static void lazy_job(void *p) {
+	usleep(5000);
+	hooks_job(p);
+}
+
+CTEST(thpool_hooks, lazy) {
+	thpool_t pool;
+	pool_attr_t attr;
+	size_t i, started;
+	int n;
+
+	hooks_inits = hooks_finis = hooks_tasks = hooks_errors = 0;
+	pool_attr_init(&attr, HOOKS_WORKERS, 1024);
+	attr.min_workers = 1;
+	attr.idle_timeout_usecs = 20000;
+	attr.worker_init = hooks_init;
+	attr.worker_fini = hooks_fini;
+	pool = thpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+	ASSERT_EQUAL_U(1, hooks_inits);
+
+	/* workers are started, when queue grows */
+	for (i = 0; i < 100; i++) {
+		ASSERT_EQUAL(0, thpool_add_task(pool, lazy_job, NULL));
+	}
+	thpool_wait(pool);
+	started = __atomic_load_n(&hooks_inits, __ATOMIC_RELAXED);
+	ASSERT_TRUE(started > 1);
+	ASSERT_TRUE(started <= HOOKS_WORKERS);
+
+	/* idle workers exit down to min_workers */
+	for (n = 0; n < 200; n++) {
+		if (__atomic_load_n(&hooks_finis, __ATOMIC_RELAXED) == started - 1)
+			break;
+		usleep(10000);
+	}
+	ASSERT_EQUAL_U(started - 1, hooks_finis);
+
+	/* and restarted in free slots */
+	for (i = 0; i < 100; i++) {
+		ASSERT_EQUAL(0, thpool_add_task(pool, lazy_job, NULL));
+	}
+	thpool_wait(pool);
+	ASSERT_TRUE(hooks_inits > started);
+
+	thpool_destroy(pool);
+	ASSERT_EQUAL_U(0, hooks_errors);
+	ASSERT_EQUAL_U(hooks_inits, hooks_finis);
+	ASSERT_EQUAL_U(200, hooks_tasks);
+}
+
+struct nested_ctx {
+	thpool_t pool;
+	int done;
+	int errors;
+};
+
+static void nested_inner(void *p) {
+	struct nested_ctx *c = (struct nested_ctx *) p;
+	__atomic_store_n(&c->done, 1, __ATOMIC_RELEASE);
+}
+
+static void nested_outer(void *p) {
+	struct nested_ctx *c = (struct nested_ctx *) p;
+	int n;
+	if (thpool_add_task(c->pool, nested_inner, c) != 0) {
+		c->errors++;
+		return;
+	}
+	/* only worker is busy here, inner task need started worker */
+	for (n = 0; n < 500 && !__atomic_load_n(&c->done, __ATOMIC_ACQUIRE); n++) {
+		usleep(10000);
+	}
+	if (!__atomic_load_n(&c->done, __ATOMIC_ACQUIRE))
+		c->errors++;
+}
+
+CTEST(thpool_hooks, lazy_nested) {
+	struct nested_ctx c;
+	pool_attr_t attr;
+
+	memset(&c, 0, sizeof(c));
+	pool_attr_init(&attr, HOOKS_WORKERS, 16);
+	attr.min_workers = 1;
+	c.pool = thpool_create_ex(&attr);
+	ASSERT_NOT_NULL(c.pool);
+
+	ASSERT_EQUAL(0, thpool_add_task(c.pool, nested_outer, &c));
+	thpool_wait(c.pool);
+	ASSERT_EQUAL(0, c.errors);
+	ASSERT_EQUAL(1, c.done);
+
+	thpool_destroy(c.pool);
+}
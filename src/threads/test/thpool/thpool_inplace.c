@@ -0,0 +1,88 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdlib.h>
+
+#include <threads/thpool.h>
+
+#include <ctest.h>
+
+#define INPLACE_TASKS 10000
+
+static void inplace_job(void *p) {
+	__atomic_add_fetch((size_t *) p, 1, __ATOMIC_RELAXED);
+}
+
+CTEST(thpool_inplace, test) {
+	thpool_t pool;
+	pool_attr_t attr;
+	size_t i, size, count = 0;
+	void *mem = NULL;
+
+	pool_attr_init(&attr, 2, 1024);
+	size = thpool_inplace_size(&attr);
+	ASSERT_TRUE(size > 1024);
+	ASSERT_EQUAL(0, posix_memalign(&mem, POOL_INPLACE_ALIGN, size));
+
+	/* too small or misaligned */
+	errno = 0;
+	ASSERT_NULL(thpool_init_inplace(mem, size - 1, &attr));
+	ASSERT_EQUAL(EINVAL, errno);
+	errno = 0;
+	ASSERT_NULL(thpool_init_inplace((char *) mem + 8, size, &attr));
+	ASSERT_EQUAL(EINVAL, errno);
+
+	pool = thpool_init_inplace(mem, size, &attr);
+	ASSERT_NOT_NULL(pool);
+	ASSERT_TRUE((void *) pool == mem);
+	for (i = 0; i < INPLACE_TASKS; i++) {
+		ASSERT_EQUAL(0, thpool_add_task_try(pool, inplace_job, &count, 100, 1000000));
+	}
+	thpool_wait(pool);
+	thpool_destroy(pool);
+	ASSERT_EQUAL_U(INPLACE_TASKS, count);
+
+	/* memory can be reused */
+	pool = thpool_init_inplace(mem, size, &attr);
+	ASSERT_NOT_NULL(pool);
+	thpool_destroy(pool);
+	free(mem);
+
+	attr.queue_size = 0;
+	errno = 0;
+	ASSERT_EQUAL_U(0, thpool_inplace_size(&attr));
+	ASSERT_EQUAL(EINVAL, errno);
+}
+
+CTEST(thpool_inplace, mem_flags) {
+	thpool_t pool;
+	pool_attr_t attr;
+	size_t i, count = 0;
+
+	/* large queue (4 MiB) */
+	pool_attr_init(&attr, 2, 256 * 1024);
+	attr.mem_flags = POOL_MEM_PREFAULT | POOL_MEM_HUGEPAGE;
+	pool = thpool_create_ex(&attr);
+	ASSERT_NOT_NULL(pool);
+	for (i = 0; i < INPLACE_TASKS; i++) {
+		ASSERT_EQUAL(0, thpool_add_task_try(pool, inplace_job, &count, 100, 1000000));
+	}
+	thpool_wait(pool);
+	thpool_destroy(pool);
+	ASSERT_EQUAL_U(INPLACE_TASKS, count);
+
+	/* mlock can be restricted by RLIMIT_MEMLOCK */
+	pool_attr_init(&attr, 2, 1024);
+	attr.mem_flags = POOL_MEM_PREFAULT | POOL_MEM_LOCK;
+	errno = 0;
+	pool = thpool_create_ex(&attr);
+	if (pool == NULL) {
+		ASSERT_TRUE(errno == ENOMEM || errno == EPERM || errno == EAGAIN);
+	} else {
+		ASSERT_EQUAL(0, thpool_add_task(pool, inplace_job, &count));
+		thpool_wait(pool);
+		thpool_destroy(pool);
+		ASSERT_EQUAL_U(INPLACE_TASKS + 1, count);
+	}
+}
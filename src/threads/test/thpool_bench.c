@@ -102,7 +102,8 @@ void bench(size_t writers, size_t readers, size_t loop_count) {
 	if (param.n != loop_count * (size_t) writers) {
 		ret++;	
 	}
-	printf("thpool, %llu threads pool, %llu writers (%f ms, %lu iterations, %llu ns/op, %llu op/s) ",
+	printf("thpool (%s lock), %llu threads pool, %llu writers (%f ms, %lu iterations, %llu ns/op, %llu op/s) ",
+		thpool_lock_name(),
 		(unsigned long long) readers, (unsigned long long) writers,
 		((double) end - (double) start) / 1000,
 		(unsigned long) loop_count,
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <threads/thread_pool.hpp>
+
+#define CTEST_MAIN
+#define CTEST_SEGFAULT
+
+#include <ctest.h>
+
+#define TASKS 10000
+
+/* count operator new calls */
+static std::atomic<size_t> allocs(0);
+
+void *operator new(std::size_t size) {
+	void *p;
+	allocs.fetch_add(1, std::memory_order_relaxed);
+	if ((p = std::malloc(size ? size : 1)) == nullptr)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+	std::free(p);
+}
+
+struct captures {
+	size_t v[6]; /* 48 bytes */
+};
+
+template <class Pool>
+static void pool_submit(Pool &pool) {
+	std::atomic<size_t> count(0);
+	std::atomic<size_t> *pcount = &count;
+	captures c = { { 1, 2, 3, 4, 5, 6 } };
+	size_t i, before;
+	int sum;
+
+	/* first use of cells in thread */
+	pool.submit([] { return 1; }).get();
+
+	before = allocs.load();
+	for (i = 0; i < TASKS; i++) {
+		size_t a = 1, b = 2, d = 3, e = i;
+		/* 40 bytes of captures (pointer and 4 values) */
+		while (!pool.post([pcount, a, b, d, e] { pcount->fetch_add(a + b + d + e - e - 5, std::memory_order_relaxed); })) {
+			usleep(100);
+		}
+	}
+	c.v[0] = TASKS - 1;
+	pool.wait();
+	ASSERT_EQUAL_U(TASKS, count.load());
+	/* 48 bytes of captures */
+	sum = 0;
+	for (i = 0; i < 100; i++) {
+		threads::future<size_t> f = pool.submit([c] { return c.v[0] + c.v[5]; });
+		sum += (int) f.get();
+	}
+	ASSERT_EQUAL((int) ((TASKS - 1 + 6) * 100), sum);
+	ASSERT_EQUAL_U(before, allocs.load());
+}
+
+CTEST(thread_pool, thpool) {
+	threads::thread_pool pool(2, 1024);
+	ASSERT_EQUAL_U(2, pool.workers());
+	pool_submit(pool);
+}
+
+CTEST(thread_pool, lfthpool) {
+	threads::lf_thread_pool pool(2, 1024);
+	pool_submit(pool);
+}
+
+CTEST(thread_pool, future) {
+	threads::thread_pool pool(2, 16);
+	threads::future<std::string> s;
+	threads::future<void> v;
+	threads::future<int> e;
+	std::vector<char> big(1024, 'a');
+	int done = 0;
+
+	/* large result and callable are allocated */
+	s = pool.submit([big] { return std::string(big.begin(), big.end()); });
+	ASSERT_TRUE(s.valid());
+	ASSERT_EQUAL_U(1024, s.get().size());
+	ASSERT_FALSE(s.valid());
+
+	v = pool.submit([&done] { done = 1; });
+	v.wait();
+	ASSERT_TRUE(v.ready());
+	v.get();
+	ASSERT_EQUAL(1, done);
+
+	e = pool.submit([]() -> int { throw std::runtime_error("task error"); });
+	try {
+		e.get();
+		ASSERT_FAIL();
+	} catch (const std::runtime_error &err) {
+		ASSERT_STR("task error", err.what());
+	}
+
+	/* future is released without get */
+	pool.submit([] { return std::string(100, 'b'); });
+	pool.wait();
+}
+
+CTEST(thread_pool, queue_full) {
+	threads::thread_pool pool(1, 1);
+	std::atomic<int> count(0);
+	int i, rejected = 0;
+
+	pool.pause();
+	for (i = 0; i < 4; i++) {
+		try {
+			pool.submit([&count] { count++; });
+		} catch (const std::system_error &err) {
+			ASSERT_TRUE(err.code() == std::errc::resource_unavailable_try_again);
+			rejected++;
+		}
+	}
+	ASSERT_EQUAL(3, rejected);
+	ASSERT_FALSE(pool.post([&count] { count++; }));
+	pool.resume();
+	pool.wait();
+	ASSERT_EQUAL(1, count.load());
+}
+
+int main(int argc, const char *argv[]) {
+    return ctest_main(argc, argv);
+}
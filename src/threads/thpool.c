@@ -12,6 +12,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <errno.h>
 #include <time.h>
@@ -20,6 +21,223 @@
 #endif
 
 #include "threads/thpool.h"
+#include "threads/ebr.h"
+#include "pool_worker.h"
+
+/* ========================== QUEUE LOCK ============================ */
+
+/*
+ * Queue lock is selected at compile time with THPOOL_LOCK: pthread mutex (default),
+ * lmutex (futex benaphore), ticket or MCS spinlock.
+ * Not pthread locks are paired with futex condition (sequence counter).
+ */
+#define THPOOL_LOCK_PTHREAD 0
+#define THPOOL_LOCK_LMUTEX  1
+#define THPOOL_LOCK_TICKET  2
+#define THPOOL_LOCK_MCS     3
+
+#ifndef THPOOL_LOCK
+#define THPOOL_LOCK THPOOL_LOCK_PTHREAD
+#endif
+
+#if THPOOL_LOCK == THPOOL_LOCK_PTHREAD
+
+#define THPOOL_LOCK_NAME "pthread"
+
+typedef pthread_mutex_t thpool_lock_t;
+typedef pthread_cond_t thpool_cond_t;
+typedef int thpool_lock_node_t; /* unused */
+
+static inline int _thpool_lock_init(thpool_lock_t *l) {
+	return pthread_mutex_init(l, NULL);
+}
+
+static inline void _thpool_lock_destroy(thpool_lock_t *l) {
+	pthread_mutex_destroy(l);
+}
+
+static inline void _thpool_lock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	pthread_mutex_lock(l);
+}
+
+static inline void _thpool_unlock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	pthread_mutex_unlock(l);
+}
+
+static inline int _thpool_cond_init(thpool_cond_t *c) {
+	return pthread_cond_init(c, NULL);
+}
+
+static inline void _thpool_cond_destroy(thpool_cond_t *c) {
+	pthread_cond_destroy(c);
+}
+
+static inline void _thpool_cond_wait(thpool_cond_t *c, thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	pthread_cond_wait(c, l);
+}
+
+static inline void _thpool_cond_timed_wait(thpool_cond_t *c, thpool_lock_t *l, thpool_lock_node_t *node, uint64_t timeout_usecs) {
+	struct timespec ts;
+	(void) node;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	timeout_usecs += (uint64_t) ts.tv_nsec / 1000;
+	ts.tv_sec += (time_t) (timeout_usecs / 1000000);
+	ts.tv_nsec = (long) (timeout_usecs % 1000000) * 1000;
+	pthread_cond_timedwait(c, l, &ts);
+}
+
+static inline void _thpool_cond_signal(thpool_cond_t *c) {
+	pthread_cond_signal(c);
+}
+
+static inline void _thpool_cond_broadcast(thpool_cond_t *c) {
+	pthread_cond_broadcast(c);
+}
+
+#else /* THPOOL_LOCK != THPOOL_LOCK_PTHREAD */
+
+#include <limits.h>
+
+#include "threads/futex.h"
+
+#if THPOOL_LOCK == THPOOL_LOCK_LMUTEX
+
+#include "threads/lmutex.h"
+
+#define THPOOL_LOCK_NAME "lmutex"
+
+typedef lmutex_t thpool_lock_t;
+typedef int thpool_lock_node_t; /* unused */
+
+static inline int _thpool_lock_init(thpool_lock_t *l) {
+	lmutex_init(l);
+	return 0;
+}
+
+static inline void _thpool_lock_destroy(thpool_lock_t *l) {
+	lmutex_destroy(l);
+}
+
+static inline void _thpool_lock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	lmutex_lock(l);
+}
+
+static inline void _thpool_unlock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	lmutex_unlock(l);
+}
+
+#elif THPOOL_LOCK == THPOOL_LOCK_TICKET
+
+#include "threads/spinlock.h"
+
+#define THPOOL_LOCK_NAME "ticket"
+
+typedef ticketlock_t thpool_lock_t;
+typedef int thpool_lock_node_t; /* unused */
+
+static inline int _thpool_lock_init(thpool_lock_t *l) {
+	ticketlock_init(l);
+	return 0;
+}
+
+static inline void _thpool_lock_destroy(thpool_lock_t *l) {
+	(void) l;
+}
+
+static inline void _thpool_lock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	ticketlock_lock(l);
+}
+
+static inline void _thpool_unlock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	(void) node;
+	ticketlock_unlock(l);
+}
+
+#elif THPOOL_LOCK == THPOOL_LOCK_MCS
+
+#include "threads/spinlock.h"
+
+#define THPOOL_LOCK_NAME "mcs"
+
+typedef mcslock_t thpool_lock_t;
+typedef mcs_node_t thpool_lock_node_t;
+
+static inline int _thpool_lock_init(thpool_lock_t *l) {
+	mcslock_init(l);
+	return 0;
+}
+
+static inline void _thpool_lock_destroy(thpool_lock_t *l) {
+	(void) l;
+}
+
+static inline void _thpool_lock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	mcslock_lock(l, node);
+}
+
+static inline void _thpool_unlock(thpool_lock_t *l, thpool_lock_node_t *node) {
+	mcslock_unlock(l, node);
+}
+
+#else
+#error Unsupported THPOOL_LOCK
+#endif
+
+/* Futex condition, waiters is protected by queue lock */
+typedef struct thpool_cond {
+	uint32_t seq;
+	uint32_t waiters;
+} thpool_cond_t;
+
+static inline int _thpool_cond_init(thpool_cond_t *c) {
+	c->seq = 0;
+	c->waiters = 0;
+	return 0;
+}
+
+static inline void _thpool_cond_destroy(thpool_cond_t *c) {
+	(void) c;
+}
+
+static inline void _thpool_cond_wait(thpool_cond_t *c, thpool_lock_t *l, thpool_lock_node_t *node) {
+	uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+	c->waiters++;
+	_thpool_unlock(l, node);
+	futex_wait(&c->seq, seq);
+	_thpool_lock(l, node);
+	c->waiters--;
+}
+
+static inline void _thpool_cond_timed_wait(thpool_cond_t *c, thpool_lock_t *l, thpool_lock_node_t *node, uint64_t timeout_usecs) {
+	uint32_t seq = __atomic_load_n(&c->seq, __ATOMIC_RELAXED);
+	c->waiters++;
+	_thpool_unlock(l, node);
+	futex_timed_wait(&c->seq, seq, timeout_usecs);
+	_thpool_lock(l, node);
+	c->waiters--;
+}
+
+static inline void _thpool_cond_signal(thpool_cond_t *c) {
+	if (c->waiters) {
+		__atomic_add_fetch(&c->seq, 1, __ATOMIC_RELEASE);
+		futex_wake(&c->seq, 1);
+	}
+}
+
+static inline void _thpool_cond_broadcast(thpool_cond_t *c) {
+	if (c->waiters) {
+		__atomic_add_fetch(&c->seq, 1, __ATOMIC_RELEASE);
+		futex_wake(&c->seq, INT_MAX);
+	}
+}
+
+#endif /* THPOOL_LOCK */
 
 /* ========================== STRUCTURES ============================ */
 
@@ -38,9 +256,9 @@ struct thpool {
 	int shutdown;
 	int hold; /* hold task queue */
 	size_t running_count;	
-	pthread_mutex_t lock;  /* lock for enqueue/dequeue task */
-	pthread_cond_t notify; /* notify for enqueue task */
-	pthread_cond_t notify_empty;   /* notify for end tasks processing */
+	thpool_lock_t lock;  /* lock for enqueue/dequeue task */
+	thpool_cond_t notify; /* notify for enqueue task */
+	thpool_cond_t notify_empty;   /* notify for end tasks processing */
 	pthread_mutex_t lock_resize;  /* lock for resize workers */
 	pthread_t *thpool; /* thpool */
 	volatile size_t thread_count;
@@ -49,30 +267,124 @@ struct thpool {
 	volatile size_t queue_count;
 	size_t head;
 	size_t tail;
+	pool_workers_t workers; /* worker hooks and contexts */
+	/* on demand start and idle exit, protected by queue lock */
+	size_t live_count; /* started and not exited workers */
+	size_t idle_count; /* workers, waiting for task */
+	size_t min_workers;
+	uint64_t idle_timeout_usecs;
+	int spawning; /* worker start in progress */
+	pool_idle_waiter_t *idle_waiters; /* thpool_wait_async waiters, protected by queue lock */
+	/* pool memory (pool, thread array, worker slots and task queue) */
+	size_t mem_size;
+	int mem_flags;
+	int mem_owned; /* allocated by create, else caller-provided */
 };
 
+/* pool memory layout (offsets), parts are aligned to POOL_INPLACE_ALIGN */
+typedef struct thpool_layout {
+	size_t threads;
+	size_t slots;
+	size_t queue;
+	size_t size;
+} thpool_layout_t;
+
+#define THPOOL_ALIGN(size) (((size) + POOL_INPLACE_ALIGN - 1) & ~((size_t) POOL_INPLACE_ALIGN - 1))
+
+/* returns 0 or -1 on invalid sizes */
+static int _thpool_layout(thpool_layout_t *l, size_t workers, size_t queue_size) {
+	if (workers < 1 || queue_size < 1 || workers > SIZE_MAX / 4 / sizeof(pool_worker_slot_t) ||
+			queue_size > SIZE_MAX / 4 / sizeof(task_t))
+		return -1;
+	l->threads = THPOOL_ALIGN(sizeof(struct thpool));
+	l->slots = l->threads + THPOOL_ALIGN(workers * sizeof(pthread_t));
+	l->queue = l->slots + THPOOL_ALIGN(workers * sizeof(pool_worker_slot_t));
+	l->size = l->queue + queue_size * sizeof(task_t);
+	return 0;
+}
+
 /* ========================== THREADPOOL ============================ */
 
 static void* _thpool_worker(void* _pool);
 
+/*
+ * Check if new worker is needed (queue lock must be held): queued tasks are more than idle workers.
+ * Checked by submitter and by worker, which take task, so queue is served, if all live workers are busy
+ * (for example, in task waiting for task it submitted).
+ * Returns reserved worker slot index + 1 (or 0).
+ */
+static inline size_t _thpool_spawn_check(thpool_t pool) {
+	size_t i;
+	if (pool->live_count == pool->thread_count || pool->spawning || pool->queue_count <= pool->idle_count ||
+			__atomic_load_n(&pool->shutdown, __ATOMIC_ACQUIRE))
+		return 0;
+	for (i = 0; i < pool->thread_count; i++) {
+		if (!pool->workers.slots[i].live) {
+			pool->workers.slots[i].live = 1;
+			pool->live_count++;
+			pool->spawning = 1;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+/* start worker in reserved slot (without queue lock) */
+static void _thpool_spawn(thpool_t pool, size_t i) {
+	thpool_lock_node_t node;
+	int err;
+	/* reap exited worker */
+	if (pool->thpool[i]) {
+		pthread_join(pool->thpool[i], NULL);
+		pool->thpool[i] = 0;
+	}
+	err = pool_worker_create(&pool->workers, i, &pool->thpool[i], _thpool_worker);
+	_thpool_lock(&(pool->lock), &node);
+	if (err) {
+		pool->thpool[i] = 0;
+		pool->workers.slots[i].live = 0;
+		pool->live_count--;
+	}
+	pool->spawning = 0;
+	_thpool_unlock(&(pool->lock), &node);
+}
+
 /* ========================== THREADPOOL ============================ */
 
 thpool_t thpool_create(size_t workers, size_t queue_size) {
-	int err;
-	size_t i;
-	thpool_t pool;
+	pool_attr_t attr;
+	pool_attr_init(&attr, workers, queue_size);
+	return thpool_create_ex(&attr);
+}
 
-	if (workers < 1 || queue_size < 1) {
-		errno = EINVAL;
+thpool_t thpool_create_hooks(size_t workers, size_t queue_size, pool_worker_init_t worker_init, pool_worker_fini_t worker_fini) {
+	pool_attr_t attr;
+	pool_attr_init(&attr, workers, queue_size);
+	attr.worker_init = worker_init;
+	attr.worker_fini = worker_fini;
+	return thpool_create_ex(&attr);
+}
+
+/* init pool in memory with layout */
+static thpool_t _thpool_init(char *mem, const thpool_layout_t *l, const pool_attr_t *attr, int owned) {
+	int err;
+	size_t i, workers = attr->workers;
+	thpool_t pool = (thpool_t) mem;
+
+	/* task queue is touched only on prefault */
+	memset(mem, 0, l->queue);
+	if ((err = pool_mem_prepare(mem, l->size, attr->mem_flags)) != 0) {
+		if (owned)
+			pool_mem_free(mem, l->size, attr->mem_flags);
+		errno = err;
 		return NULL;
 	}
-	/* allocate new pool */
-	pool = (thpool_t) malloc(sizeof(struct thpool)); 
-	if (pool == NULL)
-		goto ERROR_ERRNO;
+	pool->mem_size = l->size;
+	pool->mem_flags = attr->mem_flags;
+	pool->mem_owned = owned;
 
 	/* Pool settings */
-	pool->queue_size = queue_size;
+	pool->queue_size = attr->queue_size;
 	pool->queue_count = 0;
 	pool->thread_count = workers;
 
@@ -81,15 +393,15 @@ thpool_t thpool_create(size_t workers, size_t queue_size) {
 
 	pool->running_count = 0;
 	pool->hold = 0;
-	/* allocate thread array */
-	pool->thpool = (pthread_t*) malloc(sizeof(pthread_t) * (size_t) pool->thread_count);
-	/* allocate task queue */
-	pool->task_queue = (task_t*) malloc(sizeof(task_t) * (size_t) pool->queue_size);
-
-	if (pool->thpool == NULL || pool->task_queue == NULL) {
-		err = ENOMEM;
-		goto ERROR;
-	}
+	pool->min_workers = attr->min_workers < workers ? attr->min_workers : workers;
+	pool->idle_timeout_usecs = attr->idle_timeout_usecs;
+	pool->live_count = pool->min_workers;
+	pool->idle_count = 0;
+	pool->spawning = 0;
+	pool->idle_waiters = NULL;
+	/* thread array and task queue */
+	pool->thpool = (pthread_t*) (mem + l->threads);
+	pool->task_queue = (task_t*) (mem + l->queue);
 
 	pool->shutdown = 0;
 
@@ -97,40 +409,97 @@ thpool_t thpool_create(size_t workers, size_t queue_size) {
 		pool->thpool[i] = 0;
 	}
 
-	/* initialise mutexes */
-	if ((err = pthread_mutex_init(&(pool->lock), NULL)) != 0) {
-		goto ERROR;
+	/* initialise mutexes (before any step, which can fail, thpool_destroy expect them) */
+	if ((err = _thpool_lock_init(&(pool->lock))) != 0) {
+		goto ERR_MEM;
 	}
-	if ((err = pthread_cond_init(&(pool->notify), NULL)) != 0) {
-		goto ERROR;
+	if ((err = _thpool_cond_init(&(pool->notify))) != 0) {
+		goto ERR_LOCK;
 	}
-	if ((err = pthread_cond_init(&(pool->notify_empty), NULL)) != 0) {
-		goto ERROR;
+	if ((err = _thpool_cond_init(&(pool->notify_empty))) != 0) {
+		goto ERR_NOTIFY;
 	}
-	/* instantiate worker thpool */
-	for (i = 0; i < (pool->thread_count); i++) {
-		if ((err = pthread_create(&pool->thpool[i], NULL, _thpool_worker, (void *) pool))) {
-			goto ERROR_ERRNO;
+	if ((err = pool_workers_init(&pool->workers, pool, attr, "thp", (pool_worker_slot_t *) (mem + l->slots))) != 0) {
+		goto ERR_NOTIFY_EMPTY;
+	}
+	/* instantiate worker thpool (other are started on demand) */
+	for (i = 0; i < pool->min_workers; i++) {
+		pool->workers.slots[i].live = 1;
+		if ((err = pool_worker_create(&pool->workers, i, &pool->thpool[i], _thpool_worker)) != 0) {
+			goto ERROR;
 		}
 	}
+	if ((err = pool_workers_wait(&pool->workers)) != 0) {
+		goto ERROR;
+	}
 
 	return pool;
 
-ERROR_ERRNO:
-	err = errno;
 ERROR:
-	if (pool) {
-		thpool_destroy(pool);
-	}
+	/* all initialized, started workers are joined */
+	thpool_destroy(pool);
+	errno = err;
+	return NULL;
+
+ERR_NOTIFY_EMPTY:
+	_thpool_cond_destroy(&(pool->notify_empty));
+ERR_NOTIFY:
+	_thpool_cond_destroy(&(pool->notify));
+ERR_LOCK:
+	_thpool_lock_destroy(&(pool->lock));
+ERR_MEM:
+	pool_mem_release(pool, pool->mem_size, pool->mem_flags);
+	if (owned)
+		pool_mem_free(pool, pool->mem_size, pool->mem_flags);
 	errno = err;
 	return NULL;
 }
 
+thpool_t thpool_create_ex(const pool_attr_t *attr) {
+	thpool_layout_t l;
+	char *mem;
+
+	if (_thpool_layout(&l, attr->workers, attr->queue_size) != 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+	/* pool, thread array, slots and task queue are allocated at once */
+	if ((mem = (char *) pool_mem_alloc(l.size, attr->mem_flags)) == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	return _thpool_init(mem, &l, attr, 1);
+}
+
+size_t thpool_inplace_size(const pool_attr_t *attr) {
+	thpool_layout_t l;
+	if (_thpool_layout(&l, attr->workers, attr->queue_size) != 0) {
+		errno = EINVAL;
+		return 0;
+	}
+	return l.size;
+}
+
+thpool_t thpool_init_inplace(void *mem, size_t size, const pool_attr_t *attr) {
+	thpool_layout_t l;
+	if (mem == NULL || (uintptr_t) mem % POOL_INPLACE_ALIGN != 0 ||
+			_thpool_layout(&l, attr->workers, attr->queue_size) != 0 || size < l.size) {
+		errno = EINVAL;
+		return NULL;
+	}
+	return _thpool_init((char *) mem, &l, attr, 0);
+}
+
+void thpool_set_arena_idle(thpool_t pool, uint64_t usecs) {
+	pool_workers_set_arena_idle(&pool->workers, usecs);
+}
+
 size_t thpool_workers_count(thpool_t pool) {
 	size_t thread_count;
-	pthread_mutex_lock(&(pool->lock));
+	thpool_lock_node_t node;
+	_thpool_lock(&(pool->lock), &node);
 	thread_count = pool->thread_count;
-	pthread_mutex_unlock(&(pool->lock));
+	_thpool_unlock(&(pool->lock), &node);
 	return thread_count;
 }
 
@@ -138,13 +507,15 @@ int thpool_add_task(thpool_t pool, void (*function)(void *), void* arg) {
 
 	/* set up task */
 	task_t task;
+	thpool_lock_node_t node;
+	size_t spawn;
 	task.function = function;
 	task.arg = arg;
 
-	pthread_mutex_lock(&(pool->lock)); /* enter critical section */
+	_thpool_lock(&(pool->lock), &node); /* enter critical section */
 
 	if (pool->queue_count == pool->queue_size) {
-		pthread_mutex_unlock(&(pool->lock)); /* release lock */
+		_thpool_unlock(&(pool->lock), &node); /* release lock */
 		sched_yield();
 		return -1;
 	}
@@ -153,8 +524,12 @@ int thpool_add_task(thpool_t pool, void (*function)(void *), void* arg) {
 	pool->tail = (pool->tail + 1) % pool->queue_size; /* advance end of queue */
 	pool->queue_count++; /* job added to queue */
 
-	pthread_cond_signal(&(pool->notify)); /* notify waiting workers of new job */
-	pthread_mutex_unlock(&(pool->lock)); /* end critical section */
+	_thpool_cond_signal(&(pool->notify)); /* notify waiting workers of new job */
+	spawn = _thpool_spawn_check(pool);
+	_thpool_unlock(&(pool->lock), &node); /* end critical section */
+
+	if (spawn)
+		_thpool_spawn(pool, spawn - 1);
 
 	return 0;
 }
@@ -162,6 +537,8 @@ int thpool_add_task(thpool_t pool, void (*function)(void *), void* arg) {
 int thpool_add_task_try(thpool_t pool, void (*function)(void *), void* arg, useconds_t usec, int max_try) {
 	/* set up task */
 	task_t task;
+	thpool_lock_node_t node;
+	size_t spawn;
 	task.function = function;
 	task.arg = arg;
 
@@ -170,9 +547,9 @@ int thpool_add_task_try(thpool_t pool, void (*function)(void *), void* arg, usec
 			errno = EAGAIN;
 			return -1;
 		}
-		pthread_mutex_lock(&(pool->lock)); /* enter critical section */
+		_thpool_lock(&(pool->lock), &node); /* enter critical section */
 		if (pool->queue_count == pool->queue_size) {
-			pthread_mutex_unlock(&(pool->lock)); /* release lock */
+			_thpool_unlock(&(pool->lock), &node); /* release lock */
 			sched_yield();
 			usleep(usec);
 		} else {
@@ -180,8 +557,11 @@ int thpool_add_task_try(thpool_t pool, void (*function)(void *), void* arg, usec
 			pool->tail = (pool->tail + 1) % pool->queue_size; /* advance end of queue */
 			pool->queue_count++; /* job added to queue */
 
-			pthread_cond_signal(&(pool->notify)); /* notify waiting workers of new job */
-			pthread_mutex_unlock(&(pool->lock)); /* end critical section */
+			_thpool_cond_signal(&(pool->notify)); /* notify waiting workers of new job */
+			spawn = _thpool_spawn_check(pool);
+			_thpool_unlock(&(pool->lock), &node); /* end critical section */
+			if (spawn)
+				_thpool_spawn(pool, spawn - 1);
 			break;
 		}
 	}
@@ -194,10 +574,11 @@ void thpool_pause(thpool_t pool) {
 }
 
 void thpool_resume(thpool_t pool) {
+	thpool_lock_node_t node;
 	__atomic_store_n(&(pool->hold), 0, __ATOMIC_RELEASE);
-	pthread_mutex_lock(&(pool->lock));
-	pthread_cond_signal(&(pool->notify));
-	pthread_mutex_unlock(&(pool->lock));
+	_thpool_lock(&(pool->lock), &node);
+	_thpool_cond_signal(&(pool->notify));
+	_thpool_unlock(&(pool->lock), &node);
 }
 
 size_t thpool_active_tasks(thpool_t pool) {
@@ -206,65 +587,96 @@ size_t thpool_active_tasks(thpool_t pool) {
 
 size_t thpool_total_tasks(thpool_t pool) {
 	size_t count;
+	thpool_lock_node_t node;
 
-	pthread_mutex_lock(&(pool->lock));
+	_thpool_lock(&(pool->lock), &node);
 	count = __atomic_add_fetch(&pool->running_count, 0, __ATOMIC_RELAXED) + pool->queue_count;
-	pthread_mutex_unlock(&(pool->lock));
+	_thpool_unlock(&(pool->lock), &node);
 
 	return count;
 }
 
 void thpool_wait(thpool_t pool) {
 	size_t queue_count, active_count;
+	thpool_lock_node_t node;
 	while (1) {		
-		pthread_mutex_lock(&(pool->lock));
+		_thpool_lock(&(pool->lock), &node);
 		queue_count = pool->queue_count;
 		active_count = thpool_active_tasks(pool);
 		if (queue_count == 0 && active_count == 0) {
-			pthread_mutex_unlock(&(pool->lock));
+			_thpool_unlock(&(pool->lock), &node);
 			return;
 		}
-		pthread_cond_wait(&(pool->notify_empty), &(pool->lock));
-		pthread_mutex_unlock(&(pool->lock));
+		_thpool_cond_wait(&(pool->notify_empty), &(pool->lock), &node);
+		_thpool_unlock(&(pool->lock), &node);
 	}
 }
 
+int thpool_wait_async(thpool_t pool, pool_idle_waiter_t *w) {
+	thpool_lock_node_t node;
+	_thpool_lock(&(pool->lock), &node);
+	if (pool->queue_count == 0 && thpool_active_tasks(pool) == 0) {
+		_thpool_unlock(&(pool->lock), &node);
+		return 0;
+	}
+	w->next = pool->idle_waiters;
+	pool->idle_waiters = w;
+	_thpool_unlock(&(pool->lock), &node);
+	return 1;
+}
+
 void thpool_shutdown(thpool_t pool) {
 	size_t i;
+	thpool_lock_node_t node;
 	__atomic_store_n(&pool->shutdown, 1, __ATOMIC_RELEASE);
-	pthread_mutex_lock(&(pool->lock));
-	pthread_cond_broadcast(&(pool->notify));
-	pthread_mutex_unlock(&(pool->lock));
-	for (i = 0; i < pool->thread_count; i++) {
-		pthread_join(pool->thpool[i], NULL);
+	_thpool_lock(&(pool->lock), &node);
+	/* wait for worker start in progress (no new starts after shutdown) */
+	while (pool->spawning) {
+		_thpool_unlock(&(pool->lock), &node);
+		sched_yield();
+		_thpool_lock(&(pool->lock), &node);
+	}
+	_thpool_cond_broadcast(&(pool->notify));
+	_thpool_unlock(&(pool->lock), &node);
+	for (i = 0; pool->thpool && i < pool->thread_count; i++) {
+		if (pool->thpool[i]) {
+			pthread_join(pool->thpool[i], NULL);
+			pool->thpool[i] = 0;
+		}
 	}
 }
 
+const char *thpool_lock_name(void) {
+	return THPOOL_LOCK_NAME;
+}
+
 void thpool_destroy(thpool_t pool) {
 	if (pool) {
 		thpool_shutdown(pool);
-		free(pool->thpool);
-		free(pool->task_queue);
-		pthread_cond_destroy(&(pool->notify));
-		pthread_cond_destroy(&(pool->notify_empty));
-		pthread_mutex_destroy(&(pool->lock));
-		free(pool);
+		_thpool_cond_destroy(&(pool->notify));
+		_thpool_cond_destroy(&(pool->notify_empty));
+		_thpool_lock_destroy(&(pool->lock));
+		pool_workers_destroy(&pool->workers);
+		pool_mem_release(pool, pool->mem_size, pool->mem_flags);
+		if (pool->mem_owned)
+			pool_mem_free(pool, pool->mem_size, pool->mem_flags);
 	}
 }
 
 int thpool_worker_try_once(thpool_t pool) {
 	task_t task;
+	thpool_lock_node_t node;
 
 	/*
 	* take lock. thread is blocked if not possible to take, that's fine.
 	* need the lock in order to wait on condition. don't want condition
 	* being changed.
 	*/
-	pthread_mutex_lock(&(pool->lock));
+	_thpool_lock(&(pool->lock), &node);
 
 	/* wait for notification of new task when pool is empty */
 	if (pool->queue_count == 0) {
-		pthread_mutex_unlock(&(pool->lock));
+		_thpool_unlock(&(pool->lock), &node);
 		return -1;
 	}
 
@@ -282,7 +694,7 @@ int thpool_worker_try_once(thpool_t pool) {
 	pool->queue_count--; /* removed a task from queue */
 
 	/* end critical section */
-	pthread_mutex_unlock(&(pool->lock));
+	_thpool_unlock(&(pool->lock), &node);
 
 	/* execute task*/
 	(*task.function)(task.arg);
@@ -294,25 +706,54 @@ int thpool_worker_try_once(thpool_t pool) {
 
 /* pool background worker */
 static void* _thpool_worker(void* p) {
-	thpool_t pool = (thpool_t) p;
+	pool_worker_slot_t *slot = (pool_worker_slot_t *) p;
+	thpool_t pool = (thpool_t) slot->pool;
 	task_t task;
-
+	thpool_lock_node_t node;
+	uint64_t idle_usecs, idle_start, now;
+	size_t spawn;
+	/* started on demand (not waited by create) */
+	int on_demand = !slot->notify_start;
+	/* tasks can read ebr_default() protected objects without critical sections */
+	ebr_t smr = ebr_default();
+
+	if (pool_worker_start(slot) != 0 && on_demand) {
+		/* no create to fail with worker_init error, so just release slot */
+		_thpool_lock(&(pool->lock), &node);
+		slot->live = 0;
+		pool->live_count--;
+		_thpool_unlock(&(pool->lock), &node);
+		goto EXIT;
+	}
+	ebr_online(smr);
 	while (1) {
 		/*
 		* take lock. thread is blocked if not possible to take, that's fine.
 		* need the lock in order to wait on condition. don't want condition
 		* being changed.
 		*/
-		pthread_mutex_lock(&(pool->lock));
+		_thpool_lock(&(pool->lock), &node);
 
 		/* wait for notification of new task when pool is empty */
+		idle_start = 0;
 		while(pool->queue_count == 0) {
 			if (thpool_active_tasks(pool) == 0) {
-				pthread_cond_signal(&(pool->notify_empty)); /* notify when empty */
+				_thpool_cond_signal(&(pool->notify_empty)); /* notify when empty */
+				if (pool->idle_waiters) {
+					/* wake async waiters without lock (wake can add tasks) */
+					pool_idle_waiter_t *w = pool->idle_waiters;
+					pool->idle_waiters = NULL;
+					_thpool_unlock(&(pool->lock), &node);
+					pool_idle_wake(w, NULL);
+					_thpool_lock(&(pool->lock), &node);
+					continue;
+				}
 			}
 			/* check shutdown flag */
 			if (__atomic_add_fetch(&pool->shutdown, 0, __ATOMIC_ACQUIRE) == 1) {
-				pthread_mutex_unlock(&(pool->lock));
+				_thpool_unlock(&(pool->lock), &node);
+				ebr_offline(smr);
+				pool_worker_stop(slot);
 				return NULL;
 			}
 			/*
@@ -321,11 +762,37 @@ static void* _thpool_worker(void* p) {
 			* also be waiting. lock is retained upon notification
 			* no more busy waiting!
 			*/
-			pthread_cond_wait(&(pool->notify), &(pool->lock));
+			ebr_offline(smr);
+			/* wake up for shrink arena after idle interval */
+			idle_usecs = pool_worker_idle(slot);
+			if (pool->idle_timeout_usecs && pool->live_count > pool->min_workers) {
+				/* exit after idle timeout */
+				now = deadline_now();
+				if (idle_start == 0) {
+					idle_start = now;
+				} else if (now - idle_start >= pool->idle_timeout_usecs) {
+					/* slot can be reused, thread is joined by next worker in slot or by shutdown */
+					slot->live = 0;
+					pool->live_count--;
+					_thpool_unlock(&(pool->lock), &node);
+					goto EXIT;
+				}
+				now = idle_start + pool->idle_timeout_usecs - now;
+				if (idle_usecs == 0 || now < idle_usecs)
+					idle_usecs = now;
+			}
+			pool->idle_count++;
+			if (idle_usecs != 0) {
+				_thpool_cond_timed_wait(&(pool->notify), &(pool->lock), &node, idle_usecs);
+			} else {
+				_thpool_cond_wait(&(pool->notify), &(pool->lock), &node);
+			}
+			pool->idle_count--;
 		}
 		/* check thread pool hold */
 		if ( __atomic_add_fetch(&(pool->hold), 0, __ATOMIC_RELEASE)) {
-			pthread_mutex_unlock(&(pool->lock));
+			_thpool_unlock(&(pool->lock), &node);
+			ebr_offline(smr);
 			sleep(1);
 			continue;
 		}
@@ -341,16 +808,28 @@ static void* _thpool_worker(void* p) {
 		pool->head = (pool->head+1) % pool->queue_size;
 		pool->queue_count--; /* removed a task from queue */
 
+		spawn = _thpool_spawn_check(pool);
+
 		/* end critical section */
-		pthread_mutex_unlock(&(pool->lock));
+		_thpool_unlock(&(pool->lock), &node);
+
+		if (spawn)
+			_thpool_spawn(pool, spawn - 1);
 
 		/* execute task*/
+		ebr_online(smr);
 		(*task.function)(task.arg);
+		/* task don't hold references to protected objects */
+		ebr_quiescent(smr);
+		pool_worker_task_done(slot);
 
 		/* decrement active tasks count */
 		__atomic_sub_fetch(&pool->running_count, 1, __ATOMIC_RELAXED);
 	}
 
+EXIT:
+	ebr_offline(smr);
+	pool_worker_stop(slot);
 	return NULL;
 }
 